@@ -0,0 +1,51 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/arena.h"
+#include <algorithm>
+
+using namespace au;
+
+algo::Arena::Arena(const size_t block_size) : block_size(block_size)
+{
+}
+
+void *algo::Arena::allocate(const size_t size, const size_t alignment)
+{
+    auto padding = (alignment - reinterpret_cast<uintptr_t>(block_ptr))
+        & (alignment - 1);
+    if (padding + size > block_left)
+    {
+        // oversized requests get a block of their own
+        const auto new_block_size = std::max(block_size, size + alignment);
+        blocks.push_back(std::unique_ptr<u8[]>(new u8[new_block_size]));
+        reserved_size += new_block_size;
+        block_ptr = blocks.back().get();
+        block_left = new_block_size;
+        padding = (alignment - reinterpret_cast<uintptr_t>(block_ptr))
+            & (alignment - 1);
+    }
+    const auto ptr = block_ptr + padding;
+    block_ptr += padding + size;
+    block_left -= padding + size;
+    return ptr;
+}
+
+size_t algo::Arena::get_reserved_size() const
+{
+    return reserved_size;
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "types.h"
+
+namespace au {
+namespace algo {
+
+    // Hands out memory from large blocks and releases all of it at once when
+    // destroyed. Objects placed in the arena are not destroyed by it.
+    class Arena final
+    {
+    public:
+        Arena(const size_t block_size = 64 * 1024);
+        Arena(const Arena &other) = delete;
+        Arena &operator =(const Arena &other) = delete;
+
+        void *allocate(const size_t size, const size_t alignment);
+
+        // Total size of the blocks obtained from the heap.
+        size_t get_reserved_size() const;
+
+    private:
+        const size_t block_size;
+        std::vector<std::unique_ptr<u8[]>> blocks;
+        size_t reserved_size = 0;
+        u8 *block_ptr = nullptr;
+        size_t block_left = 0;
+    };
+
+} }
@@ -16,8 +16,8 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/binary.h"
+#include "algo/crypt/repeating_key.h"
 #include "algo/range.h"
-#include "err.h"
 
 using namespace au;
 
@@ -32,10 +32,7 @@ bstr algo::unxor(const bstr &input, const u8 key)
 
 bstr algo::unxor(const bstr &input, const bstr &key)
 {
-    if (!key.size())
-        throw err::BadDataSizeError();
     bstr output(input);
-    for (const auto i : algo::range(input.size()))
-        output[i] ^= key[i % key.size()];
+    crypt::RepeatingKey(key).xor_data(output.get<u8>(), output.size());
     return output;
 }
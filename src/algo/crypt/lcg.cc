@@ -16,66 +16,166 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/crypt/lcg.h"
-#include <functional>
+#include <stdexcept>
+#include <vector>
+#include "algo/range.h"
 
 using namespace au;
 using namespace au::algo::crypt;
 
-struct Lcg::Priv final
+static const u32 minstd_modulus = 0x7FFFFFFF;
+
+namespace
 {
-    u32 seed;
-    std::function<u32(u32&)> next;
-};
+    struct MicrosoftVisualC final
+    {
+        static const u32 max_value = 0x7FFF;
+
+        static u32 next(u32 &seed)
+        {
+            return priv::next_msvc(seed);
+        }
+    };
+
+    struct ParkMiller final
+    {
+        static const u32 max_value = 0xFF;
+        static const u32 multiplier = 16807;
+
+        static u32 next(u32 &seed)
+        {
+            return priv::next_park_miller(seed);
+        }
+    };
+
+    struct ParkMillerRevised final
+    {
+        static const u32 max_value = 0xFF;
+        static const u32 multiplier = 48271;
+
+        static u32 next(u32 &seed)
+        {
+            return priv::next_park_miller_revised(seed);
+        }
+    };
+}
+
+template<typename T> static void fill_impl(
+    u32 &seed, u32 *output, const size_t count)
+{
+    for (const auto i : algo::range(count))
+        output[i] = T::next(seed);
+}
 
-static inline u32 minstd(u32 &seed, u32 a, u32 q, u32 r, u32 m)
+template<typename T> static void xor_with_key_impl(
+    u32 &seed, u8 *data, const size_t size, const bstr &key, const size_t step)
 {
-    s32 x = seed;
-    const s32 hi = x / q;
-    const s32 lo = x % q;
-    x = a * lo - r * hi;
-    if (x < 0)
-        x += m;
-    seed = x;
-    return x * 4.656612875245797e-10 * 256;
+    // For long inputs it's cheaper to resolve key[value % key.size()] once
+    // for every value next() can return than to divide for every byte.
+    if (size / step > T::max_value)
+    {
+        std::vector<u8> lookup(T::max_value + 1);
+        for (const auto i : algo::range(lookup.size()))
+            lookup[i] = key[i % key.size()];
+        for (size_t i = 0; i < size; i += step)
+            data[i] ^= lookup[T::next(seed)];
+    }
+    else
+    {
+        for (size_t i = 0; i < size; i += step)
+            data[i] ^= key[T::next(seed) % key.size()];
+    }
+}
+
+template<typename T> static void discard_minstd(u32 &seed, u64 count)
+{
+    // Schrage's method matches plain modular multiplication only for the
+    // seeds below the modulus, which is where the first step brings it.
+    while (count && seed >= minstd_modulus)
+    {
+        T::next(seed);
+        count--;
+    }
+
+    u64 multiplier = 1;
+    u64 base = T::multiplier;
+    while (count)
+    {
+        if (count & 1)
+            multiplier = multiplier * base % minstd_modulus;
+        base = base * base % minstd_modulus;
+        count >>= 1;
+    }
+    seed = seed * multiplier % minstd_modulus;
 }
 
-Lcg::Lcg(LcgKind kind, u32 seed) : p(new Priv)
+static void discard_msvc(u32 &seed, u64 count)
+{
+    // composes seed -> seed * a + c with itself by repeated squaring
+    u32 total_mul = 1, total_add = 0;
+    u32 mul = 0x343FD, add = 0x269EC3;
+    while (count)
+    {
+        if (count & 1)
+        {
+            total_mul *= mul;
+            total_add = total_add * mul + add;
+        }
+        add = add * mul + add;
+        mul *= mul;
+        count >>= 1;
+    }
+    seed = seed * total_mul + total_add;
+}
+
+Lcg::Lcg(const LcgKind kind, const u32 seed) : kind(kind), seed(seed)
+{
+    if (kind != LcgKind::MicrosoftVisualC
+        && kind != LcgKind::ParkMiller
+        && kind != LcgKind::ParkMillerRevised)
+    {
+        throw std::logic_error("Unknown LCG kind");
+    }
+}
+
+void Lcg::fill(u32 *output, const size_t count)
 {
-    p->seed = seed;
     switch (kind)
     {
         case LcgKind::MicrosoftVisualC:
-            p->next = [](u32 &seed)
-            {
-                seed = seed * 0x343FD + 0x269EC3;
-                return (seed >> 16) & 0x7FFF;
-            };
-            break;
-
+            return fill_impl<MicrosoftVisualC>(seed, output, count);
         case LcgKind::ParkMiller:
-            p->next = [](u32 &seed)
-            {
-                return minstd(seed, 16807, 127773, 2836, 2147483647);
-            };
-            break;
-
+            return fill_impl<ParkMiller>(seed, output, count);
         case LcgKind::ParkMillerRevised:
-            p->next = [](u32 &seed)
-            {
-                return minstd(seed, 48271, 44488, 3399, 2147483647);
-            };
-            break;
-
-        default:
-            throw std::logic_error("Unknown LCG kind");
+            return fill_impl<ParkMillerRevised>(seed, output, count);
     }
 }
 
-Lcg::~Lcg()
+void Lcg::discard(const u64 count)
 {
+    switch (kind)
+    {
+        case LcgKind::MicrosoftVisualC:
+            return discard_msvc(seed, count);
+        case LcgKind::ParkMiller:
+            return discard_minstd<ParkMiller>(seed, count);
+        case LcgKind::ParkMillerRevised:
+            return discard_minstd<ParkMillerRevised>(seed, count);
+    }
 }
 
-u32 Lcg::next()
+void Lcg::xor_with_key(
+    u8 *data, const size_t size, const bstr &key, const size_t step)
 {
-    return p->next(p->seed);
+    switch (kind)
+    {
+        case LcgKind::MicrosoftVisualC:
+            return xor_with_key_impl<MicrosoftVisualC>(
+                seed, data, size, key, step);
+        case LcgKind::ParkMiller:
+            return xor_with_key_impl<ParkMiller>(seed, data, size, key, step);
+        case LcgKind::ParkMillerRevised:
+            return xor_with_key_impl<ParkMillerRevised>(
+                seed, data, size, key, step);
+    }
 }
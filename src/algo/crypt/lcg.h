@@ -17,7 +17,6 @@
 
 #pragma once
 
-#include <memory>
 #include "types.h"
 
 namespace au {
@@ -31,16 +30,74 @@ namespace crypt {
         ParkMillerRevised,
     };
 
+    namespace priv {
+
+        inline u32 next_msvc(u32 &seed)
+        {
+            seed = seed * 0x343FD + 0x269EC3;
+            return (seed >> 16) & 0x7FFF;
+        }
+
+        inline u32 next_minstd(
+            u32 &seed, const u32 a, const u32 q, const u32 r, const u32 m)
+        {
+            s32 x = seed;
+            const s32 hi = x / q;
+            const s32 lo = x % q;
+            x = a * lo - r * hi;
+            if (x < 0)
+                x += m;
+            seed = x;
+            return x * 4.656612875245797e-10 * 256;
+        }
+
+        inline u32 next_park_miller(u32 &seed)
+        {
+            return next_minstd(seed, 16807, 127773, 2836, 0x7FFFFFFF);
+        }
+
+        inline u32 next_park_miller_revised(u32 &seed)
+        {
+            return next_minstd(seed, 48271, 44488, 3399, 0x7FFFFFFF);
+        }
+
+    }
+
     class Lcg final
     {
     public:
-        Lcg(LcgKind kind, u32 seed);
-        ~Lcg();
+        Lcg(const LcgKind kind, const u32 seed);
+
         u32 next();
 
+        // Same as calling next() count times, only faster.
+        void fill(u32 *output, const size_t count);
+
+        // Advances the state as if next() was called count times, in
+        // O(log count).
+        void discard(u64 count);
+
+        // For every step-th byte, does data[i] ^= key[next() % key.size()].
+        void xor_with_key(
+            u8 *data, const size_t size, const bstr &key, const size_t step = 1);
+
     private:
-        struct Priv;
-        std::unique_ptr<Priv> p;
+        LcgKind kind;
+        u32 seed;
     };
 
+    inline u32 Lcg::next()
+    {
+        switch (kind)
+        {
+            case LcgKind::MicrosoftVisualC:
+                return priv::next_msvc(seed);
+            case LcgKind::ParkMiller:
+                return priv::next_park_miller(seed);
+            case LcgKind::ParkMillerRevised:
+                return priv::next_park_miller_revised(seed);
+        }
+        return 0;
+    }
+
 } } }
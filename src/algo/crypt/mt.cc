@@ -1,4 +1,3 @@
-// Copyright (C) 1997 by Makoto Matsumoto and Takuji Nishimura
 // Copyright (C) 2016 by rr-
 //
 // This file is part of arc_unpacker.
@@ -17,94 +16,96 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/crypt/mt.h"
+#include <algorithm>
 #include <array>
 #include "algo/range.h"
 
 using namespace au;
 using namespace au::algo::crypt;
 
-static const auto n = 624;
-static const auto m = 397;
-static const auto matrix_a = 0x9908B0DF;
-static const auto upper_mask = 0x80000000;
-static const auto lower_mask = 0x7FFFFFFF;
+static const size_t n = 624;
+static const size_t m = 397;
+static const u32 matrix_a = 0x9908B0DF;
+static const u32 upper_mask = 0x80000000;
+static const u32 lower_mask = 0x7FFFFFFF;
 
-static const auto tempering_mask_b = 0x9D2C5680;
-static const auto tempering_mask_c = 0xEFC60000;
-
-static u32 tempering_shift_u(const u32 y) { return y >> 11; }
-static u32 tempering_shift_s(const u32 y) { return y << 7; }
-static u32 tempering_shift_t(const u32 y) { return y << 15; }
-static u32 tempering_shift_l(const u32 y) { return y >> 18; }
+static const u32 tempering_mask_b = 0x9D2C5680;
+static const u32 tempering_mask_c = 0xEFC60000;
 
 struct MersenneTwister::Priv final
 {
-    std::function<void(Priv*, const u32)> seed_func;
+    void regenerate();
 
-    u32 default_seed;
     std::array<u32, n> mt;
     size_t mti;
 };
 
+static inline u32 twist(const u32 current, const u32 next, const u32 other)
+{
+    const u32 y = (current & upper_mask) | (next & lower_mask);
+    return other ^ (y >> 1) ^ ((0 - (y & 1)) & matrix_a);
+}
+
+static inline u32 temper(u32 y)
+{
+    y ^= y >> 11;
+    y ^= (y << 7) & tempering_mask_b;
+    y ^= (y << 15) & tempering_mask_c;
+    y ^= y >> 18;
+    return y;
+}
+
+// The loops are branchless and each reads values at least 227 positions
+// away from the one it writes, so the compiler is free to vectorize them.
+void MersenneTwister::Priv::regenerate()
+{
+    for (const auto kk : algo::range(n - m))
+        mt[kk] = twist(mt[kk], mt[kk + 1], mt[kk + m]);
+    for (const auto kk : algo::range(n - m, n - 1))
+        mt[kk] = twist(mt[kk], mt[kk + 1], mt[kk + m - n]);
+    mt[n - 1] = twist(mt[n - 1], mt[0], mt[m - 1]);
+    mti = 0;
+}
+
 std::unique_ptr<MersenneTwister> MersenneTwister::Knuth(const u32 seed)
 {
-    auto ret = std::unique_ptr<MersenneTwister>(new MersenneTwister(
-        [](Priv *p, u32 seed)
-        {
-            p->mt[0] = seed & 0xFFFFFFFF;
-            for (p->mti = 1; p->mti < n; p->mti++)
-                p->mt[p->mti] = (69069 * p->mt[p->mti - 1]) & 0xFFFFFFFF;
-        },
-        4357));
-    ret->p->seed_func(ret->p.get(), seed);
+    auto ret = std::unique_ptr<MersenneTwister>(new MersenneTwister());
+    auto &mt = ret->p->mt;
+    mt[0] = seed;
+    for (const auto i : algo::range(1, n))
+        mt[i] = 69069 * mt[i - 1];
+    ret->p->mti = n;
     return ret;
 }
 
-std::unique_ptr<MersenneTwister> MersenneTwister::Classic(const u32 seed)
+std::unique_ptr<MersenneTwister> MersenneTwister::Classic(u32 seed)
 {
-    auto ret = std::unique_ptr<MersenneTwister>(new MersenneTwister(
-        [](Priv *p, u32 seed)
-        {
-            for (const auto i : algo::range(n))
-            {
-                p->mt[i] = seed & 0xFFFF0000;
-                seed = 69069 * seed + 1;
-                p->mt[i] |= (seed & 0xFFFF0000) >> 16;
-                seed = 69069 * seed + 1;
-            }
-            p->mti = n;
-        },
-        4357));
-    ret->p->seed_func(ret->p.get(), seed);
+    auto ret = std::unique_ptr<MersenneTwister>(new MersenneTwister());
+    auto &mt = ret->p->mt;
+    for (const auto i : algo::range(n))
+    {
+        mt[i] = seed & 0xFFFF0000;
+        seed = 69069 * seed + 1;
+        mt[i] |= (seed & 0xFFFF0000) >> 16;
+        seed = 69069 * seed + 1;
+    }
+    ret->p->mti = n;
     return ret;
 }
 
 std::unique_ptr<MersenneTwister> MersenneTwister::Improved(const u32 seed)
 {
-    auto ret = std::unique_ptr<MersenneTwister>(new MersenneTwister(
-        [](Priv *p, u32 seed)
-        {
-            p->mt[0] = seed & 0xFFFFFFFFul;
-            for (p->mti = 1; p->mti < n; p->mti++)
-            {
-                p->mt[p->mti] = p->mt[p->mti - 1];
-                p->mt[p->mti] ^= (p->mt[p->mti - 1] >> 30);
-                p->mt[p->mti] = (1812433253ul * p->mt[p->mti] + p->mti);
-                p->mt[p->mti] &= 0xFFFFFFFFul;
-            }
-        },
-        5489ul));
-    ret->p->seed_func(ret->p.get(), seed);
+    auto ret = std::unique_ptr<MersenneTwister>(new MersenneTwister());
+    auto &mt = ret->p->mt;
+    mt[0] = seed;
+    for (const auto i : algo::range(1, n))
+        mt[i] = 1812433253 * (mt[i - 1] ^ (mt[i - 1] >> 30)) + i;
+    ret->p->mti = n;
     return ret;
 }
 
-MersenneTwister::MersenneTwister(
-    const std::function<void(Priv*, const u32)> seed_func,
-    const u32 default_seed)
-    : p(new Priv())
+MersenneTwister::MersenneTwister() : p(new Priv())
 {
-    p->seed_func = seed_func;
-    p->default_seed = default_seed;
 }
 
 MersenneTwister::~MersenneTwister()
@@ -113,38 +114,39 @@ MersenneTwister::~MersenneTwister()
 
 u32 MersenneTwister::next_u32()
 {
-    u32 y;
-    static const u32 mag01[2] = {0x0, matrix_a};
-
     if (p->mti >= n)
-    {
-        int kk;
-
-        if (p->mti == n + 1)
-            p->seed_func(p.get(), p->default_seed);
-
-        for (kk = 0; kk < n - m; kk++)
-        {
-            y = (p->mt[kk] & upper_mask) | (p->mt[kk + 1] & lower_mask);
-            p->mt[kk] = p->mt[kk + m] ^ (y >> 1) ^ mag01[y & 0x1];
-        }
-
-        for (; kk < n - 1; kk++)
-        {
-            y = (p->mt[kk] & upper_mask) | (p->mt[kk + 1] & lower_mask);
-            p->mt[kk] = p->mt[kk + (m - n)] ^ (y >> 1) ^ mag01[y & 0x1];
-        }
-
-        y = (p->mt[n - 1] & upper_mask) | (p->mt[0] & lower_mask);
-        p->mt[n - 1] = p->mt[m - 1] ^ (y >> 1) ^ mag01[y & 0x1];
+        p->regenerate();
+    return temper(p->mt[p->mti++]);
+}
 
-        p->mti = 0;
+void MersenneTwister::fill(u32 *output, size_t count)
+{
+    while (count)
+    {
+        if (p->mti >= n)
+            p->regenerate();
+        const auto chunk = std::min(count, n - p->mti);
+        const auto *input = &p->mt[p->mti];
+        for (const auto i : algo::range(chunk))
+            output[i] = temper(input[i]);
+        p->mti += chunk;
+        output += chunk;
+        count -= chunk;
     }
+}
 
-    y = p->mt[p->mti++];
-    y ^= tempering_shift_u(y);
-    y ^= tempering_shift_s(y) & tempering_mask_b;
-    y ^= tempering_shift_t(y) & tempering_mask_c;
-    y ^= tempering_shift_l(y);
-    return y;
+void MersenneTwister::xor_bytes(u8 *data, size_t size)
+{
+    while (size)
+    {
+        if (p->mti >= n)
+            p->regenerate();
+        const auto chunk = std::min(size, n - p->mti);
+        const auto *input = &p->mt[p->mti];
+        for (const auto i : algo::range(chunk))
+            data[i] ^= temper(input[i]);
+        p->mti += chunk;
+        data += chunk;
+        size -= chunk;
+    }
 }
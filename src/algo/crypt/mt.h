@@ -17,8 +17,6 @@
 
 #pragma once
 
-#include <array>
-#include <functional>
 #include <memory>
 #include "types.h"
 
@@ -37,11 +35,15 @@ namespace crypt {
 
         u32 next_u32();
 
+        // Same as calling next_u32() count times, only faster.
+        void fill(u32 *output, const size_t count);
+
+        // XORs each byte with the lowest byte of the next number.
+        void xor_bytes(u8 *data, const size_t size);
+
     private:
         struct Priv;
-        MersenneTwister(
-            const std::function<void(Priv*, const u32)> seed_func,
-            const u32 default_seed);
+        MersenneTwister();
         std::unique_ptr<Priv> p;
     };
 
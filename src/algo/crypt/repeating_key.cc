@@ -0,0 +1,123 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/crypt/repeating_key.h"
+#include <cstring>
+#include "algo/endian.h"
+#include "algo/range.h"
+#include "err.h"
+
+using namespace au;
+using namespace au::algo::crypt;
+
+static const u64 high_bits = 0x8080808080808080;
+
+static inline u64 load(const u8 *ptr)
+{
+    u64 value;
+    std::memcpy(&value, ptr, 8);
+    return algo::from_little_endian(value);
+}
+
+static inline void store(u8 *ptr, u64 value)
+{
+    value = algo::to_little_endian(value);
+    std::memcpy(ptr, &value, 8);
+}
+
+// Byte-wise subtraction with no carries between the lanes.
+static inline u64 sub_bytes(const u64 a, const u64 b)
+{
+    return ((a | high_bits) - (b & ~high_bits)) ^ ((a ^ ~b) & high_bits);
+}
+
+RepeatingKey::RepeatingKey(const bstr &key) : key_size(key.size())
+{
+    if (!key_size)
+        throw err::BadDataSizeError();
+    // Smallest multiple of the key size that is also a multiple of 8, plus
+    // one word of wraparound so that loads from any offset stay in bounds.
+    period_size = key_size;
+    while (period_size % 8)
+        period_size += key_size;
+    period.resize(period_size + 8);
+    for (const auto i : algo::range(period.size()))
+        period[i] = key[i % key_size];
+}
+
+void RepeatingKey::xor_data(
+    u8 *data, const size_t size, const size_t key_offset) const
+{
+    const auto key = period.get<const u8>();
+    size_t pos = key_offset % period_size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        store(data + i, load(data + i) ^ load(key + pos));
+        pos += 8;
+        if (pos >= period_size)
+            pos -= period_size;
+    }
+    for (; i < size; i++)
+        data[i] ^= key[pos++];
+}
+
+void RepeatingKey::sub_data(u8 *data, const size_t size) const
+{
+    const auto key = period.get<const u8>();
+    size_t pos = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        store(data + i, sub_bytes(load(data + i), load(key + pos)));
+        pos += 8;
+        if (pos >= period_size)
+            pos -= period_size;
+    }
+    for (; i < size; i++)
+        data[i] -= key[pos++];
+}
+
+void RepeatingKey::xor_data_with_feedback(
+    u8 *data, const size_t size, const bstr &iv) const
+{
+    if (iv.size() < 4)
+        throw err::BadDataSizeError();
+    const auto key = period.get<const u8>();
+
+    // Every output byte depends on the input only, so each word can be
+    // decrypted at once given the four input bytes that came before it.
+    u64 prev = iv[0] | (iv[1] << 8) | (iv[2] << 16)
+        | (static_cast<u32>(iv[3]) << 24);
+    size_t pos = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        const auto input = load(data + i);
+        store(data + i, input ^ load(key + pos) ^ (input << 32) ^ prev);
+        prev = input >> 32;
+        pos += 8;
+        if (pos >= period_size)
+            pos -= period_size;
+    }
+    for (; i < size; i++)
+    {
+        const auto input = data[i];
+        data[i] = input ^ key[pos++] ^ (prev & 0xFF);
+        prev = (prev >> 8) | (static_cast<u32>(input) << 24);
+    }
+}
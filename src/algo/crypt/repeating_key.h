@@ -0,0 +1,54 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace crypt {
+
+    // Applies a short key cyclically over the data, the way most archive
+    // ciphers do with data[i] ^= key[i % key.size()]. The key is unrolled
+    // to a multiple of the machine word up front, so that the data can be
+    // processed eight bytes at a time without dividing for every byte.
+    class RepeatingKey final
+    {
+    public:
+        RepeatingKey(const bstr &key);
+
+        // data[i] ^= key[(i + key_offset) % key.size()]
+        void xor_data(
+            u8 *data, const size_t size, const size_t key_offset = 0) const;
+
+        // data[i] -= key[i % key.size()]
+        void sub_data(u8 *data, const size_t size) const;
+
+        // data[i] ^= key[i % key.size()] ^ c[i - 4], where c is the data
+        // before decryption and the four bytes preceding it are taken from
+        // the low bytes of iv.
+        void xor_data_with_feedback(
+            u8 *data, const size_t size, const bstr &iv) const;
+
+    private:
+        size_t key_size;
+        size_t period_size;
+        bstr period;
+    };
+
+} } }
@@ -20,7 +20,10 @@
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/rsa.h>
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
+#include "algo/range.h"
 #include "err.h"
 
 using namespace au;
@@ -32,13 +35,69 @@ struct Rsa::Priv final
     ~Priv();
 
     RSA *key_impl;
+
+    // kept separately for decrypt_blocks, which skips the RSA_* layer
+    BIGNUM *modulus;
+    BIGNUM *exponent;
+    BN_MONT_CTX *mont;
 };
 
-Rsa::Priv::Priv(const RsaKey &key) : key_impl(RSA_new())
+namespace
+{
+    class BnContext final
+    {
+    public:
+        BnContext() : ctx(BN_CTX_new())
+        {
+            if (!ctx)
+                throw std::bad_alloc();
+            BN_CTX_start(ctx);
+        }
+
+        ~BnContext()
+        {
+            BN_CTX_end(ctx);
+            BN_CTX_free(ctx);
+        }
+
+        BIGNUM *get()
+        {
+            auto ret = BN_CTX_get(ctx);
+            if (!ret)
+                throw std::bad_alloc();
+            return ret;
+        }
+
+        BN_CTX *ctx;
+    };
+}
+
+Rsa::Priv::Priv(const RsaKey &key)
+    : key_impl(RSA_new()),
+        modulus(nullptr),
+        exponent(nullptr),
+        mont(nullptr)
 {
     if (!key_impl)
         throw std::bad_alloc();
 
+    modulus = BN_bin2bn(key.modulus.data(), key.modulus.size(), nullptr);
+    exponent = BN_new();
+    mont = BN_MONT_CTX_new();
+    if (!modulus || !exponent || !mont)
+    {
+        BN_free(modulus);
+        BN_free(exponent);
+        BN_MONT_CTX_free(mont);
+        RSA_free(key_impl);
+        throw std::bad_alloc();
+    }
+    BN_set_word(exponent, key.exponent);
+    {
+        BnContext ctx;
+        BN_MONT_CTX_set(mont, modulus, ctx.ctx);
+    }
+
     BIGNUM *bn_modulus = BN_new();
     if (!bn_modulus)
         throw std::bad_alloc();
@@ -63,6 +122,9 @@ Rsa::Priv::Priv(const RsaKey &key) : key_impl(RSA_new())
 
 Rsa::Priv::~Priv()
 {
+    BN_MONT_CTX_free(mont);
+    BN_free(exponent);
+    BN_free(modulus);
     RSA_free(key_impl);
 }
 
@@ -96,3 +158,53 @@ bstr Rsa::decrypt(const bstr &input) const
 
     return bstr(reinterpret_cast<char*>(output.get()), output_size);
 }
+
+bstr Rsa::decrypt_blocks(const bstr &input, const size_t output_size) const
+{
+    const size_t block_size = BN_num_bytes(p->modulus);
+    if (input.size() % block_size)
+        throw err::CorruptDataError("Data is not aligned to RSA block size");
+    const auto block_count = input.size() / block_size;
+
+    BnContext ctx;
+    auto cipher = ctx.get();
+    auto plain = ctx.get();
+    bstr block(block_size);
+    bstr output(block_count * output_size);
+
+    for (const auto i : algo::range(block_count))
+    {
+        BN_bin2bn(
+            input.get<const u8>() + i * block_size, block_size, cipher);
+        if (BN_ucmp(cipher, p->modulus) >= 0)
+            throw err::CorruptDataError("RSA block is not smaller than key");
+
+        if (!BN_mod_exp_mont(
+            plain, cipher, p->exponent, p->modulus, ctx.ctx, p->mont))
+        {
+            throw err::CorruptDataError("RSA exponentiation failed");
+        }
+
+        // left-pad to the block size, then expect PKCS#1 type 1 padding:
+        // 00 01 FF..FF 00 <message>, with at least 8 bytes of FF
+        const auto plain_size = BN_num_bytes(plain);
+        std::memset(block.get<u8>(), 0, block_size - plain_size);
+        BN_bn2bin(plain, block.get<u8>() + block_size - plain_size);
+
+        if (block[0] != 0x00 || block[1] != 0x01)
+            throw err::CorruptDataError("Bad RSA padding type");
+        size_t pos = 2;
+        while (pos < block_size && block[pos] == 0xFF)
+            pos++;
+        if (pos == block_size || block[pos] != 0x00 || pos < 2 + 8)
+            throw err::CorruptDataError("Bad RSA padding");
+        pos++;
+
+        std::memcpy(
+            output.get<u8>() + i * output_size,
+            block.get<const u8>() + pos,
+            std::min(output_size, block_size - pos));
+    }
+
+    return output;
+}
@@ -38,6 +38,10 @@ namespace crypt {
         ~Rsa();
         bstr decrypt(const bstr &input) const;
 
+        // Decrypts consecutive key-sized blocks, keeping the first
+        // output_size bytes of every message (zero-padded if shorter).
+        bstr decrypt_blocks(const bstr &input, const size_t output_size) const;
+
     private:
         struct Priv;
         std::unique_ptr<Priv> p;
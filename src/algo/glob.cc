@@ -0,0 +1,138 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/glob.h"
+
+using namespace au;
+
+static inline char to_lower(const char c)
+{
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+algo::Glob::Glob(const std::string &pattern)
+    : name_only(pattern.find('/') == std::string::npos)
+{
+    size_t i = 0;
+    while (i < pattern.size() && pattern[i] == '/')
+        i++;
+
+    while (i < pattern.size())
+    {
+        if (pattern[i] == '*')
+        {
+            size_t stars = 0;
+            while (i < pattern.size() && pattern[i] == '*')
+            {
+                stars++;
+                i++;
+            }
+            if (stars == 1)
+                tokens.push_back({TokenType::AnyName, ""});
+            else if (i < pattern.size() && pattern[i] == '/')
+            {
+                tokens.push_back({TokenType::AnyDirs, ""});
+                i++;
+            }
+            else
+                tokens.push_back({TokenType::AnyPath, ""});
+        }
+        else if (pattern[i] == '?')
+        {
+            tokens.push_back({TokenType::AnyChar, ""});
+            i++;
+        }
+        else
+        {
+            if (tokens.empty() || tokens.back().type != TokenType::Literal)
+                tokens.push_back({TokenType::Literal, ""});
+            tokens.back().text += to_lower(pattern[i++]);
+        }
+    }
+}
+
+bool algo::Glob::matches(const std::string &path) const
+{
+    const char *str = path.c_str();
+    const char *str_end = str + path.size();
+    if (name_only)
+    {
+        const auto pos = path.rfind('/');
+        if (pos != std::string::npos)
+            str += pos + 1;
+    }
+    else
+    {
+        while (str < str_end && *str == '/')
+            str++;
+    }
+    return match(0, str, str_end);
+}
+
+bool algo::Glob::match(
+    size_t token_index, const char *str, const char *str_end) const
+{
+    for (; token_index < tokens.size(); token_index++)
+    {
+        const auto &token = tokens[token_index];
+        const auto is_last = token_index + 1 == tokens.size();
+        switch (token.type)
+        {
+            case TokenType::Literal:
+                if (static_cast<size_t>(str_end - str) < token.text.size())
+                    return false;
+                for (const auto c : token.text)
+                    if (to_lower(*str++) != c)
+                        return false;
+                break;
+
+            case TokenType::AnyChar:
+                if (str == str_end || *str == '/')
+                    return false;
+                str++;
+                break;
+
+            case TokenType::AnyName:
+                for (auto p = str; ; p++)
+                {
+                    if (!is_last && match(token_index + 1, p, str_end))
+                        return true;
+                    if (p == str_end)
+                        return is_last;
+                    if (*p == '/')
+                        return false;
+                }
+
+            case TokenType::AnyPath:
+                if (is_last)
+                    return true;
+                for (auto p = str; p <= str_end; p++)
+                    if (match(token_index + 1, p, str_end))
+                        return true;
+                return false;
+
+            case TokenType::AnyDirs:
+                if (match(token_index + 1, str, str_end))
+                    return true;
+                for (auto p = str; p < str_end; p++)
+                    if (*p == '/' && match(token_index + 1, p + 1, str_end))
+                        return true;
+                return false;
+        }
+    }
+    return str == str_end;
+}
@@ -0,0 +1,63 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "types.h"
+
+namespace au {
+namespace algo {
+
+    // Wildcard pattern compiled once and matched against many paths.
+    // * and ? don't cross directory separators, ** does, and **/ also
+    // matches no directory at all. Patterns without a / are matched against
+    // the file name only. Matching ignores the case of ASCII letters.
+    class Glob final
+    {
+    public:
+        Glob(const std::string &pattern);
+
+        bool matches(const std::string &path) const;
+
+    private:
+        enum class TokenType : u8
+        {
+            Literal,
+            AnyChar,
+            AnyName,
+            AnyPath,
+            AnyDirs,
+        };
+
+        struct Token final
+        {
+            TokenType type;
+            std::string text;
+        };
+
+        bool match(
+            size_t token_index,
+            const char *str,
+            const char *str_end) const;
+
+        std::vector<Token> tokens;
+        bool name_only;
+    };
+
+} }
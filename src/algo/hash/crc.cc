@@ -0,0 +1,149 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/hash/crc.h"
+#include <cstring>
+#include "algo/endian.h"
+#include "algo/range.h"
+
+using namespace au;
+
+// All the CRCs use slicing-by-8: eight lookup tables let the loop consume
+// eight bytes per iteration with independent lookups, instead of one byte
+// per iteration with each lookup depending on the previous one.
+
+namespace
+{
+    template<typename T, bool reflected> class CrcTables final
+    {
+    public:
+        CrcTables(const T poly);
+        T update(T crc, const u8 *input, size_t size) const;
+
+    private:
+        static const size_t width = sizeof(T) * 8;
+        T tables[8][0x100];
+    };
+}
+
+template<typename T, bool reflected>
+CrcTables<T, reflected>::CrcTables(const T poly)
+{
+    for (const auto i : algo::range(0x100))
+    {
+        T crc;
+        if (reflected)
+        {
+            crc = i;
+            for (const auto j : algo::range(8))
+                crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
+        }
+        else
+        {
+            crc = static_cast<T>(static_cast<T>(i) << (width - 8));
+            for (const auto j : algo::range(8))
+            {
+                crc = crc >> (width - 1)
+                    ? static_cast<T>(crc << 1) ^ poly
+                    : static_cast<T>(crc << 1);
+            }
+        }
+        tables[0][i] = crc;
+    }
+
+    for (const auto k : algo::range(1, 8))
+    for (const auto i : algo::range(0x100))
+    {
+        const auto prev = tables[k - 1][i];
+        tables[k][i] = reflected
+            ? (prev >> 8) ^ tables[0][prev & 0xFF]
+            : static_cast<T>(prev << 8) ^ tables[0][prev >> (width - 8)];
+    }
+}
+
+template<typename T, bool reflected>
+T CrcTables<T, reflected>::update(T crc, const u8 *input, size_t size) const
+{
+    // the register is never wider than the eight bytes it's mixed into
+    while (size >= 8)
+    {
+        u64 chunk;
+        if (reflected)
+        {
+            std::memcpy(&chunk, input, 8);
+            chunk = algo::from_little_endian(chunk) ^ crc;
+            crc = tables[7][chunk & 0xFF]
+                ^ tables[6][(chunk >> 8) & 0xFF]
+                ^ tables[5][(chunk >> 16) & 0xFF]
+                ^ tables[4][(chunk >> 24) & 0xFF]
+                ^ tables[3][(chunk >> 32) & 0xFF]
+                ^ tables[2][(chunk >> 40) & 0xFF]
+                ^ tables[1][(chunk >> 48) & 0xFF]
+                ^ tables[0][chunk >> 56];
+        }
+        else
+        {
+            chunk = 0;
+            for (const auto i : algo::range(8))
+                chunk = (chunk << 8) | input[i];
+            chunk ^= static_cast<u64>(crc) << (64 - width);
+            crc = tables[7][chunk >> 56]
+                ^ tables[6][(chunk >> 48) & 0xFF]
+                ^ tables[5][(chunk >> 40) & 0xFF]
+                ^ tables[4][(chunk >> 32) & 0xFF]
+                ^ tables[3][(chunk >> 24) & 0xFF]
+                ^ tables[2][(chunk >> 16) & 0xFF]
+                ^ tables[1][(chunk >> 8) & 0xFF]
+                ^ tables[0][chunk & 0xFF];
+        }
+        input += 8;
+        size -= 8;
+    }
+
+    while (size--)
+    {
+        crc = reflected
+            ? (crc >> 8) ^ tables[0][(crc ^ *input++) & 0xFF]
+            : static_cast<T>(crc << 8)
+                ^ tables[0][((crc >> (width - 8)) ^ *input++) & 0xFF];
+    }
+    return crc;
+}
+
+u16 algo::hash::crc16(const bstr &input, const u16 crc)
+{
+    static const CrcTables<u16, false> tables(0x8005);
+    return tables.update(crc, input.get<u8>(), input.size());
+}
+
+u32 algo::hash::crc32(const bstr &input, const u32 crc)
+{
+    static const CrcTables<u32, true> tables(0xEDB88320);
+    return ~tables.update(~crc, input.get<u8>(), input.size());
+}
+
+u32 algo::hash::crc32_mpeg2(const bstr &input, const u32 crc)
+{
+    static const CrcTables<u32, false> tables(0x04C11DB7);
+    return tables.update(crc, input.get<u8>(), input.size());
+}
+
+u64 algo::hash::crc64(const bstr &input, const u64 crc)
+{
+    static const CrcTables<u64, false> tables(0x42F0E1EBA9EA3693);
+    return ~tables.update(~crc, input.get<u8>(), input.size());
+}
@@ -0,0 +1,42 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace hash {
+
+    // All of these take the result of the previous call as the last argument,
+    // so the data can be hashed in pieces.
+
+    // CRC-16/UMTS: polynomial 0x8005, no reflection, no final XOR.
+    u16 crc16(const bstr &input, const u16 crc = 0);
+
+    // CRC-32 as used by zlib, PNG and ZIP.
+    u32 crc32(const bstr &input, const u32 crc = 0);
+
+    // CRC-32/MPEG-2: polynomial 0x04C11DB7 processed MSB first, without the
+    // final XOR.
+    u32 crc32_mpeg2(const bstr &input, const u32 crc = 0xFFFFFFFF);
+
+    // CRC-64/WE: polynomial 0x42F0E1EBA9EA3693 processed MSB first.
+    u64 crc64(const bstr &input, const u64 crc = 0);
+
+} } }
@@ -0,0 +1,110 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/hash/xxhash.h"
+#include <cstring>
+#include "algo/endian.h"
+
+using namespace au;
+
+static const u64 prime1 = 0x9E3779B185EBCA87;
+static const u64 prime2 = 0xC2B2AE3D27D4EB4F;
+static const u64 prime3 = 0x165667B19E3779F9;
+static const u64 prime4 = 0x85EBCA77C2B2AE63;
+static const u64 prime5 = 0x27D4EB2F165667C5;
+
+static inline u64 rotl(const u64 x, const int n)
+{
+    return (x << n) | (x >> (64 - n));
+}
+
+template<typename T> static inline T read(const u8 *input)
+{
+    T ret;
+    std::memcpy(&ret, input, sizeof(T));
+    return algo::from_little_endian<T>(ret);
+}
+
+static inline u64 accumulate(u64 acc, const u64 input)
+{
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+}
+
+static inline u64 merge_round(u64 acc, const u64 value)
+{
+    acc ^= accumulate(0, value);
+    return acc * prime1 + prime4;
+}
+
+u64 algo::hash::xxhash64(const bstr &input, const u64 seed)
+{
+    const u8 *p = input.get<u8>();
+    const u8 *end = p + input.size();
+    u64 hash;
+
+    if (input.size() >= 32)
+    {
+        u64 v1 = seed + prime1 + prime2;
+        u64 v2 = seed + prime2;
+        u64 v3 = seed;
+        u64 v4 = seed - prime1;
+        while (p + 32 <= end)
+        {
+            v1 = accumulate(v1, read<u64>(p));
+            v2 = accumulate(v2, read<u64>(p + 8));
+            v3 = accumulate(v3, read<u64>(p + 16));
+            v4 = accumulate(v4, read<u64>(p + 24));
+            p += 32;
+        }
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = merge_round(hash, v1);
+        hash = merge_round(hash, v2);
+        hash = merge_round(hash, v3);
+        hash = merge_round(hash, v4);
+    }
+    else
+        hash = seed + prime5;
+
+    hash += input.size();
+
+    while (p + 8 <= end)
+    {
+        hash ^= accumulate(0, read<u64>(p));
+        hash = rotl(hash, 27) * prime1 + prime4;
+        p += 8;
+    }
+    if (p + 4 <= end)
+    {
+        hash ^= read<u32>(p) * prime1;
+        hash = rotl(hash, 23) * prime2 + prime3;
+        p += 4;
+    }
+    while (p < end)
+    {
+        hash ^= *p++ * prime5;
+        hash = rotl(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
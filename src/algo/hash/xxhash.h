@@ -21,8 +21,10 @@
 
 namespace au {
 namespace algo {
-namespace crypt {
+namespace hash {
 
-    u32 crc32(const bstr &input);
+    // XXH64, a fast non-cryptographic hash. Meant for cache keys and the
+    // like, never for anything a file format defines.
+    u64 xxhash64(const bstr &input, const u64 seed = 0);
 
 } } }
@@ -0,0 +1,479 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/image/idct.h"
+#include "algo/range.h"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define AU_IDCT_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define AU_IDCT_SSE2 0
+#endif
+
+using namespace au;
+
+static const f32 aan_scales[64] =
+{
+    1.0f,      1.38704f,  1.30656f,  1.17588f,
+    1.0f,      0.785695f, 0.541196f, 0.275899f,
+    1.38704f,  1.92388f,  1.81225f,  1.63099f,
+    1.38704f,  1.08979f,  0.750661f, 0.382683f,
+    1.30656f,  1.81225f,  1.70711f,  1.53636f,
+    1.30656f,  1.02656f,  0.707107f, 0.36048f,
+    1.17588f,  1.63099f,  1.53636f,  1.38268f,
+    1.17588f,  0.92388f,  0.636379f, 0.324423f,
+    1.0f,      1.38704f,  1.30656f,  1.17588f,
+    1.0f,      0.785695f, 0.541196f, 0.275899f,
+    0.785695f, 1.08979f,  1.02656f,  0.92388f,
+    0.785695f, 0.617317f, 0.425215f, 0.216773f,
+    0.541196f, 0.750661f, 0.707107f, 0.636379f,
+    0.541196f, 0.425215f, 0.292893f, 0.149316f,
+    0.275899f, 0.382683f, 0.36048f,  0.324423f,
+    0.275899f, 0.216773f, 0.149316f, 0.0761205f
+};
+
+static inline u8 descale_float(const f32 value)
+{
+    // values between 0x100 and 0x17F saturate, anything above wraps to 0
+    const int a = 0x80 + (static_cast<int>(value) >> 3);
+    if (a < 0)
+        return 0;
+    if (a < 0xFF)
+        return a;
+    if (a < 0x180)
+        return 0xFF;
+    return 0;
+}
+
+void algo::image::make_aan_multipliers(const u8 *quant_table, f32 *output)
+{
+    for (const auto i : algo::range(64))
+        output[i] = quant_table[i] * aan_scales[i];
+}
+
+void algo::image::idct_8x8_float_scalar(
+    const s16 *input, const f32 *multipliers, u8 *output)
+{
+    f32 tp[64];
+    f32 tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+    f32 tmp10, tmp11, tmp12, tmp13;
+    f32 z5, z10, z11, z12, z13;
+
+    const auto *in = input;
+    const auto *dv = multipliers;
+
+    for (const auto i : algo::range(8))
+    {
+        if (!in[8 + i] && !in[16 + i]
+            && !in[24 + i] && !in[32 + i]
+            && !in[40 + i] && !in[48 + i]
+            && !in[56 + i])
+        {
+            tmp0 = in[i] * dv[i];
+            tp[i] = tmp0;
+            tp[8 + i] = tmp0;
+            tp[16 + i] = tmp0;
+            tp[24 + i] = tmp0;
+            tp[32 + i] = tmp0;
+            tp[40 + i] = tmp0;
+            tp[48 + i] = tmp0;
+            tp[56 + i] = tmp0;
+            continue;
+        }
+
+        tmp0 = in[i] * dv[i];
+        tmp1 = in[16 + i] * dv[16 + i];
+        tmp2 = in[32 + i] * dv[32 + i];
+        tmp3 = in[48 + i] * dv[48 + i];
+        tmp10 = tmp0 + tmp2;
+        tmp11 = tmp0 - tmp2;
+        tmp13 = tmp1 + tmp3;
+        tmp12 = (tmp1 - tmp3) * 1.414213562f - tmp13;
+        tmp0 = tmp10 + tmp13;
+        tmp3 = tmp10 - tmp13;
+        tmp1 = tmp11 + tmp12;
+        tmp2 = tmp11 - tmp12;
+        tmp4 = in[8 + i] * dv[8 + i];
+        tmp5 = in[24 + i] * dv[24 + i];
+        tmp6 = in[40 + i] * dv[40 + i];
+        tmp7 = in[56 + i] * dv[56 + i];
+        z13 = tmp6 + tmp5;
+        z10 = tmp6 - tmp5;
+        z11 = tmp4 + tmp7;
+        z12 = tmp4 - tmp7;
+
+        tmp7 = z11 + z13;
+        tmp11 = (z11 - z13) * 1.414213562f;
+        z5 = (z10 + z12) * 1.847759065f;
+        tmp10 = z12 * 1.082392200f - z5;
+        tmp12 = z10 * (-2.613125930f) + z5;
+
+        tmp6 = tmp12 - tmp7;
+        tmp5 = tmp11 - tmp6;
+        tmp4 = tmp10 + tmp5;
+
+        tp[i] = tmp0 + tmp7;
+        tp[56 + i] = tmp0 - tmp7;
+        tp[8 + i] = tmp1 + tmp6;
+        tp[48 + i] = tmp1 - tmp6;
+        tp[16 + i] = tmp2 + tmp5;
+        tp[40 + i] = tmp2 - tmp5;
+        tp[32 + i] = tmp3 + tmp4;
+        tp[24 + i] = tmp3 - tmp4;
+    }
+
+    for (const auto i : algo::range(8))
+    {
+        const auto row = &tp[i * 8];
+        z5 = row[0];
+        tmp10 = z5 + row[4];
+        tmp11 = z5 - row[4];
+
+        tmp13 = row[2] + row[6];
+        tmp12 = (row[2] - row[6]) * 1.414213562f - tmp13;
+
+        tmp0 = tmp10 + tmp13;
+        tmp3 = tmp10 - tmp13;
+        tmp1 = tmp11 + tmp12;
+        tmp2 = tmp11 - tmp12;
+
+        z13 = row[5] + row[3];
+        z10 = row[5] - row[3];
+        z11 = row[1] + row[7];
+        z12 = row[1] - row[7];
+
+        tmp7 = z11 + z13;
+        tmp11 = (z11 - z13) * 1.414213562f;
+
+        z5 = (z10 + z12) * 1.847759065f;
+        tmp10 = z5 - z12 * 1.082392200f;
+        tmp12 = z5 - z10 * 2.613125930f;
+
+        tmp6 = tmp12 - tmp7;
+        tmp5 = tmp11 - tmp6;
+        tmp4 = tmp10 - tmp5;
+
+        output[i * 8 + 0] = descale_float(tmp0 + tmp7);
+        output[i * 8 + 7] = descale_float(tmp0 - tmp7);
+        output[i * 8 + 1] = descale_float(tmp1 + tmp6);
+        output[i * 8 + 6] = descale_float(tmp1 - tmp6);
+        output[i * 8 + 2] = descale_float(tmp2 + tmp5);
+        output[i * 8 + 5] = descale_float(tmp2 - tmp5);
+        output[i * 8 + 3] = descale_float(tmp3 + tmp4);
+        output[i * 8 + 4] = descale_float(tmp3 - tmp4);
+    }
+}
+
+#if AU_IDCT_SSE2
+    static inline __m128 load_dequantized(const s16 *input, const f32 *mul)
+    {
+        // sign-extend 4 coefficients to 32 bits
+        const auto packed = _mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(input));
+        const auto wide = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        return _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_loadu_ps(mul));
+    }
+
+    static inline void transpose_8x8(const f32 *input, f32 *output)
+    {
+        for (const auto by : algo::range(2))
+        for (const auto bx : algo::range(2))
+        {
+            const auto src = input + by * 32 + bx * 4;
+            auto r0 = _mm_loadu_ps(src);
+            auto r1 = _mm_loadu_ps(src + 8);
+            auto r2 = _mm_loadu_ps(src + 16);
+            auto r3 = _mm_loadu_ps(src + 24);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            const auto dst = output + bx * 32 + by * 4;
+            _mm_storeu_ps(dst, r0);
+            _mm_storeu_ps(dst + 8, r1);
+            _mm_storeu_ps(dst + 16, r2);
+            _mm_storeu_ps(dst + 24, r3);
+        }
+    }
+
+    static inline __m128i descale_float(const __m128 value)
+    {
+        const auto a = _mm_add_epi32(
+            _mm_set1_epi32(0x80), _mm_srai_epi32(_mm_cvttps_epi32(value), 3));
+        const auto is_negative = _mm_cmplt_epi32(a, _mm_setzero_si128());
+        const auto is_saturated = _mm_cmpgt_epi32(a, _mm_set1_epi32(0xFE));
+        const auto is_wrapped = _mm_cmpgt_epi32(a, _mm_set1_epi32(0x17F));
+        auto result = _mm_or_si128(
+            _mm_andnot_si128(is_saturated, a),
+            _mm_and_si128(is_saturated, _mm_set1_epi32(0xFF)));
+        return _mm_andnot_si128(_mm_or_si128(is_negative, is_wrapped), result);
+    }
+
+    void algo::image::idct_8x8_float(
+        const s16 *input, const f32 *multipliers, u8 *output)
+    {
+        // same operations in the same order as the scalar version, so the
+        // results are identical; the scalar shortcut for columns with no AC
+        // coefficients yields the same values as the full computation
+        alignas(16) f32 tp[64];
+        alignas(16) f32 tpt[64];
+
+        const auto sqrt2 = _mm_set1_ps(1.414213562f);
+        const auto c1 = _mm_set1_ps(1.847759065f);
+        const auto c2 = _mm_set1_ps(1.082392200f);
+        const auto c3 = _mm_set1_ps(-2.613125930f);
+        const auto c4 = _mm_set1_ps(2.613125930f);
+
+        for (const auto h : algo::range(0, 8, 4))
+        {
+            const auto in = input + h;
+            const auto dv = multipliers + h;
+            auto tmp0 = load_dequantized(in, dv);
+            auto tmp1 = load_dequantized(in + 16, dv + 16);
+            auto tmp2 = load_dequantized(in + 32, dv + 32);
+            auto tmp3 = load_dequantized(in + 48, dv + 48);
+            auto tmp10 = _mm_add_ps(tmp0, tmp2);
+            auto tmp11 = _mm_sub_ps(tmp0, tmp2);
+            auto tmp13 = _mm_add_ps(tmp1, tmp3);
+            auto tmp12 = _mm_sub_ps(
+                _mm_mul_ps(_mm_sub_ps(tmp1, tmp3), sqrt2), tmp13);
+            tmp0 = _mm_add_ps(tmp10, tmp13);
+            tmp3 = _mm_sub_ps(tmp10, tmp13);
+            tmp1 = _mm_add_ps(tmp11, tmp12);
+            tmp2 = _mm_sub_ps(tmp11, tmp12);
+            auto tmp4 = load_dequantized(in + 8, dv + 8);
+            auto tmp5 = load_dequantized(in + 24, dv + 24);
+            auto tmp6 = load_dequantized(in + 40, dv + 40);
+            auto tmp7 = load_dequantized(in + 56, dv + 56);
+            const auto z13 = _mm_add_ps(tmp6, tmp5);
+            const auto z10 = _mm_sub_ps(tmp6, tmp5);
+            const auto z11 = _mm_add_ps(tmp4, tmp7);
+            const auto z12 = _mm_sub_ps(tmp4, tmp7);
+
+            tmp7 = _mm_add_ps(z11, z13);
+            tmp11 = _mm_mul_ps(_mm_sub_ps(z11, z13), sqrt2);
+            const auto z5 = _mm_mul_ps(_mm_add_ps(z10, z12), c1);
+            tmp10 = _mm_sub_ps(_mm_mul_ps(z12, c2), z5);
+            tmp12 = _mm_add_ps(_mm_mul_ps(z10, c3), z5);
+
+            tmp6 = _mm_sub_ps(tmp12, tmp7);
+            tmp5 = _mm_sub_ps(tmp11, tmp6);
+            tmp4 = _mm_add_ps(tmp10, tmp5);
+
+            _mm_store_ps(tp + h, _mm_add_ps(tmp0, tmp7));
+            _mm_store_ps(tp + 56 + h, _mm_sub_ps(tmp0, tmp7));
+            _mm_store_ps(tp + 8 + h, _mm_add_ps(tmp1, tmp6));
+            _mm_store_ps(tp + 48 + h, _mm_sub_ps(tmp1, tmp6));
+            _mm_store_ps(tp + 16 + h, _mm_add_ps(tmp2, tmp5));
+            _mm_store_ps(tp + 40 + h, _mm_sub_ps(tmp2, tmp5));
+            _mm_store_ps(tp + 32 + h, _mm_add_ps(tmp3, tmp4));
+            _mm_store_ps(tp + 24 + h, _mm_sub_ps(tmp3, tmp4));
+        }
+
+        // process rows as columns of the transposed matrix
+        transpose_8x8(tp, tpt);
+        alignas(16) s32 result[64];
+        for (const auto h : algo::range(0, 8, 4))
+        {
+            const auto row = tpt + h;
+            const auto z5a = _mm_load_ps(row);
+            auto tmp10 = _mm_add_ps(z5a, _mm_load_ps(row + 32));
+            auto tmp11 = _mm_sub_ps(z5a, _mm_load_ps(row + 32));
+
+            const auto r2 = _mm_load_ps(row + 16);
+            const auto r6 = _mm_load_ps(row + 48);
+            const auto tmp13 = _mm_add_ps(r2, r6);
+            auto tmp12 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(r2, r6), sqrt2), tmp13);
+
+            const auto tmp0 = _mm_add_ps(tmp10, tmp13);
+            const auto tmp3 = _mm_sub_ps(tmp10, tmp13);
+            const auto tmp1 = _mm_add_ps(tmp11, tmp12);
+            const auto tmp2 = _mm_sub_ps(tmp11, tmp12);
+
+            const auto r1 = _mm_load_ps(row + 8);
+            const auto r3 = _mm_load_ps(row + 24);
+            const auto r5 = _mm_load_ps(row + 40);
+            const auto r7 = _mm_load_ps(row + 56);
+            const auto z13 = _mm_add_ps(r5, r3);
+            const auto z10 = _mm_sub_ps(r5, r3);
+            const auto z11 = _mm_add_ps(r1, r7);
+            const auto z12 = _mm_sub_ps(r1, r7);
+
+            const auto tmp7 = _mm_add_ps(z11, z13);
+            tmp11 = _mm_mul_ps(_mm_sub_ps(z11, z13), sqrt2);
+
+            const auto z5 = _mm_mul_ps(_mm_add_ps(z10, z12), c1);
+            tmp10 = _mm_sub_ps(z5, _mm_mul_ps(z12, c2));
+            tmp12 = _mm_sub_ps(z5, _mm_mul_ps(z10, c4));
+
+            const auto tmp6 = _mm_sub_ps(tmp12, tmp7);
+            const auto tmp5 = _mm_sub_ps(tmp11, tmp6);
+            const auto tmp4 = _mm_sub_ps(tmp10, tmp5);
+
+            const auto out = reinterpret_cast<__m128i*>(result + h);
+            _mm_store_si128(out + 0, descale_float(_mm_add_ps(tmp0, tmp7)));
+            _mm_store_si128(out + 14, descale_float(_mm_sub_ps(tmp0, tmp7)));
+            _mm_store_si128(out + 2, descale_float(_mm_add_ps(tmp1, tmp6)));
+            _mm_store_si128(out + 12, descale_float(_mm_sub_ps(tmp1, tmp6)));
+            _mm_store_si128(out + 4, descale_float(_mm_add_ps(tmp2, tmp5)));
+            _mm_store_si128(out + 10, descale_float(_mm_sub_ps(tmp2, tmp5)));
+            _mm_store_si128(out + 6, descale_float(_mm_add_ps(tmp3, tmp4)));
+            _mm_store_si128(out + 8, descale_float(_mm_sub_ps(tmp3, tmp4)));
+        }
+
+        // result holds column k of row i at [k * 8 + i]
+        for (const auto i : algo::range(8))
+        for (const auto k : algo::range(8))
+            output[i * 8 + k] = result[k * 8 + i];
+    }
+#else
+    void algo::image::idct_8x8_float(
+        const s16 *input, const f32 *multipliers, u8 *output)
+    {
+        idct_8x8_float_scalar(input, multipliers, output);
+    }
+#endif
+
+void algo::image::idct_8x8_int(s16 *block, const s16 *quant_table)
+{
+    long a, b, c, d;
+    long w, x, y, z;
+    long s, t, u, v, n;
+
+    auto lp1 = block;
+    auto lp2 = quant_table;
+
+    for (const auto i : algo::range(8))
+    {
+        if (lp1[0x08] == 0 &&
+            lp1[0x10] == 0 &&
+            lp1[0x18] == 0 &&
+            lp1[0x20] == 0 &&
+            lp1[0x28] == 0 &&
+            lp1[0x30] == 0 &&
+            lp1[0x38] == 0)
+        {
+            lp1[0x00] =
+            lp1[0x08] =
+            lp1[0x10] =
+            lp1[0x18] =
+            lp1[0x20] =
+            lp1[0x28] =
+            lp1[0x30] =
+            lp1[0x38] = lp1[0] * lp2[0];
+        }
+
+        else
+        {
+            c = lp2[0x10] * lp1[0x10];
+            d = lp2[0x30] * lp1[0x30];
+            x = ((c + d) * 35467) >> 16;
+            c = ((c * 50159) >> 16) + x;
+            d = ((d * -121094) >> 16) + x;
+            a = lp1[0x00] * lp2[0x00];
+            b = lp1[0x20] * lp2[0x20];
+            w = a + b + c;
+            x = a + b - c;
+            y = a - b + d;
+            z = a - b - d;
+
+            c = lp1[0x38] * lp2[0x38];
+            d = lp1[0x28] * lp2[0x28];
+            a = lp1[0x18] * lp2[0x18];
+            b = lp1[0x08] * lp2[0x08];
+            n = ((a + b + c + d) * 77062) >> 16;
+
+            u = n
+                + ((c * 19571) >> 16)
+                + (((c + a) * -128553) >> 16)
+                + (((c + b) * -58980) >> 16);
+            v = n
+                + ((d * 134553) >> 16)
+                + (((d + b) * -25570) >> 16)
+                + (((d + a) * -167963) >> 16);
+            t = n
+                + ((b * 98390) >> 16)
+                + (((d + b) * -25570) >> 16)
+                + (((c + b) * -58980) >> 16);
+            s = n
+                + ((a * 201373) >> 16)
+                + (((c + a) * -128553) >> 16)
+                + (((d + a) * -167963) >> 16);
+
+            lp1[0x00] = w + t;
+            lp1[0x38] = w - t;
+            lp1[0x08] = y + s;
+            lp1[0x30] = y - s;
+            lp1[0x10] = z + v;
+            lp1[0x28] = z - v;
+            lp1[0x18] = x + u;
+            lp1[0x20] = x - u;
+        }
+
+        lp1++;
+        lp2++;
+    }
+
+    lp1 = block;
+
+    for (const auto i : algo::range(8))
+    {
+        a = lp1[0];
+        c = lp1[2];
+        b = lp1[4];
+        d = lp1[6];
+        x = (((c + d) * 35467) >> 16);
+        c = ((c * 50159) >> 16) + x;
+        d = ((d * -121094) >> 16) + x;
+        w = a + b + c;
+        x = a + b - c;
+        y = a - b + d;
+        z = a - b - d;
+
+        d = lp1[5];
+        b = lp1[1];
+        c = lp1[7];
+        a = lp1[3];
+        n = (((a + b + c + d) * 77062) >> 16);
+
+        s = n + ((a * 201373) >> 16)
+              + (((a + c) * -128553) >> 16)
+              + (((a + d) * -167963) >> 16);
+
+        t = n + ((b * 98390) >> 16)
+              + (((b + d) * -25570) >> 16)
+              + (((b + c) * -58980) >> 16);
+
+        u = n + ((c * 19571) >> 16)
+              + (((b + c) * -58980) >> 16)
+              + (((a + c) * -128553) >> 16);
+
+        v = n + ((d * 134553) >> 16)
+              + (((b + d) * -25570) >> 16)
+              + (((a + d) * -167963) >> 16);
+
+        lp1[0] = (w + t) >> 3;
+        lp1[7] = (w - t) >> 3;
+        lp1[1] = (y + s) >> 3;
+        lp1[6] = (y - s) >> 3;
+        lp1[2] = (z + v) >> 3;
+        lp1[5] = (z - v) >> 3;
+        lp1[3] = (x + u) >> 3;
+        lp1[4] = (x - u) >> 3;
+
+        lp1 += 8;
+    }
+}
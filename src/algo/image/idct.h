@@ -0,0 +1,43 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace image {
+
+    // Builds multipliers for idct_8x8_float out of a quantization table by
+    // applying the AAN scale factors. Both tables are in natural order.
+    void make_aan_multipliers(const u8 *quant_table, f32 *output);
+
+    // Floating point AAN inverse DCT with dequantization folded into the
+    // multipliers. The output is level shifted (+0x80) and clamped to a byte.
+    // Uses SSE2 when available.
+    void idct_8x8_float(const s16 *input, const f32 *multipliers, u8 *output);
+
+    // Portable reference implementation of idct_8x8_float.
+    void idct_8x8_float_scalar(
+        const s16 *input, const f32 *multipliers, u8 *output);
+
+    // Fixed point inverse DCT with dequantization, done in place. The output
+    // is scaled down by 8, but not level shifted.
+    void idct_8x8_int(s16 *block, const s16 *quant_table);
+
+} } }
@@ -0,0 +1,150 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/image/ycbcr.h"
+#include <algorithm>
+#include "algo/range.h"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define AU_YCBCR_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define AU_YCBCR_SSE2 0
+#endif
+
+using namespace au;
+
+static inline u8 clamp_float(const f32 value)
+{
+    return std::max(0.0f, std::min(255.0f, value));
+}
+
+static inline u8 clamp_int(const int value)
+{
+    return value < 0 ? 0 : value > 0xFF ? 0xFF : value;
+}
+
+void algo::image::ycbcr_to_bgr_8x8_float_scalar(
+    const u8 *y, const u8 *cb, const u8 *cr, u8 *output, const size_t stride)
+{
+    for (const auto j : algo::range(8))
+    {
+        auto output_ptr = output + j * stride;
+        for (const auto i : algo::range(8))
+        {
+            const f32 cy = y[j * 8 + i];
+            const f32 cu = cb[j * 8 + i];
+            const f32 cv = cr[j * 8 + i];
+            const auto r = cy + 1.402f * cv - 178.956f;
+            const auto g
+                = cy + 44.04992f - 0.34414f * cu + 91.90992f - 0.71414f * cv;
+            const auto b = cy + 1.772f * cu - 226.316f;
+            *output_ptr++ = clamp_float(b);
+            *output_ptr++ = clamp_float(g);
+            *output_ptr++ = clamp_float(r);
+            output_ptr++;
+        }
+    }
+}
+
+#if AU_YCBCR_SSE2
+    static inline __m128 load_4(const u8 *input)
+    {
+        const auto packed = _mm_cvtsi32_si128(
+            input[0] | (input[1] << 8) | (input[2] << 16) | (input[3] << 24));
+        const auto zero = _mm_setzero_si128();
+        return _mm_cvtepi32_ps(
+            _mm_unpacklo_epi16(_mm_unpacklo_epi8(packed, zero), zero));
+    }
+
+    static inline __m128i clamp_float(const __m128 value)
+    {
+        return _mm_cvttps_epi32(_mm_max_ps(
+            _mm_setzero_ps(), _mm_min_ps(value, _mm_set1_ps(255.0f))));
+    }
+
+    void algo::image::ycbcr_to_bgr_8x8_float(
+        const u8 *y, const u8 *cb, const u8 *cr, u8 *output, const size_t stride)
+    {
+        // operations are kept in the scalar order so the results match
+        const auto alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        for (const auto j : algo::range(8))
+        for (const auto i : algo::range(0, 8, 4))
+        {
+            const auto offset = j * 8 + i;
+            const auto cy = load_4(y + offset);
+            const auto cu = load_4(cb + offset);
+            const auto cv = load_4(cr + offset);
+
+            const auto r = _mm_sub_ps(
+                _mm_add_ps(cy, _mm_mul_ps(_mm_set1_ps(1.402f), cv)),
+                _mm_set1_ps(178.956f));
+            const auto g = _mm_sub_ps(
+                _mm_add_ps(
+                    _mm_sub_ps(
+                        _mm_add_ps(cy, _mm_set1_ps(44.04992f)),
+                        _mm_mul_ps(_mm_set1_ps(0.34414f), cu)),
+                    _mm_set1_ps(91.90992f)),
+                _mm_mul_ps(_mm_set1_ps(0.71414f), cv));
+            const auto b = _mm_sub_ps(
+                _mm_add_ps(cy, _mm_mul_ps(_mm_set1_ps(1.772f), cu)),
+                _mm_set1_ps(226.316f));
+
+            const auto bgr = _mm_or_si128(
+                clamp_float(b),
+                _mm_or_si128(
+                    _mm_slli_epi32(clamp_float(g), 8),
+                    _mm_slli_epi32(clamp_float(r), 16)));
+
+            const auto target = reinterpret_cast<__m128i*>(
+                output + j * stride + i * 4);
+            const auto alpha = _mm_and_si128(_mm_loadu_si128(target), alpha_mask);
+            _mm_storeu_si128(target, _mm_or_si128(alpha, bgr));
+        }
+    }
+#else
+    void algo::image::ycbcr_to_bgr_8x8_float(
+        const u8 *y, const u8 *cb, const u8 *cr, u8 *output, const size_t stride)
+    {
+        ycbcr_to_bgr_8x8_float_scalar(y, cb, cr, output, stride);
+    }
+#endif
+
+void algo::image::ycbcr420_to_bgr_8x8_int(
+    const s16 *y, const s16 *cb, const s16 *cr, u8 *output, const size_t stride)
+{
+    for (const auto j : algo::range(4))
+    for (const auto i : algo::range(4))
+    {
+        const int c = cr[j * 8 + i];
+        const int d = cb[j * 8 + i];
+        const auto r = (c * 0x166F0) >> 16;
+        const auto g = ((d * 0x5810) >> 16) + ((c * 0xB6C0) >> 16);
+        const auto b = (d * 0x1C590) >> 16;
+
+        for (const auto dy : algo::range(2))
+        for (const auto dx : algo::range(2))
+        {
+            const int luma = y[(j * 2 + dy) * 8 + i * 2 + dx] + 0x80;
+            auto output_ptr = output + (j * 2 + dy) * stride + (i * 2 + dx) * 4;
+            output_ptr[0] = clamp_int(luma + b);
+            output_ptr[1] = clamp_int(luma - g);
+            output_ptr[2] = clamp_int(luma + r);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace image {
+
+    // Converts an 8x8 block of full resolution Y, Cb and Cr samples to BGR.
+    // Pixels are 4 bytes wide and lines are `stride` bytes apart; the 4th
+    // byte of each pixel is left untouched. Uses SSE2 when available.
+    void ycbcr_to_bgr_8x8_float(
+        const u8 *y, const u8 *cb, const u8 *cr, u8 *output, size_t stride);
+
+    // Portable reference implementation of ycbcr_to_bgr_8x8_float.
+    void ycbcr_to_bgr_8x8_float_scalar(
+        const u8 *y, const u8 *cb, const u8 *cr, u8 *output, size_t stride);
+
+    // Converts an 8x8 block of luma samples plus 4x4 subsampled chroma taken
+    // from 8x8 blocks (4:2:0) to BGR, using fixed point math. Samples are
+    // expected not to be level shifted, as produced by idct_8x8_int.
+    void ycbcr420_to_bgr_8x8_int(
+        const s16 *y, const s16 *cb, const s16 *cr, u8 *output, size_t stride);
+
+} } }
@@ -16,9 +16,9 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/locale.h"
-#include <cerrno>
-#include <iconv.h>
-#include <memory>
+#include <cstring>
+#include "algo/locale_cp932.h"
+#include "algo/range.h"
 #include "err.h"
 
 using namespace au;
@@ -38,72 +38,226 @@ static bstr replace(const bstr &input, const bstr &from, const bstr &to)
     return output;
 }
 
-static bstr convert_locale(
-    const bstr &input, const std::string &from, const std::string &to)
+[[noreturn]] static void throw_invalid_sequence()
 {
-    iconv_t conv = iconv_open(to.c_str(), from.c_str());
-    if (!conv)
-        throw std::logic_error("Failed to initialize iconv");
-
-    bstr output;
-    output.reserve(input.size() * 2);
-
-    auto input_ptr = const_cast<char*>(input.get<const char>());
-    auto input_bytes_left = input.size();
-    bstr buffer(32);
+    throw err::CorruptDataError("Invalid byte sequence");
+}
 
-    while (true)
+// Copies the leading run of 7-bit characters, testing 8 bytes at a time.
+static void copy_ascii(
+    const u8 *&input_ptr, const u8 *input_end, u8 *&output_ptr)
+{
+    const auto start = input_ptr;
+    while (input_end - input_ptr >= 8)
     {
-        auto output_buffer = buffer.get<char>();
-        auto output_bytes_left = buffer.size();
-        int ret = iconv(
-            conv,
-            &input_ptr,
-            &input_bytes_left,
-            &output_buffer,
-            &output_bytes_left);
-        const auto err = errno;
-
-        output += buffer.substr(0, buffer.size() - output_bytes_left);
-
-        if (ret != -1 && input_bytes_left == 0)
+        u64 chunk;
+        std::memcpy(&chunk, input_ptr, 8);
+        if (chunk & 0x8080808080808080ull)
             break;
+        input_ptr += 8;
+    }
+    while (input_ptr < input_end && *input_ptr < 0x80)
+        input_ptr++;
+    std::memcpy(output_ptr, start, input_ptr - start);
+    output_ptr += input_ptr - start;
+}
 
-        // repeat the iteration unless nothing was parsed at all
-        if (err == E2BIG && output_bytes_left != buffer.size())
-            continue;
+static void write_utf8(const u32 code_point, u8 *&output_ptr)
+{
+    if (code_point < 0x80)
+    {
+        *output_ptr++ = code_point;
+    }
+    else if (code_point < 0x800)
+    {
+        *output_ptr++ = 0xC0 | (code_point >> 6);
+        *output_ptr++ = 0x80 | (code_point & 0x3F);
+    }
+    else if (code_point < 0x10000)
+    {
+        *output_ptr++ = 0xE0 | (code_point >> 12);
+        *output_ptr++ = 0x80 | ((code_point >> 6) & 0x3F);
+        *output_ptr++ = 0x80 | (code_point & 0x3F);
+    }
+    else
+    {
+        *output_ptr++ = 0xF0 | (code_point >> 18);
+        *output_ptr++ = 0x80 | ((code_point >> 12) & 0x3F);
+        *output_ptr++ = 0x80 | ((code_point >> 6) & 0x3F);
+        *output_ptr++ = 0x80 | (code_point & 0x3F);
+    }
+}
 
-        iconv_close(conv);
-        if (err == E2BIG)
-            throw err::CorruptDataError("Code point too large to decode (?)");
-        else if (err == EINVAL || err == EILSEQ)
-            throw err::CorruptDataError("Invalid byte sequence");
-        else
-            throw err::CorruptDataError("Unknown iconv error");
+// Decodes one non-ASCII character, rejecting overlong forms, surrogates and
+// anything past U+10FFFF.
+static u32 read_utf8(const u8 *&input_ptr, const u8 *input_end)
+{
+    const auto lead = *input_ptr;
+    size_t size;
+    u32 code_point;
+    u32 min_code_point;
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        size = 2;
+        code_point = lead & 0x1F;
+        min_code_point = 0x80;
     }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        size = 3;
+        code_point = lead & 0x0F;
+        min_code_point = 0x800;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        size = 4;
+        code_point = lead & 0x07;
+        min_code_point = 0x10000;
+    }
+    else
+        throw_invalid_sequence();
 
-    iconv_close(conv);
-    return output;
+    if (static_cast<size_t>(input_end - input_ptr) < size)
+        throw_invalid_sequence();
+    for (const auto i : algo::range(1, size))
+    {
+        const auto c = input_ptr[i];
+        if ((c & 0xC0) != 0x80)
+            throw_invalid_sequence();
+        code_point = (code_point << 6) | (c & 0x3F);
+    }
+    if (code_point < min_code_point
+        || code_point > 0x10FFFF
+        || (code_point >= 0xD800 && code_point <= 0xDFFF))
+    {
+        throw_invalid_sequence();
+    }
+    input_ptr += size;
+    return code_point;
 }
 
 bstr algo::sjis_to_utf8(const bstr &input)
 {
-    return convert_locale(input, "cp932", "utf-8");
+    // each byte expands to at most 3 bytes (halfwidth katakana)
+    bstr output(input.size() * 3);
+    auto input_ptr = input.get<const u8>();
+    const auto input_end = input_ptr + input.size();
+    auto output_ptr = output.get<u8>();
+    while (true)
+    {
+        copy_ascii(input_ptr, input_end, output_ptr);
+        if (input_ptr == input_end)
+            break;
+
+        const auto c = *input_ptr++;
+        u16 code_point;
+        if (cp932::is_lead_byte(c))
+        {
+            if (input_ptr == input_end)
+                throw_invalid_sequence();
+            code_point = cp932::decode(c, *input_ptr++);
+        }
+        else
+            code_point = cp932::decode(c);
+        if (!code_point)
+            throw_invalid_sequence();
+        write_utf8(code_point, output_ptr);
+    }
+    output.resize(output_ptr - output.get<u8>());
+    return output;
 }
 
 bstr algo::utf16_to_utf8(const bstr &input)
 {
-    return convert_locale(input, "utf-16le", "utf-8");
+    if (input.size() % 2)
+        throw_invalid_sequence();
+
+    // each code unit expands to at most 3 bytes; pairs take 4 bytes for 2
+    bstr output(input.size() / 2 * 3);
+    auto input_ptr = input.get<const u8>();
+    const auto input_end = input_ptr + input.size();
+    auto output_ptr = output.get<u8>();
+    while (input_ptr < input_end)
+    {
+        u32 code_point = input_ptr[0] | (input_ptr[1] << 8);
+        input_ptr += 2;
+        if (code_point >= 0xD800 && code_point <= 0xDFFF)
+        {
+            if (code_point >= 0xDC00 || input_ptr == input_end)
+                throw_invalid_sequence();
+            const u32 low = input_ptr[0] | (input_ptr[1] << 8);
+            if (low < 0xDC00 || low > 0xDFFF)
+                throw_invalid_sequence();
+            input_ptr += 2;
+            code_point = 0x10000
+                + ((code_point - 0xD800) << 10)
+                + (low - 0xDC00);
+        }
+        write_utf8(code_point, output_ptr);
+    }
+    output.resize(output_ptr - output.get<u8>());
+    return output;
 }
 
 bstr algo::utf8_to_sjis(const bstr &input)
 {
-    return convert_locale(input, "utf-8", "cp932");
+    bstr output(input.size());
+    auto input_ptr = input.get<const u8>();
+    const auto input_end = input_ptr + input.size();
+    auto output_ptr = output.get<u8>();
+    while (true)
+    {
+        copy_ascii(input_ptr, input_end, output_ptr);
+        if (input_ptr == input_end)
+            break;
+
+        const auto code_point = read_utf8(input_ptr, input_end);
+        // iconv drops language tags instead of failing on them
+        if (code_point >= 0xE0000 && code_point <= 0xE007F)
+            continue;
+        const auto sjis = code_point < 0x10000 ? cp932::encode(code_point) : 0;
+        if (!sjis)
+            throw_invalid_sequence();
+        if (sjis > 0xFF)
+            *output_ptr++ = sjis >> 8;
+        *output_ptr++ = sjis;
+    }
+    output.resize(output_ptr - output.get<u8>());
+    return output;
 }
 
 bstr algo::utf8_to_utf16(const bstr &input)
 {
-    return convert_locale(input, "utf-8", "utf-16le");
+    bstr output(input.size() * 2);
+    auto input_ptr = input.get<const u8>();
+    const auto input_end = input_ptr + input.size();
+    auto output_ptr = output.get<u8>();
+    while (input_ptr < input_end)
+    {
+        u32 code_point = *input_ptr;
+        if (code_point < 0x80)
+            input_ptr++;
+        else
+            code_point = read_utf8(input_ptr, input_end);
+
+        if (code_point >= 0x10000)
+        {
+            code_point -= 0x10000;
+            const u16 high = 0xD800 | (code_point >> 10);
+            const u16 low = 0xDC00 | (code_point & 0x3FF);
+            *output_ptr++ = high;
+            *output_ptr++ = high >> 8;
+            *output_ptr++ = low;
+            *output_ptr++ = low >> 8;
+        }
+        else
+        {
+            *output_ptr++ = code_point;
+            *output_ptr++ = code_point >> 8;
+        }
+    }
+    output.resize(output_ptr - output.get<u8>());
+    return output;
 }
 
 bstr algo::normalize_sjis(const bstr &utf8_input)
@@ -0,0 +1,42 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+
+namespace au {
+namespace algo {
+namespace cp932 {
+
+    // Whether the byte starts a double-byte sequence.
+    bool is_lead_byte(const u8 c);
+
+    // Maps a single non-ASCII byte to its code point, or returns 0 if the
+    // byte has no meaning on its own.
+    u16 decode(const u8 c);
+
+    // Maps a double-byte sequence to its code point, or returns 0 if the
+    // sequence is not assigned.
+    u16 decode(const u8 lead, const u8 trail);
+
+    // Maps a non-ASCII BMP code point to either a single byte or a double-byte
+    // sequence packed as (lead << 8) | trail, or returns 0 if the code point
+    // cannot be represented.
+    u16 encode(const u16 code_point);
+
+} } }
@@ -16,37 +16,57 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/pack/lzss.h"
-#include <array>
-#include "algo/ptr.h"
+#include <algorithm>
+#include <cstring>
 #include "algo/range.h"
+#include "err.h"
 #include "io/memory_byte_stream.h"
 #include "io/msb_bit_stream.h"
 
 using namespace au;
 
+static const size_t hash_bits = 15;
+static const size_t none = static_cast<size_t>(-1);
+
 namespace
 {
-    struct LzssEncoderState final
+    struct Match final
     {
-        LzssEncoderState(const size_t dict_size, const size_t max_match_size);
+        size_t position;
+        size_t size;
+    };
 
-        void insert_node(int r);
-        void delete_node(int p);
+    class HashChainMatcher final
+    {
+    public:
+        HashChainMatcher(
+            const bstr &input,
+            const size_t min_match_size,
+            const size_t max_match_size,
+            const size_t dict_size,
+            const size_t max_distance,
+            const size_t max_chain_size);
 
-        const size_t dict_size;
-        const size_t max_match_size;
-        const int empty;
-        std::vector<u8> text_buf;
-        std::vector<int> children[2], dad;
+        void insert(const size_t pos);
+        Match find(const size_t pos) const;
 
-        size_t match_position;
-        size_t match_size;
+    private:
+        size_t hash(const size_t pos) const;
+
+        const bstr &input;
+        const size_t hash_size;
+        const size_t max_match_size;
+        const size_t max_distance;
+        const size_t max_chain_size;
+        const size_t window_mask;
+        std::vector<size_t> head;
+        std::vector<size_t> prev;
     };
 
     class BitwiseLzssWriter final : public algo::pack::BaseLzssWriter
     {
     public:
-        BitwiseLzssWriter();
+        BitwiseLzssWriter(const size_t reserve_size);
         void write_literal(const u8 literal) override;
         void write_repetition(
             const size_t position_bits,
@@ -54,15 +74,19 @@ namespace
             const size_t size_bits,
             const size_t size) override;
         bstr retrieve() override;
+
     private:
-        io::MemoryByteStream byte_stream;
-        io::MsbBitStream bit_stream;
+        void write(const size_t bits, const u32 value);
+
+        bstr output;
+        u64 buffer;
+        size_t bits_available;
     };
 
     class BytewiseLzssWriter final : public algo::pack::BaseLzssWriter
     {
     public:
-        BytewiseLzssWriter();
+        BytewiseLzssWriter(const size_t reserve_size);
         void write_literal(const u8 literal) override;
         void write_repetition(
             const size_t position_bits,
@@ -72,22 +96,105 @@ namespace
         bstr retrieve() override;
 
     private:
-        void flush();
-        io::MemoryByteStream byte_stream;
+        void next_control_bit(const bool literal);
+
+        bstr output;
+        size_t control_pos;
         size_t count;
-        u8 control;
-        std::vector<u8> states;
     };
 }
 
-BitwiseLzssWriter::BitwiseLzssWriter() : bit_stream(byte_stream)
+HashChainMatcher::HashChainMatcher(
+    const bstr &input,
+    const size_t min_match_size,
+    const size_t max_match_size,
+    const size_t dict_size,
+    const size_t max_distance,
+    const size_t max_chain_size) :
+        input(input),
+        hash_size(std::max<size_t>(1, std::min<size_t>(min_match_size, 3))),
+        max_match_size(max_match_size),
+        max_distance(max_distance),
+        max_chain_size(max_chain_size),
+        window_mask(dict_size - 1),
+        head(1 << hash_bits, none),
+        prev(dict_size, none)
+{
+}
+
+size_t HashChainMatcher::hash(const size_t pos) const
 {
+    u32 value = 0;
+    for (const auto i : algo::range(hash_size))
+        value = (value << 8) | input[pos + i];
+    return (value * 2654435761u) >> (32 - hash_bits);
+}
+
+void HashChainMatcher::insert(const size_t pos)
+{
+    if (pos + hash_size > input.size())
+        return;
+    auto &bucket = head[hash(pos)];
+    prev[pos & window_mask] = bucket;
+    bucket = pos;
+}
+
+Match HashChainMatcher::find(const size_t pos) const
+{
+    Match best {0, 0};
+    if (pos + hash_size > input.size())
+        return best;
+
+    const auto data = input.get<const u8>();
+    const auto limit = std::min(max_match_size, input.size() - pos);
+    auto candidate = head[hash(pos)];
+    auto chain_size = max_chain_size;
+    while (candidate != none
+        && pos - candidate <= max_distance
+        && chain_size--)
+    {
+        // candidates that cannot beat the current best fail on one byte
+        if (data[candidate + best.size] == data[pos + best.size])
+        {
+            size_t size = 0;
+            while (size < limit && data[candidate + size] == data[pos + size])
+                size++;
+            if (size > best.size)
+            {
+                best.position = candidate;
+                best.size = size;
+                if (size == limit)
+                    break;
+            }
+        }
+        const auto next = prev[candidate & window_mask];
+        if (next == none || next >= candidate)
+            break;
+        candidate = next;
+    }
+    return best;
+}
+
+BitwiseLzssWriter::BitwiseLzssWriter(const size_t reserve_size)
+    : buffer(0), bits_available(0)
+{
+    output.reserve(reserve_size);
+}
+
+void BitwiseLzssWriter::write(const size_t bits, const u32 value)
+{
+    buffer = (buffer << bits) | (value & ((1ull << bits) - 1));
+    bits_available += bits;
+    while (bits_available >= 8)
+    {
+        bits_available -= 8;
+        output += static_cast<u8>(buffer >> bits_available);
+    }
 }
 
 void BitwiseLzssWriter::write_literal(const u8 literal)
 {
-    bit_stream.write(1, 1);
-    bit_stream.write(8, literal);
+    write(9, 0x100 | literal);
 }
 
 void BitwiseLzssWriter::write_repetition(
@@ -96,29 +203,43 @@ void BitwiseLzssWriter::write_repetition(
     const size_t size_bits,
     const size_t size)
 {
-    bit_stream.write(1, 0);
-    bit_stream.write(position_bits, position);
-    bit_stream.write(size_bits, size);
+    write(1, 0);
+    write(position_bits, position);
+    write(size_bits, size);
 }
 
 bstr BitwiseLzssWriter::retrieve()
 {
-    bit_stream.flush();
-    return byte_stream.seek(0).read_to_eof();
+    if (bits_available)
+    {
+        output += static_cast<u8>(buffer << (8 - bits_available));
+        bits_available = 0;
+    }
+    return output;
 }
 
-BytewiseLzssWriter::BytewiseLzssWriter() : count(0), control(0)
+BytewiseLzssWriter::BytewiseLzssWriter(const size_t reserve_size)
+    : control_pos(0), count(0)
 {
+    output.reserve(reserve_size);
+}
+
+void BytewiseLzssWriter::next_control_bit(const bool literal)
+{
+    if (!count)
+    {
+        control_pos = output.size();
+        output += static_cast<u8>(0);
+    }
+    if (literal)
+        output[control_pos] |= 1 << count;
+    count = (count + 1) % 8;
 }
 
 void BytewiseLzssWriter::write_literal(const u8 literal)
 {
-    control >>= 1;
-    control |= 0x80;
-    count++;
-    states.push_back(literal);
-    if (count >= 8)
-        flush();
+    next_control_bit(true);
+    output += literal;
 }
 
 void BytewiseLzssWriter::write_repetition(
@@ -127,31 +248,14 @@ void BytewiseLzssWriter::write_repetition(
     const size_t size_bits,
     const size_t size)
 {
-    control >>= 1;
-    count++;
-    states.push_back(position & 0xFF);
-    states.push_back(((position >> 8) << 4) | size);
-    if (count >= 8)
-        flush();
-}
-
-void BytewiseLzssWriter::flush()
-{
-    if (count == 0)
-        return;
-    control >>= 8 - count;
-    byte_stream.write<u8>(control);
-    for (const auto &state : states)
-        byte_stream.write<u8>(state);
-    count = 0;
-    control = 0;
-    states.clear();
+    next_control_bit(false);
+    output += static_cast<u8>(position & 0xFF);
+    output += static_cast<u8>(((position >> 8) << 4) | size);
 }
 
 bstr BytewiseLzssWriter::retrieve()
 {
-    flush();
-    return byte_stream.seek(0).read_to_eof();
+    return output;
 }
 
 algo::pack::BytewiseLzssSettings::BytewiseLzssSettings()
@@ -159,292 +263,368 @@ algo::pack::BytewiseLzssSettings::BytewiseLzssSettings()
 {
 }
 
-bstr algo::pack::lzss_decompress(
-    const bstr &input,
+// The dictionary is never materialized: every byte that enters it is also
+// written to the output, so a dictionary position maps to the most recent
+// output byte that occupied it, or to the initial zero fill if no byte did.
+static inline size_t get_match_distance(
+    const size_t dict_size,
+    const size_t initial_dictionary_pos,
+    const size_t output_pos,
+    const size_t look_behind_pos)
+{
+    const auto distance
+        = (initial_dictionary_pos + output_pos - look_behind_pos)
+        & (dict_size - 1);
+    return distance ? distance : dict_size;
+}
+
+static inline void copy_match(
+    u8 *output,
+    const size_t output_pos,
     const size_t output_size,
-    const BitwiseLzssSettings &settings)
+    const size_t distance,
+    size_t size)
+{
+    auto target = output + output_pos;
+
+    // matches with enough room get copied with fixed size stores; bytes
+    // past the match are rewritten by subsequent literals and matches
+    if (distance >= 16 && distance <= output_pos && size <= 16
+        && output_size - output_pos >= 16)
+    {
+        std::memcpy(target, target - distance, 16);
+        return;
+    }
+
+    if (distance > output_pos)
+    {
+        const auto zeros = std::min(size, distance - output_pos);
+        std::memset(target, 0, zeros);
+        target += zeros;
+        size -= zeros;
+    }
+
+    // overlapping matches repeat a pattern whose length doubles each round
+    const auto source = target - distance;
+    while (size)
+    {
+        const auto chunk = std::min<size_t>(size, target - source);
+        std::memcpy(target, source, chunk);
+        target += chunk;
+        size -= chunk;
+    }
+}
+
+namespace
 {
-    io::MsbBitStream bit_stream(input);
-    return lzss_decompress(bit_stream, output_size, settings);
+    class MsbBitReader final
+    {
+    public:
+        MsbBitReader(const bstr &input);
+        inline u32 read(const size_t bits);
+
+    private:
+        const u8 *input_ptr;
+        const u8 *input_end;
+        u64 buffer;
+        size_t bits_available;
+    };
+
+    class StreamBitReader final
+    {
+    public:
+        StreamBitReader(io::BaseBitStream &input_stream);
+        inline u32 read(const size_t bits);
+
+    private:
+        io::BaseBitStream &input_stream;
+    };
 }
 
-bstr algo::pack::lzss_decompress(
-    io::BaseBitStream &input_stream,
+MsbBitReader::MsbBitReader(const bstr &input) :
+    input_ptr(input.get<const u8>()),
+    input_end(input.get<const u8>() + input.size()),
+    buffer(0),
+    bits_available(0)
+{
+}
+
+inline u32 MsbBitReader::read(const size_t bits)
+{
+    if (bits_available < bits)
+    {
+        while (bits_available <= 56 && input_ptr < input_end)
+        {
+            buffer = (buffer << 8) | *input_ptr++;
+            bits_available += 8;
+        }
+        if (bits_available < bits)
+            throw err::EofError();
+    }
+    bits_available -= bits;
+    return (buffer >> bits_available) & ((1ull << bits) - 1);
+}
+
+StreamBitReader::StreamBitReader(io::BaseBitStream &input_stream)
+    : input_stream(input_stream)
+{
+}
+
+inline u32 StreamBitReader::read(const size_t bits)
+{
+    return input_stream.read(bits);
+}
+
+template<typename T> static bstr lzss_decompress_bitwise(
+    T &reader,
     const size_t output_size,
-    const BitwiseLzssSettings &settings)
+    const algo::pack::BitwiseLzssSettings &settings)
 {
-    std::vector<u8> dict(1 << settings.position_bits, 0);
-    auto dict_ptr
-        = algo::make_cyclic_ptr(dict.data(), dict.size())
-        + settings.initial_dictionary_pos;
+    const size_t dict_size = 1 << settings.position_bits;
+    const auto initial_dictionary_pos
+        = settings.initial_dictionary_pos & (dict_size - 1);
 
     bstr output(output_size);
-    auto output_ptr = algo::make_ptr(output);
-    while (output_ptr.left())
+    const auto output_ptr = output.get<u8>();
+    size_t output_pos = 0;
+    while (output_pos < output_size)
     {
-        if (input_stream.read(1))
+        if (reader.read(1))
         {
-            const auto b = input_stream.read(8);
-            *output_ptr++ = b;
-            *dict_ptr++ = b;
+            output_ptr[output_pos++] = reader.read(8);
         }
         else
         {
-            auto look_behind_pos = input_stream.read(settings.position_bits);
-            auto repetitions = input_stream.read(settings.size_bits)
-                + settings.min_match_size;
-            auto source_ptr
-                = algo::make_cyclic_ptr(dict.data(), dict.size())
-                + look_behind_pos;
-            while (repetitions-- && output_ptr.left())
-            {
-                const auto b = *source_ptr++;
-                *output_ptr++ = b;
-                *dict_ptr++ = b;
-            }
+            const auto look_behind_pos = reader.read(settings.position_bits);
+            const auto size = std::min<size_t>(
+                reader.read(settings.size_bits) + settings.min_match_size,
+                output_size - output_pos);
+            copy_match(
+                output_ptr,
+                output_pos,
+                output_size,
+                get_match_distance(
+                    dict_size,
+                    initial_dictionary_pos,
+                    output_pos,
+                    look_behind_pos),
+                size);
+            output_pos += size;
         }
     }
     return output;
 }
 
+bstr algo::pack::lzss_decompress(
+    const bstr &input,
+    const size_t output_size,
+    const BitwiseLzssSettings &settings)
+{
+    MsbBitReader reader(input);
+    return lzss_decompress_bitwise(reader, output_size, settings);
+}
+
+bstr algo::pack::lzss_decompress(
+    io::BaseBitStream &input_stream,
+    const size_t output_size,
+    const BitwiseLzssSettings &settings)
+{
+    StreamBitReader reader(input_stream);
+    return lzss_decompress_bitwise(reader, output_size, settings);
+}
+
 bstr algo::pack::lzss_decompress(
     const bstr &input,
     const size_t output_size,
     const BytewiseLzssSettings &settings)
 {
-    std::array<u8, 0x1000> dict = {0};
-    auto dict_ptr
-        = algo::make_cyclic_ptr(dict.data(), dict.size())
-        + settings.initial_dictionary_pos;
+    static const size_t dict_size = 0x1000;
+    const auto initial_dictionary_pos
+        = settings.initial_dictionary_pos & (dict_size - 1);
 
     bstr output(output_size);
-    auto output_ptr = algo::make_ptr(output);
-    auto input_ptr = algo::make_ptr(input);
+    const auto output_ptr = output.get<u8>();
+    size_t output_pos = 0;
+    auto input_ptr = input.get<const u8>();
+    const auto input_end = input_ptr + input.size();
 
     u16 control = 0;
-    while (output_ptr.left())
+    while (output_pos < output_size)
     {
         control >>= 1;
         if (!(control & 0x100))
         {
-            if (!input_ptr.left()) break;
+            if (input_ptr == input_end) break;
             control = *input_ptr++ | 0xFF00;
         }
         if (control & 1)
         {
-            if (!input_ptr.left()) break;
-            const auto b = *input_ptr++;
-            *output_ptr++ = b;
-            *dict_ptr++ = b;
+            if (input_ptr == input_end) break;
+            output_ptr[output_pos++] = *input_ptr++;
         }
         else
         {
-            if (input_ptr.left() < 2) break;
+            if (input_end - input_ptr < 2) break;
             const auto lo = *input_ptr++;
             const auto hi = *input_ptr++;
             const auto look_behind_pos = lo | ((hi & 0xF0) << 4);
-            auto repetitions = (hi & 0xF) + 3;
-            auto source_ptr
-                = algo::make_cyclic_ptr(dict.data(), dict.size())
-                + look_behind_pos;
-            while (repetitions-- && output_ptr.left())
-            {
-                const auto b = *source_ptr++;
-                *output_ptr++ = b;
-                *dict_ptr++ = b;
-            }
-        }
-    }
-    return output;
-}
-
-LzssEncoderState::LzssEncoderState(
-    const size_t dict_size, const size_t max_match_size) :
-        dict_size(dict_size),
-        max_match_size(max_match_size),
-        empty(dict_size),
-        text_buf(dict_size + max_match_size + 1),
-        dad(dict_size + 1)
-{
-    children[0].resize(dict_size + 1);
-    children[1].resize(dict_size + 1 + 256);
-    for (auto &c : children[0]) c = empty;
-    for (auto &c : children[1]) c = empty;
-    for (auto &c : dad) c = empty;
-}
-
-void LzssEncoderState::insert_node(int r)
-{
-    int cmp = 1;
-    int p = dict_size + 1 + text_buf[r];
-    children[0][r] = children[1][r] = empty;
-    match_size = 0;
-    while (true)
-    {
-        const auto lr = cmp >= 0;
-        if (children[lr][p] == empty)
-        {
-            children[lr][p] = r;
-            dad[r] = p;
-            return;
-        }
-        p = children[lr][p];
-        size_t i = 0;
-        while (++i < max_match_size)
-            if ((cmp = text_buf[r + i] - text_buf[p + i]) != 0)
-                break;
-        if (i > match_size)
-        {
-            match_position = p;
-            if ((match_size = i) >= max_match_size)
-                break;
+            const auto size = std::min<size_t>(
+                (hi & 0xF) + 3, output_size - output_pos);
+            copy_match(
+                output_ptr,
+                output_pos,
+                output_size,
+                get_match_distance(
+                    dict_size,
+                    initial_dictionary_pos,
+                    output_pos,
+                    look_behind_pos),
+                size);
+            output_pos += size;
         }
     }
-    dad[r] = dad[p];
-    children[0][r] = children[0][p];
-    children[1][r] = children[1][p];
-    dad[children[0][p]] = r;
-    dad[children[1][p]] = r;
-    children[children[1][dad[p]] == p][dad[p]] = r;
-    dad[p] = empty;
-}
 
-void LzssEncoderState::delete_node(int p)
-{
-    if (dad[p] == empty)
-        return;
-
-    int q;
-    if (children[1][p] == empty)
-        q = children[0][p];
-    else if (children[0][p] == empty)
-        q = children[1][p];
-    else
-    {
-        q = children[0][p];
-        if (children[1][q] != empty)
-        {
-            do
-                q = children[1][q];
-            while (children[1][q] != empty);
-
-            children[1][dad[q]] = children[0][q];
-            dad[children[0][q]] = dad[q];
-            children[0][q] = children[0][p];
-            dad[children[0][p]] = q;
-        }
-
-        children[1][q] = children[1][p];
-        dad[children[1][p]] = q;
-    }
-
-    dad[q] = dad[p];
-    children[children[1][dad[p]] == p][dad[p]] = q;
-    dad[p] = empty;
+    // truncated input leaves the rest of the output zeroed
+    if (output_pos < output_size)
+        std::memset(output_ptr + output_pos, 0, output_size - output_pos);
+    return output;
 }
 
 bstr algo::pack::lzss_compress(
     io::BaseByteStream &input_stream,
     const algo::pack::BitwiseLzssSettings &settings,
-    algo::pack::BaseLzssWriter &writer)
+    algo::pack::BaseLzssWriter &writer,
+    const CompressionLevel compression_level)
 {
-    const auto dict_size = 1 << settings.position_bits;
+    const size_t dict_size = 1 << settings.position_bits;
     const auto max_match_size
         = settings.min_match_size + (1 << settings.size_bits) - 1;
-    LzssEncoderState state(dict_size, max_match_size);
 
-    size_t s = 0;
-    size_t r = dict_size - max_match_size;
-    for (const auto i : algo::range(s, r))
-        state.text_buf[i] = 0;
+    // stay clear of the part of the ring buffer that decoders overwrite while
+    // copying the longest possible match
+    const auto max_distance = dict_size > max_match_size
+        ? dict_size - max_match_size
+        : dict_size;
+
+    // the dictionary starts zero filled, so prefix the input with enough
+    // zeros for matches against it to be found
+    const auto prefix_size = std::min(dict_size, max_match_size);
+    const auto input = bstr(prefix_size) + input_stream.read_to_eof();
+
+    size_t max_chain_size = 0;
+    bool lazy = false;
+    if (compression_level == CompressionLevel::Best)
+    {
+        max_chain_size = 1024;
+        lazy = true;
+    }
+    else if (compression_level == CompressionLevel::Good)
+    {
+        max_chain_size = 128;
+        lazy = true;
+    }
+    else if (compression_level == CompressionLevel::Fast)
+    {
+        max_chain_size = 8;
+    }
+
+    HashChainMatcher matcher(
+        input,
+        settings.min_match_size,
+        max_match_size,
+        dict_size,
+        max_distance,
+        max_chain_size);
 
-    size_t len;
-    for (len = 0; len < max_match_size && input_stream.left(); len++)
-        state.text_buf[r + len] = input_stream.read<u8>();
+    const auto write_repetition = [&](const Match &match)
+    {
+        writer.write_repetition(
+            settings.position_bits,
+            (settings.initial_dictionary_pos + match.position - prefix_size)
+                & (dict_size - 1),
+            settings.size_bits,
+            match.size - settings.min_match_size);
+    };
 
-    for (const auto i : algo::range(1, max_match_size + 1))
-        state.insert_node(r - i);
-    state.insert_node(r);
+    for (const auto i : algo::range(prefix_size))
+        matcher.insert(i);
 
-    while (len > 0)
+    size_t pos = prefix_size;
+    auto match = matcher.find(pos);
+    while (pos < input.size())
     {
-        auto match_size = state.match_size;
-        auto match_position = state.match_position;
-        if (match_size > len)
-            match_size = len;
-        if (match_size < settings.min_match_size)
+        if (match.size < settings.min_match_size)
         {
-            match_size = 1;
-            writer.write_literal(state.text_buf[r]);
-        }
-        else
-        {
-            match_position -= dict_size - max_match_size;
-            match_position += settings.initial_dictionary_pos;
-            match_position %= dict_size;
-            writer.write_repetition(
-                settings.position_bits,
-                match_position,
-                settings.size_bits,
-                match_size - settings.min_match_size);
+            writer.write_literal(input[pos]);
+            matcher.insert(pos++);
+            match = matcher.find(pos);
+            continue;
         }
 
-        auto last_match_size = match_size;
-        size_t i;
-        for (i = 0; i < last_match_size && input_stream.left(); i++)
+        matcher.insert(pos);
+        if (lazy && match.size < max_match_size)
         {
-            const auto c = input_stream.read<u8>();
-            state.delete_node(s);
-            state.text_buf[s] = c;
-            if (s < max_match_size + 1)
-                state.text_buf[s + dict_size] = c;
-            s = (s + 1) % dict_size;
-            r = (r + 1) % dict_size;
-            state.insert_node(r);
-        }
-        while (i++ < last_match_size)
-        {
-            state.delete_node(s);
-            s = (s + 1) % dict_size;
-            r = (r + 1) % dict_size;
-            if (--len)
-                state.insert_node(r);
+            // defer the match if the next position has a longer one
+            const auto next_match = matcher.find(pos + 1);
+            if (next_match.size > match.size)
+            {
+                writer.write_literal(input[pos++]);
+                match = next_match;
+                continue;
+            }
         }
+
+        write_repetition(match);
+        for (const auto i : algo::range(pos + 1, pos + match.size))
+            matcher.insert(i);
+        pos += match.size;
+        match = matcher.find(pos);
     }
+
     return writer.retrieve();
 }
 
 bstr algo::pack::lzss_compress(
-    const bstr &input, const algo::pack::BitwiseLzssSettings &settings)
+    const bstr &input,
+    const algo::pack::BitwiseLzssSettings &settings,
+    const CompressionLevel compression_level)
 {
     io::MemoryByteStream input_stream(input);
-    return algo::pack::lzss_compress(input_stream, settings);
+    return algo::pack::lzss_compress(
+        input_stream, settings, compression_level);
 }
 
 bstr algo::pack::lzss_compress(
     io::BaseByteStream &input_stream,
-    const algo::pack::BitwiseLzssSettings &settings)
+    const algo::pack::BitwiseLzssSettings &settings,
+    const CompressionLevel compression_level)
 {
-    BitwiseLzssWriter writer;
-    return algo::pack::lzss_compress(input_stream, settings, writer);
+    BitwiseLzssWriter writer(input_stream.left() / 2);
+    return algo::pack::lzss_compress(
+        input_stream, settings, writer, compression_level);
 }
 
 bstr algo::pack::lzss_compress(
-    const bstr &input, const algo::pack::BytewiseLzssSettings &settings)
+    const bstr &input,
+    const algo::pack::BytewiseLzssSettings &settings,
+    const CompressionLevel compression_level)
 {
     io::MemoryByteStream input_stream(input);
-    return algo::pack::lzss_compress(input_stream, settings);
+    return algo::pack::lzss_compress(
+        input_stream, settings, compression_level);
 }
 
 bstr algo::pack::lzss_compress(
     io::BaseByteStream &input_stream,
-    const algo::pack::BytewiseLzssSettings &settings)
+    const algo::pack::BytewiseLzssSettings &settings,
+    const CompressionLevel compression_level)
 {
     BitwiseLzssSettings bitwise_settings;
     bitwise_settings.min_match_size = 3;
     bitwise_settings.position_bits = 12;
     bitwise_settings.size_bits = 4;
     bitwise_settings.initial_dictionary_pos = settings.initial_dictionary_pos;
-    BytewiseLzssWriter writer;
-    return algo::pack::lzss_compress(input_stream, bitwise_settings, writer);
+    BytewiseLzssWriter writer(input_stream.left() / 2);
+    return algo::pack::lzss_compress(
+        input_stream, bitwise_settings, writer, compression_level);
 }
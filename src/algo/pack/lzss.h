@@ -18,6 +18,7 @@
 #pragma once
 
 #include <string>
+#include "algo/pack/compression_level.h"
 #include "io/base_bit_stream.h"
 
 namespace au {
@@ -68,23 +69,29 @@ namespace pack {
         const BytewiseLzssSettings &settings = BytewiseLzssSettings());
 
     bstr lzss_compress(
-        const bstr &input, const algo::pack::BitwiseLzssSettings &settings);
+        const bstr &input,
+        const algo::pack::BitwiseLzssSettings &settings,
+        const CompressionLevel = CompressionLevel::Best);
 
     bstr lzss_compress(
         io::BaseByteStream &input_stream,
-        const BitwiseLzssSettings &settings);
+        const BitwiseLzssSettings &settings,
+        const CompressionLevel = CompressionLevel::Best);
 
     bstr lzss_compress(
         const bstr &input,
-        const BytewiseLzssSettings &settings = BytewiseLzssSettings());
+        const BytewiseLzssSettings &settings = BytewiseLzssSettings(),
+        const CompressionLevel = CompressionLevel::Best);
 
     bstr lzss_compress(
         io::BaseByteStream &input_stream,
-        const BytewiseLzssSettings &settings);
+        const BytewiseLzssSettings &settings,
+        const CompressionLevel = CompressionLevel::Best);
 
     bstr lzss_compress(
         io::BaseByteStream &input_stream,
         const algo::pack::BitwiseLzssSettings &settings,
-        BaseLzssWriter &writer);
+        BaseLzssWriter &writer,
+        const CompressionLevel = CompressionLevel::Best);
 
 } } }
@@ -66,6 +66,11 @@ namespace au {
         bool has_switch(const std::string &name) const;
 
         const std::string get_switch(const std::string &name) const;
+
+        // Returns all the values given to the switch, in order.
+        const std::vector<std::string> get_switch_values(
+            const std::string &name) const;
+
         const std::vector<std::string> get_stray() const;
 
     private:
@@ -65,8 +65,8 @@ std::unique_ptr<io::File> DskArchiveDecoder::read_file_impl(
     const dec::ArchiveEntry &e) const
 {
     const auto entry = static_cast<const PlainArchiveEntry*>(&e);
-    const auto data = input_file.stream.seek(entry->offset).read(entry->size);
-    return std::make_unique<io::File>(entry->path, data);
+    return read_stored_file(
+        input_file, entry->path, entry->offset, entry->size);
 }
 
 std::vector<std::string> DskArchiveDecoder::get_linked_formats() const
@@ -21,10 +21,26 @@
 #include "algo/format.h"
 #include "dec/idecoder_visitor.h"
 #include "err.h"
+#include "io/slice_byte_stream.h"
 
 using namespace au;
 using namespace au::dec;
 
+std::unique_ptr<io::File> dec::read_stored_file(
+    io::File &input_file,
+    const io::path &path,
+    const uoff_t offset,
+    const uoff_t size)
+{
+    const auto input_size = input_file.stream.size();
+    if (offset > input_size || size > input_size - offset)
+        throw err::EofError();
+    return std::make_unique<io::File>(
+        path,
+        std::make_unique<io::SliceByteStream>(
+            input_file.stream, offset, size));
+}
+
 algo::NamingStrategy BaseArchiveDecoder::naming_strategy() const
 {
     return algo::NamingStrategy::Child;
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <new>
+#include "algo/arena.h"
 #include "base_decoder.h"
 
 namespace au {
@@ -42,12 +44,62 @@ namespace dec {
         size_t size_orig, size_comp;
     };
 
+    // Deletes entries created with new, and only destroys the ones created
+    // in an ArchiveMeta's arena. Converts from std::default_delete, so that
+    // entries made with std::make_unique can be stored as before.
+    struct ArchiveEntryDeleter final
+    {
+        ArchiveEntryDeleter(const bool owns_memory = true)
+            : owns_memory(owns_memory)
+        {
+        }
+
+        template<typename T>
+            ArchiveEntryDeleter(const std::default_delete<T> &)
+            : owns_memory(true)
+        {
+        }
+
+        void operator ()(ArchiveEntry *entry) const
+        {
+            if (owns_memory)
+                delete entry;
+            else
+                entry->~ArchiveEntry();
+        }
+
+        bool owns_memory;
+    };
+
+    template<typename T> using ArchiveEntryPtr
+        = std::unique_ptr<T, ArchiveEntryDeleter>;
+
     struct ArchiveMeta
     {
         virtual ~ArchiveMeta() {}
-        std::vector<std::unique_ptr<ArchiveEntry>> entries;
+
+        // Creates an entry in the arena rather than on its own on the heap.
+        // The entry must not outlive this meta.
+        template<typename T> ArchiveEntryPtr<T> create_entry()
+        {
+            const auto ptr = arena.allocate(sizeof(T), alignof(T));
+            return ArchiveEntryPtr<T>(
+                new (ptr) T(), ArchiveEntryDeleter(false));
+        }
+
+        algo::Arena arena;
+        std::vector<ArchiveEntryPtr<ArchiveEntry>> entries;
     };
 
+    // Returns a part of the archive that is stored as-is. Rather than being
+    // read up front, the data is accessed through a view of the archive, so
+    // that file savers can copy it directly from the source file.
+    std::unique_ptr<io::File> read_stored_file(
+        io::File &input_file,
+        const io::path &path,
+        const uoff_t offset,
+        const uoff_t size);
+
     class BaseArchiveDecoder : public BaseDecoder
     {
     public:
@@ -39,3 +39,21 @@ res::Audio BaseAudioDecoder::decode(const Logger &logger, io::File &file) const
     file.stream.seek(0);
     return decode_impl(logger, file);
 }
+
+void BaseAudioDecoder::decode(
+    const Logger &logger, io::File &file, res::IAudioSink &output_sink) const
+{
+    if (!is_recognized(file))
+        throw err::RecognitionError();
+    file.stream.seek(0);
+    decode_stream_impl(logger, file, output_sink);
+}
+
+void BaseAudioDecoder::decode_stream_impl(
+    const Logger &logger, io::File &file, res::IAudioSink &output_sink) const
+{
+    const auto audio = decode_impl(logger, file);
+    output_sink.begin(audio);
+    if (!audio.samples.empty())
+        output_sink.write(audio.samples);
+}
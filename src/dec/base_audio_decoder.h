@@ -34,9 +34,22 @@ namespace dec {
 
         res::Audio decode(const Logger &logger, io::File &input_file) const;
 
+        void decode(
+            const Logger &logger,
+            io::File &input_file,
+            res::IAudioSink &output_sink) const;
+
     protected:
         virtual res::Audio decode_impl(
             const Logger &logger, io::File &input_file) const = 0;
+
+        // By default decodes the whole track and passes it in one piece.
+        // Decoders that can produce samples block by block should override
+        // this to keep memory usage bounded for long tracks.
+        virtual void decode_stream_impl(
+            const Logger &logger,
+            io::File &input_file,
+            res::IAudioSink &output_sink) const;
     };
 
 } }
@@ -17,6 +17,8 @@
 
 #include "dec/bgi/cbg/cbg2_decoder.h"
 #include <array>
+#include "algo/image/idct.h"
+#include "algo/image/ycbcr.h"
 #include "algo/range.h"
 #include "dec/bgi/cbg/cbg_common.h"
 #include "err.h"
@@ -45,174 +47,22 @@ static int jpeg_zigzag_order[block_dim2] =
 
 namespace
 {
-    using FloatTable = std::array<float, block_dim2>;
+    using FloatTable = std::array<f32, block_dim2>;
     using FloatTablePair = std::array<FloatTable, 2>;
-    using FloatTableTriplet = std::array<FloatTable, 3>;
+    using ByteTable = std::array<u8, block_dim2>;
 }
 
 static FloatTablePair read_ac_mul_pair(const bstr &input)
 {
-    static const FloatTable dc_table =
-    {
-        1.0f,      1.38704f,  1.30656f,  1.17588f,
-        1.0f,      0.785695f, 0.541196f, 0.275899f,
-        1.38704f,  1.92388f,  1.81225f,  1.63099f,
-        1.38704f,  1.08979f,  0.750661f, 0.382683f,
-        1.30656f,  1.81225f,  1.70711f,  1.53636f,
-        1.30656f,  1.02656f,  0.707107f, 0.36048f,
-        1.17588f,  1.63099f,  1.53636f,  1.38268f,
-        1.17588f,  0.92388f,  0.636379f, 0.324423f,
-        1.0f,      1.38704f,  1.30656f,  1.17588f,
-        1.0f,      0.785695f, 0.541196f, 0.275899f,
-        0.785695f, 1.08979f,  1.02656f,  0.92388f,
-        0.785695f, 0.617317f, 0.425215f, 0.216773f,
-        0.541196f, 0.750661f, 0.707107f, 0.636379f,
-        0.541196f, 0.425215f, 0.292893f, 0.149316f,
-        0.275899f, 0.382683f, 0.36048f,  0.324423f,
-        0.275899f, 0.216773f, 0.149316f, 0.0761205f
-    };
-
+    if (input.size() < 2 * block_dim2)
+        throw err::EofError();
     FloatTablePair ac_mul_pair;
-    io::MemoryByteStream input_stream(input);
     for (const auto i : algo::range(ac_mul_pair.size()))
-        for (const auto j : algo::range(dc_table.size()))
-            ac_mul_pair[i][j] = input_stream.read<u8>() * dc_table[j];
-    return ac_mul_pair;
-}
-
-static s16 jpeg_ftoi(float result)
-{
-    int a = 0x80 + ((static_cast<int>(result)) >> 3);
-    if (a < 0)
-        return 0;
-    if (a < 0xFF)
-        return static_cast<s16>(a);
-    if (a < 0x180)
-        return 0xFF;
-    return 0;
-}
-
-static void jpeg_dct_float(
-    FloatTable &output, const u16 *ac, const FloatTable &ac_mul)
-{
-    s16 inptr[block_dim2];
-    float dv[block_dim2];
-    float tp[block_dim2];
-    float tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
-    float tmp10, tmp11, tmp12, tmp13;
-    float z5, z10, z11, z12, z13;
-
-    for (const auto i : algo::range(block_dim2))
     {
-        inptr[i] = ac[i];
-        dv[i] = ac_mul[i];
+        algo::image::make_aan_multipliers(
+            input.get<u8>() + i * block_dim2, ac_mul_pair[i].data());
     }
-
-    for (const auto i : algo::range(block_dim))
-    {
-        if (!inptr[8 + i] && !inptr[16 + i]
-            && !inptr[24 + i] && !inptr[32 + i]
-            && !inptr[40 + i] && !inptr[48 + i]
-            && !inptr[56 + i])
-        {
-            tmp0 = inptr[i] * dv[i];
-            tp[i] = tmp0;
-            tp[8 + i] = tmp0;
-            tp[16 + i] = tmp0;
-            tp[24 + i] = tmp0;
-            tp[32 + i] = tmp0;
-            tp[40 + i] = tmp0;
-            tp[48 + i] = tmp0;
-            tp[56 + i] = tmp0;
-            continue;
-        }
-
-        tmp0 = inptr[i] * dv[i];
-        tmp1 = inptr[16 + i] * dv[16 + i];
-        tmp2 = inptr[32 + i] * dv[32 + i];
-        tmp3 = inptr[48 + i] * dv[48 + i];
-        tmp10 = tmp0 + tmp2;
-        tmp11 = tmp0 - tmp2;
-        tmp13 = tmp1 + tmp3;
-        tmp12 = (tmp1 - tmp3) * 1.414213562f - tmp13;
-        tmp0 = tmp10 + tmp13;
-        tmp3 = tmp10 - tmp13;
-        tmp1 = tmp11 + tmp12;
-        tmp2 = tmp11 - tmp12;
-        tmp4 = inptr[8 + i] * dv[8 + i];
-        tmp5 = inptr[24 + i] * dv[24 + i];
-        tmp6 = inptr[40 + i] * dv[40 + i];
-        tmp7 = inptr[56 + i] * dv[56 + i];
-        z13 = tmp6 + tmp5;
-        z10 = tmp6 - tmp5;
-        z11 = tmp4 + tmp7;
-        z12 = tmp4 - tmp7;
-
-        tmp7 = z11 + z13;
-        tmp11 = (z11 - z13) * 1.414213562f;
-        z5 = (z10 + z12) * 1.847759065f;
-        tmp10 = z12 * 1.082392200f - z5;
-        tmp12 = z10 * (-2.613125930f) + z5;
-
-        tmp6 = tmp12 - tmp7;
-        tmp5 = tmp11 - tmp6;
-        tmp4 = tmp10 + tmp5;
-
-        tp[i] = tmp0 + tmp7;
-        tp[56 + i] = tmp0 - tmp7;
-        tp[8 + i] = tmp1 + tmp6;
-        tp[48 + i] = tmp1 - tmp6;
-        tp[16 + i] = tmp2 + tmp5;
-        tp[40 + i] = tmp2 - tmp5;
-        tp[32 + i] = tmp3 + tmp4;
-        tp[24 + i] = tmp3 - tmp4;
-    }
-
-    for (const auto i : algo::range(block_dim))
-    {
-        z5 = tp[i * block_dim];
-        tmp10 = z5 + tp[block_dim * i + 4];
-        tmp11 = z5 - tp[block_dim * i + 4];
-
-        tmp13 = tp[block_dim * i + 2] + tp[block_dim * i + 6];
-        tmp12 = (tp[block_dim * i + 2] - tp[block_dim * i + 6])
-            * 1.414213562f - tmp13;
-
-        tmp0 = tmp10 + tmp13;
-        tmp3 = tmp10 - tmp13;
-        tmp1 = tmp11 + tmp12;
-        tmp2 = tmp11 - tmp12;
-
-        z13 = tp[block_dim * i + 5] + tp[block_dim * i + 3];
-        z10 = tp[block_dim * i + 5] - tp[block_dim * i + 3];
-        z11 = tp[block_dim * i + 1] + tp[block_dim * i + 7];
-        z12 = tp[block_dim * i + 1] - tp[block_dim * i + 7];
-
-        tmp7 = z11 + z13;
-        tmp11 = (z11 - z13) * 1.414213562f;
-
-        z5 = (z10 + z12) * 1.847759065f;
-        tmp10 = z5 - z12 * 1.082392200f;
-        tmp12 = z5 - z10 * 2.613125930f;
-
-        tmp6 = tmp12 - tmp7;
-        tmp5 = tmp11 - tmp6;
-        tmp4 = tmp10 - tmp5;
-
-        output[i * block_dim] = jpeg_ftoi(tmp0 + tmp7);
-        output[i * block_dim + 7] = jpeg_ftoi(tmp0 - tmp7);
-        output[i * block_dim + 1] = jpeg_ftoi(tmp1 + tmp6);
-        output[i * block_dim + 6] = jpeg_ftoi(tmp1 - tmp6);
-        output[i * block_dim + 2] = jpeg_ftoi(tmp2 + tmp5);
-        output[i * block_dim + 5] = jpeg_ftoi(tmp2 - tmp5);
-        output[i * block_dim + 3] = jpeg_ftoi(tmp3 + tmp4);
-        output[i * block_dim + 4] = jpeg_ftoi(tmp3 - tmp4);
-    }
-}
-
-static u8 get_component(float value)
-{
-    return std::max(0.0f, std::min(255.0f, value));
+    return ac_mul_pair;
 }
 
 static std::vector<u16> decompress_block(
@@ -280,35 +130,24 @@ static void process_24bit_block(
     size_t width,
     u8 *rgb_out)
 {
-    FloatTableTriplet yuv_in;
+    std::array<ByteTable, 3> yuv_in;
     for (const auto i : algo::range(width / block_dim))
     {
         for (const auto channel : algo::range(3))
         {
-            jpeg_dct_float(
-                yuv_in[channel],
-                &color_info[i * block_dim2 + channel * width * block_dim],
-                ac_mul_pair[channel > 0]);
+            algo::image::idct_8x8_float(
+                reinterpret_cast<const s16*>(
+                    &color_info[i * block_dim2 + channel * width * block_dim]),
+                ac_mul_pair[channel > 0].data(),
+                yuv_in[channel].data());
         }
 
-        for (const auto y : algo::range(block_dim))
-        for (const auto x : algo::range(block_dim))
-        {
-            const auto offset = y * block_dim + x;
-            const auto cy = yuv_in[0][offset];
-            const auto cb = yuv_in[1][offset];
-            const auto cr = yuv_in[2][offset];
-
-            const auto r = cy + 1.402f * cr - 178.956f;
-            const auto g
-                = cy + 44.04992f - 0.34414f * cb + 91.90992f - 0.71414f * cr;
-            const auto b = cy + 1.772f * cb - 226.316f;
-
-            u8 *rgb_ptr = &rgb_out[(y * width + x) * 4];
-            rgb_ptr[0] = get_component(b);
-            rgb_ptr[1] = get_component(g);
-            rgb_ptr[2] = get_component(r);
-        }
+        algo::image::ycbcr_to_bgr_8x8_float(
+            yuv_in[0].data(),
+            yuv_in[1].data(),
+            yuv_in[2].data(),
+            rgb_out,
+            width * 4);
         rgb_out += 4 * block_dim;
     }
 }
@@ -321,8 +160,11 @@ static void process_8bit_block(
 {
     for (const auto i : algo::range(width / block_dim))
     {
-        FloatTable color_data;
-        jpeg_dct_float(color_data, &color_info[i * block_dim2], ac_mul_pair[0]);
+        ByteTable color_data;
+        algo::image::idct_8x8_float(
+            reinterpret_cast<const s16*>(&color_info[i * block_dim2]),
+            ac_mul_pair[0].data(),
+            color_data.data());
         for (const auto y : algo::range(block_dim))
         for (const auto x : algo::range(block_dim))
         {
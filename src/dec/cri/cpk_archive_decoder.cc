@@ -16,13 +16,13 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/cri/cpk_archive_decoder.h"
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include "algo/any.h"
 #include "algo/range.h"
-#include "algo/str.h"
 #include "err.h"
 #include "io/memory_byte_stream.h"
-#include "io/msb_bit_stream.h"
 
 using namespace au;
 using namespace au::dec::cri;
@@ -74,6 +74,19 @@ namespace
         u32 flags;
         std::string name;
     };
+
+    class ReverseBitReader final
+    {
+    public:
+        ReverseBitReader(const u8 *input_start, const u8 *input_end);
+        inline u32 read(const size_t bits);
+
+    private:
+        const u8 *input_start;
+        const u8 *input_ptr;
+        u64 buffer;
+        size_t bits_available;
+    };
 }
 
 static bstr decrypt_utf_packet(const bstr &input)
@@ -99,48 +112,84 @@ static bstr read_utf_packet(io::BaseByteStream &input_stream)
         : decrypt_utf_packet(utf_packet);
 }
 
+ReverseBitReader::ReverseBitReader(
+    const u8 *input_start, const u8 *input_end) :
+        input_start(input_start),
+        input_ptr(input_end),
+        buffer(0),
+        bits_available(0)
+{
+}
+
+inline u32 ReverseBitReader::read(const size_t bits)
+{
+    if (bits_available < bits)
+    {
+        while (bits_available <= 56 && input_ptr > input_start)
+        {
+            buffer = (buffer << 8) | *--input_ptr;
+            bits_available += 8;
+        }
+        if (bits_available < bits)
+            throw err::EofError();
+    }
+    bits_available -= bits;
+    return (buffer >> bits_available) & ((1ull << bits) - 1);
+}
+
 static bstr decompress_layla(const bstr &input)
 {
     io::MemoryByteStream input_stream(input);
     input_stream.seek(layla_magic.size());
     const auto size_orig = input_stream.read_le<u32>();
     const auto size_comp = input_stream.read_le<u32>();
-    const auto data_comp = algo::reverse(input_stream.read(size_comp));
+    const auto data_comp_offset = input_stream.pos();
+    input_stream.skip(size_comp);
     const auto prefix = input_stream.read_to_eof();
 
-    io::MsbBitStream bit_stream(data_comp);
-    bstr output;
-    output.reserve(size_orig);
-    while (output.size() < size_orig)
+    bstr output(prefix.size() + size_orig);
+    std::memcpy(output.get<u8>(), prefix.get<u8>(), prefix.size());
+
+    // both the compressed data and the output run from the end to the start,
+    // so matches refer to bytes after the current output position
+    const auto output_start = output.get<u8>() + prefix.size();
+    const auto output_end = output_start + size_orig;
+    auto output_ptr = output_end;
+    ReverseBitReader bit_reader(
+        input.get<const u8>() + data_comp_offset,
+        input.get<const u8>() + data_comp_offset + size_comp);
+
+    static const size_t marker_sizes[] = {2, 3, 5, 8};
+    while (output_ptr > output_start)
     {
-        if (bit_stream.read(1))
+        if (bit_reader.read(1))
         {
-            auto repetitions = 3;
-            auto look_behind = bit_stream.read(13) + 3;
-
-            std::vector<size_t> sizes = {5, 3, 2};
-            while (true)
+            size_t repetitions = 3;
+            const size_t look_behind = bit_reader.read(13) + 3;
+            for (size_t i = 0; ; i = std::min<size_t>(i + 1, 3))
             {
-                size_t size = 8;
-                if (!sizes.empty())
-                {
-                    size = sizes.back();
-                    sizes.pop_back();
-                }
-                const auto marker = bit_stream.read(size);
+                const auto size = marker_sizes[i];
+                const auto marker = bit_reader.read(size);
                 repetitions += marker;
                 if (marker != (1u << size) - 1)
                     break;
             }
 
+            if (look_behind > static_cast<size_t>(output_end - output_ptr))
+                throw err::BadDataOffsetError();
+            repetitions = std::min<size_t>(
+                repetitions, output_ptr - output_start);
             while (repetitions--)
-                output += output.at(output.size() - look_behind);
+            {
+                --output_ptr;
+                *output_ptr = output_ptr[look_behind];
+            }
         }
         else
-            output += static_cast<u8>(bit_stream.read(8));
+            *--output_ptr = bit_reader.read(8);
     }
 
-    return prefix + algo::reverse(output);
+    return output;
 }
 
 static std::vector<Row> parse_utf_packet(const bstr &utf_packet)
@@ -390,10 +439,11 @@ std::unique_ptr<dec::ArchiveMeta> CpkArchiveDecoder::read_meta_impl(
         read_etoc(input_file.stream, header.at("EtocOffset").get<u64>(), toc);
 
     auto meta = std::make_unique<ArchiveMeta>();
+    meta->entries.reserve(toc.size());
     for (const auto &kv : toc)
     {
         const auto &toc_entry = kv.second;
-        auto entry = std::make_unique<PlainArchiveEntry>();
+        auto entry = meta->create_entry<PlainArchiveEntry>();
         entry->path = toc_entry.dir_name;
         entry->path /= toc_entry.file_name;
         entry->offset = toc_entry.file_offset;
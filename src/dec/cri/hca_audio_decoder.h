@@ -29,6 +29,10 @@ namespace cri {
         bool is_recognized_impl(io::File &input_file) const override;
         res::Audio decode_impl(
             const Logger &logger, io::File &input_file) const override;
+        void decode_stream_impl(
+            const Logger &logger,
+            io::File &input_file,
+            res::IAudioSink &output_sink) const override;
     };
 
 } } }
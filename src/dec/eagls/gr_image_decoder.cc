@@ -18,7 +18,6 @@
 #include "dec/eagls/gr_image_decoder.h"
 #include "algo/crypt/lcg.h"
 #include "algo/pack/lzss.h"
-#include "algo/range.h"
 #include "dec/microsoft/bmp_image_decoder.h"
 #include "io/memory_byte_stream.h"
 
@@ -56,8 +55,8 @@ res::Image GrImageDecoder::decode_impl(
     const auto seed = input_file.stream.read<u8>() ^ xor_value;
 
     algo::crypt::Lcg lcg(algo::crypt::LcgKind::ParkMillerRevised, seed);
-    for (const auto i : algo::range(0, std::min<size_t>(0x174B, data.size())))
-        data[i] ^= key[lcg.next() % key.size()];
+    lcg.xor_with_key(
+        data.get<u8>(), std::min<size_t>(0x174B, data.size()), key);
 
     const auto output_size = guess_output_size(data);
     data = algo::pack::lzss_decompress(data, output_size);
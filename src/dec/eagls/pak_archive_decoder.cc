@@ -18,7 +18,6 @@
 #include "dec/eagls/pak_archive_decoder.h"
 #include "algo/crypt/lcg.h"
 #include "algo/locale.h"
-#include "algo/range.h"
 #include "io/file_byte_stream.h"
 #include "io/file_system.h"
 #include "io/memory_byte_stream.h"
@@ -50,8 +49,7 @@ std::unique_ptr<dec::ArchiveMeta> PakArchiveDecoder::read_meta_impl(
     auto data = index_stream.read(index_stream.size() - 4);
     const auto seed = index_stream.read_le<u32>();
     algo::crypt::Lcg lcg(algo::crypt::LcgKind::MicrosoftVisualC, seed);
-    for (const auto i : algo::range(data.size()))
-        data[i] ^= key[lcg.next() % key.size()];
+    lcg.xor_with_key(data.get<u8>(), data.size(), key);
 
     io::MemoryByteStream data_stream(data);
     uoff_t min_offset = std::numeric_limits<uoff_t>::max();
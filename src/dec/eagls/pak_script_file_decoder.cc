@@ -61,8 +61,7 @@ std::unique_ptr<io::File> PakScriptFileDecoder::decode_impl(
     auto data = input_file.stream.read(input_file.stream.size() - offset - 1);
     const s8 seed = input_file.stream.read<u8>();
     algo::crypt::Lcg lcg(algo::crypt::LcgKind::MicrosoftVisualC, seed);
-    for (const auto i : algo::range(0, data.size(), 2))
-        data[i] ^= key[lcg.next() % key.size()];
+    lcg.xor_with_key(data.get<u8>(), data.size(), key, 2);
 
     auto output_file = std::make_unique<io::File>(input_file.path, data);
     output_file->path.change_extension("txt");
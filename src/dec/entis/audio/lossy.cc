@@ -17,6 +17,7 @@
 
 #include "dec/entis/audio/lossy.h"
 #include <cmath>
+#include <mutex>
 #include "algo/range.h"
 #include "dec/entis/common/gamma_decoder.h"
 #include "dec/entis/common/huffman_decoder.h"
@@ -70,6 +71,11 @@ namespace
     };
 }
 
+// = sin/cos(code * pi / 8) for every possible 4-bit revolve code
+static EriSinCos revolve_code_matrix[16];
+
+static std::once_flag tables_initialized;
+
 struct LossyAudioDecoder::Priv final
 {
     Priv(const MioHeader &header);
@@ -121,10 +127,11 @@ struct LossyAudioDecoder::Priv final
     size_t subband_degree;
     size_t degree_num;
     std::vector<EriSinCos> revolve_param;
+    std::vector<EriSinCos> revolve_param_cache[max_dct_degree + 1];
     size_t frequency_point[7];
 };
 
-static void init_dct_of_k_matrix()
+static void init_tables()
 {
     for (const auto i : algo::range(1, max_dct_degree))
     {
@@ -139,28 +146,28 @@ static void init_dct_of_k_matrix()
             ir += dr;
         }
     }
-}
 
-static int round32(const f32 r)
-{
-    return (r >= 0.0)
-        ? static_cast<int>(floor(r + 0.5))
-        : static_cast<int>(ceil(r - 0.5));
+    for (const auto i : algo::range(16))
+    {
+        revolve_code_matrix[i].rsin = static_cast<f32>(std::sin(i * pi / 8));
+        revolve_code_matrix[i].rcos = static_cast<f32>(std::cos(i * pi / 8));
+    }
 }
 
 static void round32_array(
     s16 *output, const int step, const f32 *source, const size_t size)
 {
+    // Rounds half away from zero and saturates to s16. Written without
+    // branches so that the compiler can vectorize it; clamping happens
+    // before the conversion, which yields the same results as clamping the
+    // converted integer.
     for (const auto i : algo::range(size))
     {
-        int value = round32(*source++);
-        if (value <= -0x8000)
-            *output = -0x8000;
-        else if (value >= 0x7FFF)
-            *output = 0x7FFF;
-        else
-            *output = value;
-        output += step;
+        const f64 r = source[i];
+        f64 value = r >= 0.0 ? r + 0.5 : r - 0.5;
+        value = value < -32768.0 ? -32768.0 : value;
+        value = value > 32767.0 ? 32767.0 : value;
+        output[i * step] = static_cast<s16>(static_cast<int>(value));
     }
 }
 
@@ -448,7 +455,12 @@ LossyAudioDecoder::Priv::~Priv()
 void LossyAudioDecoder::Priv::initialize_with_degree(
     const size_t subband_degree)
 {
-    revolve_param = create_revolve_param(subband_degree);
+    // the division code may change every few blocks, so don't recompute
+    // the parameters each time
+    auto &cached_revolve_param = revolve_param_cache[subband_degree];
+    if (cached_revolve_param.empty())
+        cached_revolve_param = create_revolve_param(subband_degree);
+    revolve_param = cached_revolve_param;
     static const int freq_width[7] = {-6, -6, -5, -4, -3, -2, -1};
     auto j = 0;
     for (const auto i : algo::range(7))
@@ -779,8 +791,8 @@ void LossyAudioDecoder::Priv::decode_lead_block_mss()
     const auto rev_code = *rev_code_ptr++;
     auto lap_buf1 = last_dct.get();
     auto lap_buf2 = last_dct.get() + degree_num;
-    const auto rsin = static_cast<f32>(std::sin(rev_code * pi / 8));
-    const auto rcos = static_cast<f32>(std::cos(rev_code * pi / 8));
+    const auto rsin = revolve_code_matrix[rev_code].rsin;
+    const auto rcos = revolve_code_matrix[rev_code].rcos;
     revolve_2x2(lap_buf1, lap_buf2, rsin, rcos, 1, degree_num);
     lap_buf = last_dct.get();
     for (const auto i : algo::range(2))
@@ -814,8 +826,8 @@ void LossyAudioDecoder::Priv::decode_post_block_mss(
     const auto rev_code = *rev_code_ptr++;
     auto matrix_ptr1 = matrix_buf.get();
     auto matrix_ptr2 = matrix_buf.get() + degree_num;
-    const auto rsin = static_cast<f32>(std::sin(rev_code * pi / 8));
-    const auto rcos = static_cast<f32>(std::cos(rev_code * pi / 8));
+    const auto rsin = revolve_code_matrix[rev_code].rsin;
+    const auto rcos = revolve_code_matrix[rev_code].rcos;
     revolve_2x2(matrix_ptr1, matrix_ptr2, rsin, rcos, 1, degree_num);
     matrix_ptr = matrix_buf.get();
     for (const auto i : algo::range(2))
@@ -855,11 +867,11 @@ void LossyAudioDecoder::Priv::decode_internal_block_mss(
     f32 rsin, rcos;
     f32 *matrix_ptr1 = matrix_buf.get();
     f32 *matrix_ptr2 = matrix_buf.get() + degree_num;
-    rsin = static_cast<f32>(std::sin(rev_code1 * pi / 8));
-    rcos = static_cast<f32>(std::cos(rev_code1 * pi / 8));
+    rsin = revolve_code_matrix[rev_code1].rsin;
+    rcos = revolve_code_matrix[rev_code1].rcos;
     revolve_2x2(matrix_ptr1, matrix_ptr2, rsin, rcos, 2, degree_num / 2);
-    rsin = static_cast<f32>(std::sin(rev_code2 * pi / 8));
-    rcos = static_cast<f32>(std::cos(rev_code2 * pi / 8));
+    rsin = revolve_code_matrix[rev_code2].rsin;
+    rcos = revolve_code_matrix[rev_code2].rcos;
     revolve_2x2(matrix_ptr1+1, matrix_ptr2+1, rsin, rcos, 2, degree_num / 2);
 
     matrix_ptr = matrix_buf.get();
@@ -1043,7 +1055,7 @@ bstr LossyAudioDecoder::Priv::decode_dct_mss(const MioChunk &chunk)
 LossyAudioDecoder::LossyAudioDecoder(const MioHeader &header)
     : p(new Priv(header))
 {
-    init_dct_of_k_matrix();
+    std::call_once(tables_initialized, init_tables);
     if (header.architecture == common::Architecture::RunLengthGamma)
     {
         // this is nonsense but hey, I just reimplement stuff
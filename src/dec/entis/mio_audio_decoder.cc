@@ -86,6 +86,16 @@ bool MioAudioDecoder::is_recognized_impl(io::File &input_file) const
 
 res::Audio MioAudioDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
+{
+    res::AudioBuffer output_buffer;
+    decode_stream_impl(logger, input_file, output_buffer);
+    return output_buffer.audio;
+}
+
+void MioAudioDecoder::decode_stream_impl(
+    const Logger &logger,
+    io::File &input_file,
+    res::IAudioSink &output_sink) const
 {
     input_file.stream.seek(0x40);
 
@@ -107,16 +117,14 @@ res::Audio MioAudioDecoder::decode_impl(
             "Transformation type %d not supported", header.transformation));
     }
 
-    bstr samples;
-    for (const auto chunk : chunks)
-        samples += impl->process_chunk(chunk);
+    res::Audio format;
+    format.channel_count = header.channel_count;
+    format.bits_per_sample = header.bits_per_sample;
+    format.sample_rate = header.sample_rate;
+    output_sink.begin(format);
 
-    res::Audio audio;
-    audio.channel_count = header.channel_count;
-    audio.bits_per_sample = header.bits_per_sample;
-    audio.sample_rate = header.sample_rate;
-    audio.samples = samples;
-    return audio;
+    for (const auto &chunk : chunks)
+        output_sink.write(impl->process_chunk(chunk));
 }
 
 static auto _ = dec::register_decoder<MioAudioDecoder>("entis/mio");
@@ -27,15 +27,7 @@ using namespace au::dec::kirikiri;
 
 namespace
 {
-    struct InfoChunk final
-    {
-        u32 flags;
-        size_t file_size_orig;
-        size_t file_size_comp;
-        std::string name;
-    };
-
-    struct SegmChunk final
+    struct Segment final
     {
         u32 flags;
         uoff_t offset;
@@ -43,27 +35,18 @@ namespace
         size_t size_comp;
     };
 
-    struct AdlrChunk final
-    {
-        u32 key;
-    };
-
-    struct TimeChunk final
-    {
-        u64 timestamp;
-    };
-
     struct CustomArchiveMeta final : dec::ArchiveMeta
     {
         Xp3DecryptFunc decrypt_func;
+        // segments of all the entries, in table order
+        std::vector<Segment> segments;
     };
 
     struct CustomArchiveEntry final : dec::ArchiveEntry
     {
-        std::unique_ptr<InfoChunk> info_chunk;
-        std::vector<std::unique_ptr<SegmChunk>> segm_chunks;
-        std::unique_ptr<AdlrChunk> adlr_chunk;
-        std::unique_ptr<TimeChunk> time_chunk;
+        u32 key;
+        size_t first_segment;
+        size_t segment_count;
     };
 }
 
@@ -101,50 +84,28 @@ static uoff_t get_table_offset(
     return input_stream.read_le<u64>();
 }
 
-static std::unique_ptr<InfoChunk> read_info_chunk(
-    io::BaseByteStream &chunk_stream)
+static std::string read_info_chunk(io::BaseByteStream &chunk_stream)
 {
-    auto info_chunk = std::make_unique<InfoChunk>();
-    info_chunk->flags = chunk_stream.read_le<u32>();
-    info_chunk->file_size_orig = chunk_stream.read_le<u64>();
-    info_chunk->file_size_comp = chunk_stream.read_le<u64>();
-
+    chunk_stream.skip(4); // flags
+    chunk_stream.skip(8); // original file size
+    chunk_stream.skip(8); // compressed file size
     const auto file_name_size = chunk_stream.read_le<u16>();
     const auto name = chunk_stream.read(file_name_size * 2);
-    info_chunk->name = algo::utf16_to_utf8(name).str();
-    return info_chunk;
+    return algo::utf16_to_utf8(name).str();
 }
 
-static std::vector<std::unique_ptr<SegmChunk>> read_segm_chunks(
-    io::BaseByteStream &chunk_stream)
+static void read_segm_chunk(
+    io::BaseByteStream &chunk_stream, std::vector<Segment> &segments)
 {
-    std::vector<std::unique_ptr<SegmChunk>> segm_chunks;
     while (chunk_stream.left())
     {
-        auto segm_chunk = std::make_unique<SegmChunk>();
-        segm_chunk->flags = chunk_stream.read_le<u32>();
-        segm_chunk->offset = chunk_stream.read_le<u64>();
-        segm_chunk->size_orig = chunk_stream.read_le<u64>();
-        segm_chunk->size_comp = chunk_stream.read_le<u64>();
-        segm_chunks.push_back(std::move(segm_chunk));
+        Segment segment;
+        segment.flags = chunk_stream.read_le<u32>();
+        segment.offset = chunk_stream.read_le<u64>();
+        segment.size_orig = chunk_stream.read_le<u64>();
+        segment.size_comp = chunk_stream.read_le<u64>();
+        segments.push_back(segment);
     }
-    return segm_chunks;
-}
-
-static std::unique_ptr<AdlrChunk> read_adlr_chunk(
-    io::BaseByteStream &chunk_stream)
-{
-    auto adlr_chunk = std::make_unique<AdlrChunk>();
-    adlr_chunk->key = chunk_stream.read_le<u32>();
-    return adlr_chunk;
-}
-
-static std::unique_ptr<TimeChunk> read_time_chunk(
-    io::BaseByteStream &chunk_stream)
-{
-    auto time_chunk = std::make_unique<TimeChunk>();
-    time_chunk->timestamp = chunk_stream.read_le<u64>();
-    return time_chunk;
 }
 
 static void read_hnfn_entry(
@@ -165,12 +126,17 @@ static void read_elif_entry(
     fn_map[hash] = algo::utf16_to_utf8(input_stream.read(name_size * 2)).str();
 }
 
-static std::unique_ptr<CustomArchiveEntry> read_file_entry(
+static dec::ArchiveEntryPtr<CustomArchiveEntry> read_file_entry(
     const Logger &logger,
     io::BaseByteStream &input_stream,
-    const std::map<u32, std::string> &fn_map)
+    const std::map<u32, std::string> &fn_map,
+    CustomArchiveMeta &meta)
 {
-    auto entry = std::make_unique<CustomArchiveEntry>();
+    auto entry = meta.create_entry<CustomArchiveEntry>();
+    entry->first_segment = meta.segments.size();
+    std::string name;
+    bool info_chunk_found = false;
+    bool adlr_chunk_found = false;
     while (input_stream.left())
     {
         const auto chunk_magic = input_stream.read(4);
@@ -178,13 +144,25 @@ static std::unique_ptr<CustomArchiveEntry> read_file_entry(
         io::MemoryByteStream chunk_stream(input_stream.read(chunk_size));
 
         if (chunk_magic == info_chunk_magic)
-            entry->info_chunk = read_info_chunk(chunk_stream);
+        {
+            name = read_info_chunk(chunk_stream);
+            info_chunk_found = true;
+        }
         else if (chunk_magic == segm_chunk_magic)
-            entry->segm_chunks = read_segm_chunks(chunk_stream);
+        {
+            // a repeated chunk replaces the previous one
+            meta.segments.resize(entry->first_segment);
+            read_segm_chunk(chunk_stream, meta.segments);
+        }
         else if (chunk_magic == adlr_chunk_magic)
-            entry->adlr_chunk = read_adlr_chunk(chunk_stream);
+        {
+            entry->key = chunk_stream.read_le<u32>();
+            adlr_chunk_found = true;
+        }
         else if (chunk_magic == time_chunk_magic)
-            entry->time_chunk = read_time_chunk(chunk_stream);
+        {
+            chunk_stream.skip(8); // timestamp
+        }
         else
         {
             logger.warn("Unknown chunk '%s'\n", chunk_magic.c_str());
@@ -200,17 +178,16 @@ static std::unique_ptr<CustomArchiveEntry> read_file_entry(
     if (input_stream.left())
         throw err::CorruptDataError("FILE entry contains data beyond EOF");
 
-    if (!entry->info_chunk)
+    entry->segment_count = meta.segments.size() - entry->first_segment;
+    if (!info_chunk_found)
         throw err::CorruptDataError("INFO chunk not found");
-    if (!entry->adlr_chunk)
+    if (!adlr_chunk_found)
         throw err::CorruptDataError("ADLR chunk not found");
-    if (entry->segm_chunks.empty())
+    if (!entry->segment_count)
         throw err::CorruptDataError("No SEGM chunks found");
 
-    entry->path = fn_map.find(entry->adlr_chunk->key) != fn_map.end()
-        ? fn_map.at(entry->adlr_chunk->key)
-        : entry->info_chunk->name;
-
+    const auto it = fn_map.find(entry->key);
+    entry->path = it != fn_map.end() ? it->second : name;
     return entry;
 }
 
@@ -250,7 +227,7 @@ std::unique_ptr<dec::ArchiveMeta> Xp3ArchiveDecoder::read_meta_impl(
 
         if (entry_magic == file_entry_magic)
             meta->entries.push_back(
-                read_file_entry(logger, entry_stream, fn_map));
+                read_file_entry(logger, entry_stream, fn_map, *meta));
         else if (entry_magic == hnfn_entry_magic)
             read_hnfn_entry(entry_stream, fn_map);
         else if (entry_magic == elif_entry_magic)
@@ -271,18 +248,19 @@ std::unique_ptr<io::File> Xp3ArchiveDecoder::read_file_impl(
     const auto entry = static_cast<const CustomArchiveEntry*>(&e);
 
     bstr data;
-    for (const auto &segm_chunk : entry->segm_chunks)
+    for (const auto i : algo::range(entry->segment_count))
     {
-        const auto data_is_compressed = segm_chunk->flags & 7;
-        input_file.stream.seek(segm_chunk->offset);
+        const auto &segment = meta->segments[entry->first_segment + i];
+        const auto data_is_compressed = segment.flags & 7;
+        input_file.stream.seek(segment.offset);
         data += data_is_compressed
             ? algo::pack::zlib_inflate(
-                input_file.stream.read(segm_chunk->size_comp))
-            : input_file.stream.read(segm_chunk->size_orig);
+                input_file.stream.read(segment.size_comp))
+            : input_file.stream.read(segment.size_orig);
     }
 
     if (meta->decrypt_func)
-        meta->decrypt_func(data, entry->adlr_chunk->key);
+        meta->decrypt_func(data, entry->key);
 
     return std::make_unique<io::File>(entry->path, data);
 }
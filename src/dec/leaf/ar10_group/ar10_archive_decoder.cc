@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/leaf/ar10_group/ar10_archive_decoder.h"
+#include "algo/crypt/repeating_key.h"
 #include "algo/locale.h"
 #include "algo/range.h"
 
@@ -76,9 +77,7 @@ std::unique_ptr<io::File> Ar10ArchiveDecoder::read_file_impl(
     const auto key_size = input_file.stream.read<u8>() ^ meta->archive_key;
     const auto key = input_file.stream.read(key_size);
     auto data = input_file.stream.read(data_size);
-
-    for (const auto i : algo::range(data.size()))
-        data[i] ^= key[i % key.size()];
+    algo::crypt::RepeatingKey(key).xor_data(data.get<u8>(), data.size());
 
     auto output_file = std::make_unique<io::File>(entry->path, data);
     output_file->guess_extension();
@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/leaf/leafpack_group/leafpack_archive_decoder.h"
+#include "algo/crypt/repeating_key.h"
 #include "algo/range.h"
 #include "algo/str.h"
 #include "err.h"
@@ -28,8 +29,7 @@ static const bstr magic = "LEAFPACK"_b;
 
 static void decrypt(bstr &data, const bstr &key)
 {
-    for (const auto i : algo::range(data.size()))
-        data[i] -= key[i % key.size()];
+    algo::crypt::RepeatingKey(key).sub_data(data.get<u8>(), data.size());
 }
 
 LeafpackArchiveDecoder::LeafpackArchiveDecoder()
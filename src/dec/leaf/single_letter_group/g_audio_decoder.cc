@@ -16,7 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/leaf/single_letter_group/g_audio_decoder.h"
-#include "algo/crypt/crc32.h"
+#include "algo/hash/crc.h"
 #include "algo/range.h"
 #include "err.h"
 
@@ -45,7 +45,7 @@ static void write_page(io::BaseByteStream &output_stream, bstr &page)
     page[0x17] = 0;
     page[0x18] = 0;
     page[0x19] = 0;
-    const auto crc = algo::crypt::crc32(page);
+    const auto crc = algo::hash::crc32(page);
     page[0x16] = crc >> 24;
     page[0x17] = crc >> 16;
     page[0x18] = crc >> 8;
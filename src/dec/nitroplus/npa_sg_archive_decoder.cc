@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/nitroplus/npa_sg_archive_decoder.h"
+#include "algo/crypt/repeating_key.h"
 #include "algo/locale.h"
 #include "algo/range.h"
 #include "err.h"
@@ -24,12 +25,12 @@
 using namespace au;
 using namespace au::dec::nitroplus;
 
-static const bstr key = "\xBD\xAA\xBC\xB4\xAB\xB6\xBC\xB4"_b;
+static const algo::crypt::RepeatingKey key(
+    "\xBD\xAA\xBC\xB4\xAB\xB6\xBC\xB4"_b);
 
 static void decrypt(bstr &data)
 {
-    for (const auto i : algo::range(data.size()))
-        data[i] ^= key[i % key.size()];
+    key.xor_data(data.get<u8>(), data.size());
 }
 
 bool NpaSgArchiveDecoder::is_recognized_impl(io::File &input_file) const
@@ -91,9 +91,14 @@ std::unique_ptr<io::File> NsaArchiveDecoder::read_file_impl(
     const dec::ArchiveMeta &m,
     const dec::ArchiveEntry &e) const
 {
-    NsaEncryptedStream input_stream(input_file.stream, key);
-
     const auto entry = static_cast<const CustomArchiveEntry*>(&e);
+    if (entry->compression_type == CompressionType::None && key.empty())
+    {
+        return read_stored_file(
+            input_file, entry->path, entry->offset, entry->size_comp);
+    }
+
+    NsaEncryptedStream input_stream(input_file.stream, key);
     const auto data = input_stream
         .seek(entry->offset)
         .read(entry->size_comp);
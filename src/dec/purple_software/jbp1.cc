@@ -17,6 +17,8 @@
 
 #include "dec/purple_software/jbp1.h"
 #include <array>
+#include "algo/image/idct.h"
+#include "algo/image/ycbcr.h"
 #include "algo/range.h"
 #include "err.h"
 #include "io/memory_byte_stream.h"
@@ -157,201 +159,6 @@ static int read_from_tree(const Tree &tree, io::BaseBitStream &bit_stream)
     return ret;
 }
 
-static void dct(
-    std::array<s16, 64> &dct_table, const std::array<s16, 64> &quant)
-{
-    long a, b, c, d;
-    long w, x, y, z;
-    long s, t, u, v, n;
-
-    auto lp1 = dct_table.data();
-    auto lp2 = quant.data();
-
-    for (const auto i : algo::range(8))
-    {
-        if (lp1[0x08] == 0 &&
-            lp1[0x10] == 0 &&
-            lp1[0x18] == 0 &&
-            lp1[0x20] == 0 &&
-            lp1[0x28] == 0 &&
-            lp1[0x30] == 0 &&
-            lp1[0x38] == 0)
-        {
-            lp1[0x00] =
-            lp1[0x08] =
-            lp1[0x10] =
-            lp1[0x18] =
-            lp1[0x20] =
-            lp1[0x28] =
-            lp1[0x30] =
-            lp1[0x38] = lp1[0] * lp2[0];
-        }
-
-        else
-        {
-            c = lp2[0x10] * lp1[0x10];
-            d = lp2[0x30] * lp1[0x30];
-            x = ((c + d) * 35467) >> 16;
-            c = ((c * 50159) >> 16) + x;
-            d = ((d * -121094) >> 16) + x;
-            a = lp1[0x00] * lp2[0x00];
-            b = lp1[0x20] * lp2[0x20];
-            w = a + b + c;
-            x = a + b - c;
-            y = a - b + d;
-            z = a - b - d;
-
-            c = lp1[0x38] * lp2[0x38];
-            d = lp1[0x28] * lp2[0x28];
-            a = lp1[0x18] * lp2[0x18];
-            b = lp1[0x08] * lp2[0x08];
-            n = ((a + b + c + d) * 77062) >> 16;
-
-            u = n
-                + ((c * 19571) >> 16)
-                + (((c + a) * -128553) >> 16)
-                + (((c + b) * -58980) >> 16);
-            v = n
-                + ((d * 134553) >> 16)
-                + (((d + b) * -25570) >> 16)
-                + (((d + a) * -167963) >> 16);
-            t = n
-                + ((b * 98390) >> 16)
-                + (((d + b) * -25570) >> 16)
-                + (((c + b) * -58980) >> 16);
-            s = n
-                + ((a * 201373) >> 16)
-                + (((c + a) * -128553) >> 16)
-                + (((d + a) * -167963) >> 16);
-
-            lp1[0x00] = w + t;
-            lp1[0x38] = w - t;
-            lp1[0x08] = y + s;
-            lp1[0x30] = y - s;
-            lp1[0x10] = z + v;
-            lp1[0x28] = z - v;
-            lp1[0x18] = x + u;
-            lp1[0x20] = x - u;
-        }
-
-        lp1++;
-        lp2++;
-    }
-
-    lp1 = dct_table.data();
-
-    for (const auto i : algo::range(8))
-    {
-        a = lp1[0];
-        c = lp1[2];
-        b = lp1[4];
-        d = lp1[6];
-        x = (((c + d) * 35467) >> 16);
-        c = ((c * 50159) >> 16) + x;
-        d = ((d * -121094) >> 16) + x;
-        w = a + b + c;
-        x = a + b - c;
-        y = a - b + d;
-        z = a - b - d;
-
-        d = lp1[5];
-        b = lp1[1];
-        c = lp1[7];
-        a = lp1[3];
-        n = (((a + b + c + d) * 77062) >> 16);
-
-        s = n + ((a * 201373) >> 16)
-              + (((a + c) * -128553) >> 16)
-              + (((a + d) * -167963) >> 16);
-
-        t = n + ((b * 98390) >> 16)
-              + (((b + d) * -25570) >> 16)
-              + (((b + c) * -58980) >> 16);
-
-        u = n + ((c * 19571) >> 16)
-              + (((b + c) * -58980) >> 16)
-              + (((a + c) * -128553) >> 16);
-
-        v = n + ((d * 134553) >> 16)
-              + (((b + d) * -25570) >> 16)
-              + (((a + d) * -167963) >> 16);
-
-        lp1[0] = (w + t) >> 3;
-        lp1[7] = (w - t) >> 3;
-        lp1[1] = (y + s) >> 3;
-        lp1[6] = (y - s) >> 3;
-        lp1[2] = (z + v) >> 3;
-        lp1[5] = (z - v) >> 3;
-        lp1[3] = (x + u) >> 3;
-        lp1[4] = (x - u) >> 3;
-
-        lp1 += 8;
-    }
-}
-
-static void ycc2rgb(u8 *dc, u8 *ac, short *iy, short *cbcr, const size_t stride)
-{
-    static bool initialized = false;
-    static std::array<u8, 0x300> lookup_table;
-
-    if (!initialized)
-    {
-        for (const auto n : algo::range(0x100))
-            lookup_table[n] = 0;
-
-        for (const auto n : algo::range(0x100))
-            lookup_table[n + 0x100] = n;
-
-        for (const auto n : algo::range(0x100))
-            lookup_table[n + 0x200] = 0xFF;
-
-        initialized = true;
-    }
-
-    for (const auto y : algo::range(4))
-    {
-        for (const auto x : algo::range(4))
-        {
-            const auto c = cbcr[0];
-            const auto d = cbcr[-64];
-            const auto r = ((c * 0x166F0) >> 16);
-            const auto g = ((d * 0x5810) >> 16) + ((c * 0xB6C0) >> 16);
-            const auto b = ((d * 0x1C590) >> 16);
-            const auto cw = iy[1] + 0x180;
-            const auto cx = iy[0] + 0x180;
-            const auto cy = iy[8] + 0x180;
-            const auto cz = iy[9] + 0x180;
-
-            dc[0]          = lookup_table.at(cx + b);
-            ac[4 - stride] = lookup_table.at(cw + b);
-            ac[0]          = lookup_table.at(cy + b);
-            ac[4]          = lookup_table.at(cz + b);
-            ac[1 - stride] = lookup_table.at(cx - g);
-            ac[5 - stride] = lookup_table.at(cw - g);
-            ac[1]          = lookup_table.at(cy - g);
-            ac[5]          = lookup_table.at(cz - g);
-            ac[2 - stride] = lookup_table.at(cx + r);
-            ac[6 - stride] = lookup_table.at(cw + r);
-            ac[2]          = lookup_table.at(cy + r);
-            ac[6]          = lookup_table.at(cz + r);
-            iy += 2;
-            dc += 8;
-            ac += 8;
-            cbcr++;
-        }
-
-        cbcr -= 4;
-        dc -= 8 * 4;
-        ac -= 8 * 4;
-
-        dc += stride * 2;
-        ac += stride * 2;
-
-        iy += 8;
-        cbcr += 8;
-    }
-}
-
 static bstr decode_blocks(
     const BasicInfo &info,
     const bstr &tree_input,
@@ -394,9 +201,7 @@ static bstr decode_blocks(
 
     for (const auto y : algo::range(info.y_block_count))
     {
-        auto target_base = &block_output[(info.blocks_width * 64) * y];
-        u8 *target1 = target_base + 32;
-        u8 *target2 = target_base + info.block_stride * 9;
+        auto target = &block_output[(info.blocks_width * 64) * y];
 
         for (const auto x : algo::range(info.x_block_count))
         {
@@ -432,37 +237,31 @@ static bstr decode_blocks(
                 }
             }
 
-            dct(dct_table[0], quant_y);
-            dct(dct_table[1], quant_y);
-            dct(dct_table[2], quant_y);
-            dct(dct_table[3], quant_y);
-            dct(dct_table[4], quant_c);
-            dct(dct_table[5], quant_c);
-
-            u8 *dc, *ac;
-
-            dc = target1 - 32;
-            ac = target1 - 32 + info.block_stride;
-            ycc2rgb(
-                dc, ac, &dct_table[0][0], &dct_table[5][0], info.block_stride);
-
-            dc = target1;
-            ac = target2 + 32 - info.block_stride * 8;
-            ycc2rgb(
-                dc, ac, &dct_table[1][0], &dct_table[5][4], info.block_stride);
-
-            dc = target1 + ((info.block_stride) << 3) - 32;
-            ac = target2;
-            ycc2rgb(
-                dc, ac, &dct_table[2][0], &dct_table[5][32], info.block_stride);
-
-            dc = target2 + 32 - info.block_stride;
-            ac = target2 + 32;
-            ycc2rgb(
-                dc, ac, &dct_table[3][0], &dct_table[5][36], info.block_stride);
-
-            target1 += 64;
-            target2 += 64;
+            for (const auto n : algo::range(4))
+                algo::image::idct_8x8_int(dct_table[n].data(), quant_y.data());
+            for (const auto n : algo::range(4, 6))
+                algo::image::idct_8x8_int(dct_table[n].data(), quant_c.data());
+
+            // four luma blocks share one pair of subsampled chroma blocks
+            static const size_t chroma_offsets[4] = {0, 4, 32, 36};
+            u8 *targets[4] =
+            {
+                target,
+                target + 32,
+                target + info.block_stride * 8,
+                target + info.block_stride * 8 + 32,
+            };
+            for (const auto n : algo::range(4))
+            {
+                algo::image::ycbcr420_to_bgr_8x8_int(
+                    dct_table[n].data(),
+                    dct_table[4].data() + chroma_offsets[n],
+                    dct_table[5].data() + chroma_offsets[n],
+                    targets[n],
+                    info.block_stride);
+            }
+
+            target += 64;
         }
     }
     return block_output;
@@ -261,7 +261,7 @@ static bstr get_exe_key(const Logger &logger, const io::path &input_path)
     const auto tpf0_decoder = dec::borland::Tpf0Decoder();
     const auto exe_meta = exe_decoder.read_meta(logger, exe_file);
 
-    std::unique_ptr<dec::ArchiveEntry> tform_entry;
+    dec::ArchiveEntryPtr<dec::ArchiveEntry> tform_entry;
     for (auto &entry : exe_meta->entries)
         if (entry->path.str().find("TFORM1") != std::string::npos)
             tform_entry = std::move(entry);
@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/real_live/nwa_audio_decoder.h"
+#include <algorithm>
 #include "algo/range.h"
 #include "err.h"
 #include "io/lsb_bit_stream.h"
@@ -152,8 +153,10 @@ static bstr decode_block(
     return output_stream.seek(0).read_to_eof();
 }
 
-static bstr read_compressed_samples(
-    io::BaseByteStream &input_stream, const NwaHeader &header)
+static void read_compressed_samples(
+    io::BaseByteStream &input_stream,
+    const NwaHeader &header,
+    res::IAudioSink &output_sink)
 {
     if (header.compression_level < 0 || header.compression_level > 5)
         throw err::NotSupportedError("Unsupported compression level");
@@ -187,16 +190,23 @@ static bstr read_compressed_samples(
     for (const auto i : algo::range(header.block_count))
         offsets.push_back(input_stream.read_le<u32>());
 
-    bstr output;
     for (const auto i : algo::range(header.block_count))
-        output += decode_block(header, i, input_stream, offsets);
-    return output;
+        output_sink.write(decode_block(header, i, input_stream, offsets));
 }
 
-static bstr read_uncompressed_samples(
-    io::BaseByteStream &input_stream, const NwaHeader &header)
+static void read_uncompressed_samples(
+    io::BaseByteStream &input_stream,
+    const NwaHeader &header,
+    res::IAudioSink &output_sink)
 {
-    return input_stream.read(header.size_orig);
+    static const size_t chunk_size = 1024 * 1024;
+    size_t left = header.size_orig;
+    while (left)
+    {
+        const auto size = std::min(left, chunk_size);
+        output_sink.write(input_stream.read(size));
+        left -= size;
+    }
 }
 
 bool NwaAudioDecoder::is_recognized_impl(io::File &input_file) const
@@ -206,6 +216,16 @@ bool NwaAudioDecoder::is_recognized_impl(io::File &input_file) const
 
 res::Audio NwaAudioDecoder::decode_impl(
     const Logger &logger, io::File &input_file) const
+{
+    res::AudioBuffer output_buffer;
+    decode_stream_impl(logger, input_file, output_buffer);
+    return output_buffer.audio;
+}
+
+void NwaAudioDecoder::decode_stream_impl(
+    const Logger &logger,
+    io::File &input_file,
+    res::IAudioSink &output_sink) const
 {
     // buffer the file in memory for performance
     io::MemoryByteStream input_stream(input_file.stream.seek(0).read_to_eof());
@@ -223,16 +243,16 @@ res::Audio NwaAudioDecoder::decode_impl(
     header.block_size = input_stream.read_le<u32>();
     header.rest_size = input_stream.read_le<u32>();
 
-    const auto samples = header.compression_level == -1
-        ? read_uncompressed_samples(input_stream, header)
-        : read_compressed_samples(input_stream, header);
+    res::Audio format;
+    format.channel_count = header.channel_count;
+    format.bits_per_sample = header.bits_per_sample;
+    format.sample_rate = header.sample_rate;
+    output_sink.begin(format);
 
-    res::Audio audio;
-    audio.channel_count = header.channel_count;
-    audio.bits_per_sample = header.bits_per_sample;
-    audio.sample_rate = header.sample_rate;
-    audio.samples = samples;
-    return audio;
+    if (header.compression_level == -1)
+        read_uncompressed_samples(input_stream, header, output_sink);
+    else
+        read_compressed_samples(input_stream, header, output_sink);
 }
 
 static auto _ = dec::register_decoder<NwaAudioDecoder>("real-live/nwa");
@@ -306,6 +306,11 @@ std::unique_ptr<io::File> RpaArchiveDecoder::read_file_impl(
     const dec::ArchiveEntry &e) const
 {
     const auto entry = static_cast<const CustomArchiveEntry*>(&e);
+    if (entry->prefix.empty())
+    {
+        return read_stored_file(
+            input_file, entry->path, entry->offset, entry->size);
+    }
     const auto data = input_file.stream.seek(entry->offset).read(entry->size);
     return std::make_unique<io::File>(entry->path, entry->prefix + data);
 }
@@ -18,10 +18,10 @@
 #include "dec/shiina_rio/warc/decrypt.h"
 #include <cmath>
 #include "algo/endian.h"
+#include "algo/hash/crc.h"
 #include "algo/pack/zlib.h"
 #include "algo/range.h"
 #include "err.h"
-#include "io/memory_byte_stream.h"
 
 using namespace au;
 using namespace au::dec::shiina_rio;
@@ -39,9 +39,12 @@ static const unsigned int year_day_acc[2][13] =
 };
 static const double pi = 3.14159265358979323846;
 
-static const bstr essential_crypt_key =
+static const u8 essential_crypt_key[] =
     "Crypt Type 20011002 - Copyright(C) 2000 Y.Yamada/STUDIO "
-    "\x82\xE6\x82\xB5\x82\xAD\x82\xF1"_b; // SJIS よしくん
+    "\x82\xE6\x82\xB5\x82\xAD\x82\xF1"; // SJIS よしくん
+
+// constant, so that the per-byte modulo below doesn't become a division
+static const size_t essential_crypt_key_size = sizeof(essential_crypt_key) - 1;
 
 namespace
 {
@@ -102,69 +105,47 @@ static inline u32 mix_colors(const u32 c1, const u32 c2, const u32 alpha)
     return c1 + (((c2 - c1) * alpha) >> 8);
 }
 
-static u32 calculate_crc32(const bstr &data)
-{
-    const u32 xor_value = 0x6DB88320;
-    u32 table[0x100];
-    for (const auto i : algo::range(0x100))
-    {
-        u32 poly = i;
-        for (const auto j : algo::range(8))
-        {
-            const bool bit = poly & 1;
-            poly = (poly >> 1) | (poly << 31);
-            if (bit == 1)
-                poly ^= xor_value;
-        }
-        table[i] = poly;
-    }
-    u32 checksum = 0xFFFFFFFF;
-    for (const auto c : data)
-        checksum = (checksum >> 8) ^ table[(c ^ (checksum & 0xFF)) & 0xFF];
-    checksum ^= 0xFFFFFFFF;
-    return checksum;
-}
-
-static res::Image transform_region_image(
+// Blends the region image with the base color onto a black canvas and
+// returns the result as packed BGR triplets. This runs once per encrypted
+// entry, while the blend parameters are fixed per call, so both blends are
+// tabulated up front and the pixel loop is reduced to lookups and a multiply.
+static bstr transform_region_image(
     const res::Image &input_image, const u32 flags, const u32 base_color)
 {
-    res::Image output_image(input_image.width(), input_image.height());
-    res::Pixel base_pixel;
-    base_pixel.b = base_color;
-    base_pixel.g = base_color >> 8;
-    base_pixel.r = base_color >> 16;
-    const int src_alpha = (flags & 0x08000000) ? (flags & 0x1FF) : 0x100;
-    const int dst_alpha = (flags & 0x10000000) ? ((flags >> 12) & 0x1FF) : 0;
+    const u32 src_alpha = (flags & 0x08000000) ? (flags & 0x1FF) : 0x100;
+    const u32 dst_alpha = (flags & 0x10000000) ? ((flags >> 12) & 0x1FF) : 0;
     const auto flip_vertically = (flags & 0x20000000) != 0;
     const auto flip_horizontally = (flags & 0x40000000) != 0;
-    for (const auto y : algo::range(input_image.height()))
-    for (const auto x : algo::range(input_image.width()))
+
+    u8 color_table[3][0x100];
+    u32 alpha_table[0x100];
+    for (const auto i : algo::range(3))
     {
-        const auto src_y = flip_vertically ? input_image.height() - 1 - y : y;
-        const auto src_x = flip_horizontally ? input_image.width() - 1 - x : x;
-        auto &output_pixel = output_image.at(x, y);
-        const auto &input_pixel = input_image.at(src_x, src_y);
-        const auto alpha = mix_colors(0, input_pixel.a, src_alpha);
-        for (const auto i : algo::range(3))
-        {
-            output_pixel[i] = mix_colors(
-                output_pixel[i],
-                (mix_colors(input_pixel[i], base_pixel[i], dst_alpha)) & 0xFF,
-                alpha);
-        }
+        const u32 base = (base_color >> (i * 8)) & 0xFF;
+        for (const auto c : algo::range(0x100))
+            color_table[i][c] = mix_colors(c, base, dst_alpha);
     }
-    return output_image;
-}
+    for (const auto a : algo::range(0x100))
+        alpha_table[a] = mix_colors(0, a, src_alpha);
 
-static bstr get_rgb_data(const res::Image &input_image)
-{
-    bstr output(input_image.width() * input_image.height() * 3);
+    const auto width = input_image.width();
+    const auto height = input_image.height();
+    bstr output(width * height * 3);
     auto output_ptr = output.get<u8>();
-    for (const auto c : input_image)
+    for (const auto y : algo::range(height))
     {
-        *output_ptr++ = c.b;
-        *output_ptr++ = c.g;
-        *output_ptr++ = c.r;
+        const auto src_y = flip_vertically ? height - 1 - y : y;
+        const auto input_row = &input_image.at(0, src_y);
+        for (const auto x : algo::range(width))
+        {
+            const auto src_x = flip_horizontally ? width - 1 - x : x;
+            const auto &input_pixel = input_row[src_x];
+            // the canvas starts black, so the outer blend is a plain scale
+            const auto alpha = alpha_table[input_pixel.a];
+            *output_ptr++ = (color_table[0][input_pixel.b] * alpha) >> 8;
+            *output_ptr++ = (color_table[1][input_pixel.g] * alpha) >> 8;
+            *output_ptr++ = (color_table[2][input_pixel.r] * alpha) >> 8;
+        }
     }
     return output;
 }
@@ -372,11 +353,9 @@ static std::array<u32, 5> get_initial_crypt_key_addends(
 std::array<u32, 10> get_initial_crypt_keys(
     const Plugin &plugin, const bstr &data)
 {
-    io::MemoryByteStream data_stream(data);
     std::array<u32, 0x50> buf;
-    data_stream.seek(44);
     for (const auto i : algo::range(0x10))
-        buf[i] = data_stream.read_be<u32>();
+        buf[i] = algo::from_big_endian(data.get<const u32>()[11 + i]);
     for (const auto i : algo::range(0x10, 0x50))
     {
         buf[i]
@@ -405,11 +384,8 @@ std::array<u32, 10> get_initial_crypt_keys(
         if (!(flags & 0x78000000))
             flags |= 0x98000000;
         const u32 base_color = buf[1] >> 8;
-        const auto transformed_region_image
-            = transform_region_image(*plugin.region_image, flags, base_color);
-        const auto transformed_region_data
-            = get_rgb_data(transformed_region_image);
-        keys[6] = calculate_crc32(transformed_region_data);
+        keys[6] = algo::hash::crc32(
+            transform_region_image(*plugin.region_image, flags, base_color));
         if (plugin.version >= 2390)
             keys[6] += keys[9];
     }
@@ -525,22 +501,21 @@ void warc::decrypt_essential(
     const u64 key_pos_addend2 = get_essential_key_pos_addend2(token, lcg);
     auto key_pos1 = key_pos_addend1 + key_pos_addend2;
     auto key_pos2 = 0;
-    key_pos1 %= essential_crypt_key.size();
+    key_pos1 %= essential_crypt_key_size;
 
-    for (const auto i : algo::range(
-        essential_crypt_start + 2, essential_crypt_end))
+    // each byte picks the key position for the next one, so this stays
+    // serial; the LCG part is lcg / 2^24 truncated, i.e. its top byte.
+    auto data_ptr = data.get<u8>() + essential_crypt_start + 2;
+    const auto data_end = data.get<u8>() + essential_crypt_end;
+    while (data_ptr < data_end)
     {
-        u8 d = data[i];
-        if (warc_version > 120)
-            d ^= static_cast<u8>(lcg.next<u32>() / 16777216.0);
-        else
-            throw err::NotSupportedError("WARC <=1.2 is not implemented");
+        u8 d = *data_ptr ^ (lcg.next<u32>() >> 24);
         d = (d >> 1) | (d << 7);
         d ^= essential_crypt_key[key_pos1];
         d ^= essential_crypt_key[key_pos2];
-        data[i] = d;
-        key_pos1 = d % essential_crypt_key.size();
-        key_pos2 = (key_pos2 + 1) % essential_crypt_key.size();
+        *data_ptr++ = d;
+        key_pos1 = d % essential_crypt_key_size;
+        key_pos2 = (key_pos2 + 1) % essential_crypt_key_size;
     }
 }
 
@@ -561,8 +536,15 @@ void warc::decrypt_table_data(
     if (warc_version >= 170)
     {
         const u8 key = warc_version ^ 0xFF;
-        for (const auto i : algo::range(8, table_data.size()))
+        const u32 word_key = key * 0x01010101;
+        table_data_ptr = table_data.get<u32>() + 2;
+        while (table_data_ptr < table_data_end)
+            *table_data_ptr++ ^= word_key;
+        for (const auto i : algo::range(
+            table_data.size() & ~3, table_data.size()))
+        {
             table_data[i] ^= key;
+        }
         table_data = algo::pack::zlib_inflate(table_data.substr(8));
     }
     else
@@ -574,13 +556,7 @@ void warc::crc_crypt(bstr &data, const bstr &table)
     if (data.size() < 0x400 || !table.size())
         return;
 
-    u32 crc = 0xFFFFFFFF;
-    for (const auto i : algo::range(0x100))
-    {
-        crc ^= data[i] << 24;
-        for (const auto j : algo::range(8))
-            crc = (crc << 1) ^ (crc & 0x80000000 ? 0x04C11DB7 : 0);
-    }
+    const auto crc = algo::hash::crc32_mpeg2(data.substr(0, 0x100));
     for (const auto i : algo::range(0x40))
     {
         const auto idx = data.get<u32>()[0x40 + i] % table.size();
@@ -81,7 +81,7 @@ std::unique_ptr<dec::ArchiveMeta> WarcArchiveDecoder::read_meta_impl(
     auto meta = std::make_unique<CustomArchiveMeta>(plugin, warc_version);
     while (table_stream.left())
     {
-        auto entry = std::make_unique<CustomArchiveEntry>();
+        auto entry = meta->create_entry<CustomArchiveEntry>();
         auto name = table_stream.read_to_zero(plugin->entry_name_size).str();
         for (auto &c : name)
         {
@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/shiina_rio/warc_archive_decoder.h"
+#include <mutex>
 #include "dec/png/png_image_decoder.h"
 #include "dec/shiina_rio/warc/decrypt.h"
 #include "io/file.h"
@@ -46,6 +47,10 @@ namespace
 {
     struct MakiFesExtraCrypt final : public warc::BaseExtraCrypt
     {
+        MakiFesExtraCrypt() : decode_table(read_etc_file("extra_makifes.png"))
+        {
+        }
+
         size_t min_size() const override
         {
             return 0x400;
@@ -54,7 +59,6 @@ namespace
         void pre_decrypt(bstr &data) const override
         {
             u32 key = 0x12BDB19B;
-            const auto decode_table = read_etc_file("extra_makifes.png");
             for (const auto i : algo::range(0x100))
             {
                 key = 0x343FD * key + 0x269EC3;
@@ -67,6 +71,9 @@ namespace
         {
             data.get<u32>()[0x80] ^= 0x12BDB19B;
         }
+
+    private:
+        bstr decode_table;
     };
 
     struct BitchNeechanExtraCrypt final : public warc::BaseExtraCrypt
@@ -262,12 +269,26 @@ namespace
     };
 }
 
+// Building a plugin decodes its key images, which is too slow to repeat for
+// every archive. Each builder lambda has its own type, so the statics below
+// hold one plugin per builder for the whole process.
+template<typename T> static warc::PluginBuilder memoize(const T builder)
+{
+    return [builder]()
+    {
+        static std::once_flag once;
+        static std::shared_ptr<warc::Plugin> plugin;
+        std::call_once(once, [&]() { plugin = builder(); });
+        return plugin;
+    };
+}
+
 WarcArchiveDecoder::WarcArchiveDecoder()
 {
     plugin_manager.add(
         "237",
         "Generic ShiinaRio v2.37",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2370;
@@ -278,12 +299,12 @@ WarcArchiveDecoder::WarcArchiveDecoder()
                 = {0xF182C682, 0xE882AA82, 0x718E5896, 0x8183CC82, 0xDAC98283};
             p->crc_crypt_source = read_etc_file("table1.bin");
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "shojo-mama",
         "Shojo Mama",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2490;
@@ -294,13 +315,13 @@ WarcArchiveDecoder::WarcArchiveDecoder()
             p->extra_crypt = std::make_unique<TableExtraCrypt>(
                 read_etc_file("extra_table.png"), 0xECB2F5B2);
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "majime1",
         "Majime to Sasayakareru Ore wo Osananajimi no Risa ga Seiteki na Imi "
         "mo Komete Kanraku Shite Iku Hanashi (sic)",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2490;
@@ -311,12 +332,12 @@ WarcArchiveDecoder::WarcArchiveDecoder()
                 = {0xF1AD65AB, 0x55B7E1AD, 0x62B875B8, 0, 0};
             p->extra_crypt = std::make_unique<RevolveExtraCrypt>();
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "sorcery-jokers",
         "Sorcery Jokers",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2500;
@@ -327,12 +348,12 @@ WarcArchiveDecoder::WarcArchiveDecoder()
             p->extra_crypt = std::make_unique<SorceryJokersExtraCrypt>();
             p->crc_crypt_source = read_etc_file("table4.bin");
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "gh-nurse",
         "Gohoushi Nurse",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2500;
@@ -344,13 +365,13 @@ WarcArchiveDecoder::WarcArchiveDecoder()
             p->extra_crypt = std::make_unique<TableExtraCrypt>(
                 read_etc_file("extra_table.png"), 0x90CC9DC2);
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "gensou",
         "Gensou no Idea ~Oratorio Phantasm Historia~"
         "Gensou no Idea",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2490;
@@ -361,12 +382,12 @@ WarcArchiveDecoder::WarcArchiveDecoder()
                 = {0x45BA9DA7, 0x68A8E7A9, 0x6AA84DA8, 0, 0};
             p->extra_crypt = std::make_unique<RevolveExtraCrypt>();
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "maki-fes",
         "Maki Fes",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2500;
@@ -376,12 +397,12 @@ WarcArchiveDecoder::WarcArchiveDecoder()
             p->initial_crypt_base_keys = {0xF6DF81DF, 0x1BDE29DE, 0x5DE, 0, 0};
             p->extra_crypt = std::make_unique<MakiFesExtraCrypt>();
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "bitch-neechan",
         "Bitch Nee-chan ga Seijun na Hazu ga Nai!",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2500;
@@ -393,12 +414,12 @@ WarcArchiveDecoder::WarcArchiveDecoder()
             p->extra_crypt = std::make_unique<BitchNeechanExtraCrypt>();
             p->crc_crypt_source = read_etc_file("table4.bin");
             return p;
-        });
+        }));
 
     plugin_manager.add(
         "nukitashi",
         "Nukige Mitai na Shima ni Sunderu Watashi wa Dou Surya Ii Desu ka?",
-        []()
+        memoize([]()
         {
             auto p = std::make_shared<warc::Plugin>();
             p->version = 2500;
@@ -410,7 +431,7 @@ WarcArchiveDecoder::WarcArchiveDecoder()
             p->extra_crypt = std::make_unique<NukiTashiExtraCrypt>();
             p->crc_crypt_source = read_etc_file("table4.bin");
             return p;
-        });
+        }));
 
     add_arg_parser_decorator(
         plugin_manager.create_arg_parser_decorator(
@@ -16,7 +16,12 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/twilight_frontier/tfpk_archive_decoder.h"
+#include <cstring>
 #include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include "algo/crypt/repeating_key.h"
 #include "algo/crypt/rsa.h"
 #include "algo/format.h"
 #include "algo/locale.h"
@@ -30,6 +35,8 @@ using namespace au;
 using namespace au::dec::twilight_frontier;
 
 static const bstr magic = "TFPK"_b;
+static const size_t block_size = 0x40;
+static const size_t block_data_size = 0x20;
 
 namespace
 {
@@ -55,20 +62,17 @@ namespace
         size_t file_count;
     };
 
-    using HashLookupMap = std::map<u32, std::string>;
+    using HashLookupMap = std::unordered_map<u32, std::string>;
 
     class RsaReader final
     {
     public:
         RsaReader(io::BaseByteStream &input_stream);
         ~RsaReader();
-        std::unique_ptr<io::MemoryByteStream> read_block();
+        bstr read_blocks(const size_t count);
         size_t pos() const;
 
     private:
-        std::unique_ptr<io::MemoryByteStream>
-            decrypt(std::basic_string<u8> input);
-
         io::BaseByteStream &input_stream;
         std::unique_ptr<algo::crypt::Rsa> rsa;
     };
@@ -143,15 +147,15 @@ RsaReader::RsaReader(io::BaseByteStream &input_stream)
     bstr test_chunk;
     input_stream.peek(
         input_stream.pos(),
-        [&]() { test_chunk = input_stream.read(0x40); });
+        [&]() { test_chunk = input_stream.read(block_size); });
 
     for (const auto &rsa_key : rsa_keys)
     {
-        algo::crypt::Rsa tester(rsa_key);
+        auto tester = std::make_unique<algo::crypt::Rsa>(rsa_key);
         try
         {
-            tester.decrypt(test_chunk);
-            rsa = std::make_unique<algo::crypt::Rsa>(rsa_key);
+            tester->decrypt_blocks(test_chunk, block_data_size);
+            rsa = std::move(tester);
             return;
         }
         catch (...)
@@ -176,12 +180,21 @@ size_t RsaReader::pos() const
     return input_stream.pos();
 }
 
-std::unique_ptr<io::MemoryByteStream> RsaReader::read_block()
+bstr RsaReader::read_blocks(const size_t count)
 {
-    const auto block = rsa
-        ? rsa->decrypt(input_stream.read(0x40)).substr(0, 0x20)
-        : input_stream.read(0x40).substr(0, 0x20);
-    return std::make_unique<io::MemoryByteStream>(block);
+    const auto input = input_stream.read(count * block_size);
+    if (rsa)
+        return rsa->decrypt_blocks(input, block_data_size);
+
+    bstr output(count * block_data_size);
+    for (const auto i : algo::range(count))
+    {
+        std::memcpy(
+            output.get<u8>() + i * block_data_size,
+            input.get<const u8>() + i * block_size,
+            block_data_size);
+    }
+    return output;
 }
 
 static bstr read_file_content(
@@ -192,26 +205,11 @@ static bstr read_file_content(
 {
     input_file.stream.seek(entry.offset);
     auto data = input_file.stream.read(std::min<size_t>(max_size, entry.size));
-    const auto key_size = entry.key.size();
+    const algo::crypt::RepeatingKey key(entry.key);
     if (meta.version == TfpkVersion::Th135)
-    {
-        for (const auto i : algo::range(data.size()))
-            data[i] ^= entry.key[i % key_size];
-    }
+        key.xor_data(data.get<u8>(), data.size());
     else
-    {
-        auto *key = entry.key.get<const u8>();
-        auto *buf = data.get<u8>();
-        u8 aux[4];
-        for (const auto i : algo::range(4))
-            aux[i] = key[i];
-        for (const auto i : algo::range(data.size()))
-        {
-            const auto tmp = buf[i];
-            buf[i] = tmp ^ key[i % key_size] ^ aux[i & 3];
-            aux[i & 3] = tmp;
-        }
-    }
+        key.xor_data_with_feedback(data.get<u8>(), data.size(), entry.key);
     return data;
 }
 
@@ -276,7 +274,7 @@ static std::string get_unknown_name(
 }
 
 static std::string get_dir_name(
-    const DirEntry &dir_entry, const HashLookupMap user_fn_map)
+    const DirEntry &dir_entry, const HashLookupMap &user_fn_map)
 {
     const auto it = user_fn_map.find(dir_entry.initial_hash);
     if (it != user_fn_map.end())
@@ -284,16 +282,51 @@ static std::string get_dir_name(
     return get_unknown_name(0, dir_entry.initial_hash, "");
 }
 
+static std::shared_ptr<const HashLookupMap> get_user_fn_map(
+    const std::string &path, const TfpkVersion version)
+{
+    // The name lists are long and every name goes through SJIS to be hashed,
+    // so build each map once per process rather than on every archive open.
+    static std::mutex mutex;
+    static std::map<
+        std::pair<std::string, TfpkVersion>,
+        std::shared_ptr<const HashLookupMap>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto key = std::make_pair(path, version);
+    const auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    std::set<std::string> fn_set;
+    if (path != "")
+    {
+        io::FileByteStream stream(path, io::FileMode::Read);
+        std::string line;
+        while ((line = stream.read_line().str()) != "")
+            fn_set.insert(line);
+    }
+
+    auto user_fn_map = std::make_shared<HashLookupMap>();
+    user_fn_map->reserve(fn_set.size());
+    for (const auto &fn : fn_set)
+        (*user_fn_map)[get_file_name_hash(fn, version)] = fn;
+    cache[key] = user_fn_map;
+    return user_fn_map;
+}
+
 static std::vector<DirEntry> read_dir_entries(RsaReader &reader)
 {
     std::vector<DirEntry> dirs;
-    const auto dir_count = reader.read_block()->read_le<u32>();
+    const auto dir_count
+        = io::MemoryByteStream(reader.read_blocks(1)).read_le<u32>();
+    io::MemoryByteStream table_stream(reader.read_blocks(dir_count));
     for (const auto i : algo::range(dir_count))
     {
-        auto tmp_stream = reader.read_block();
+        table_stream.seek(i * block_data_size);
         DirEntry entry;
-        entry.initial_hash = tmp_stream->read_le<u32>();
-        entry.file_count = tmp_stream->read_le<u32>();
+        entry.initial_hash = table_stream.read_le<u32>();
+        entry.file_count = table_stream.read_le<u32>();
         dirs.push_back(entry);
     }
     return dirs;
@@ -307,18 +340,14 @@ static HashLookupMap read_fn_map(
 {
     HashLookupMap fn_map;
 
-    auto tmp_stream = reader.read_block();
-    const auto table_size_comp = tmp_stream->read_le<u32>();
-    const auto table_size_orig = tmp_stream->read_le<u32>();
-    const auto block_count = tmp_stream->read_le<u32>();
-
-    tmp_stream = std::make_unique<io::MemoryByteStream>();
-    for (const auto i : algo::range(block_count))
-        tmp_stream->write(reader.read_block()->read_to_eof());
+    io::MemoryByteStream header_stream(reader.read_blocks(1));
+    const auto table_size_comp = header_stream.read_le<u32>();
+    const auto table_size_orig = header_stream.read_le<u32>();
+    const auto block_count = header_stream.read_le<u32>();
 
-    tmp_stream->seek(0);
-    tmp_stream = std::make_unique<io::MemoryByteStream>(
-        algo::pack::zlib_inflate(tmp_stream->read(table_size_comp)));
+    io::MemoryByteStream table_stream(reader.read_blocks(block_count));
+    io::MemoryByteStream name_stream(
+        algo::pack::zlib_inflate(table_stream.read(table_size_comp)));
 
     for (const auto &dir_entry : dir_entries)
     {
@@ -332,7 +361,7 @@ static HashLookupMap read_fn_map(
             try
             {
                 const auto fn
-                    = algo::sjis_to_utf8(tmp_stream->read_to_zero()).str();
+                    = algo::sjis_to_utf8(name_stream.read_to_zero()).str();
                 const auto hash = get_file_name_hash(
                     fn, version, dir_entry.initial_hash);
                 fn_map[hash] = dn + fn;
@@ -359,14 +388,10 @@ TfpkArchiveDecoder::TfpkArchiveDecoder()
         },
         [&](const ArgParser &arg_parser)
         {
-            const auto path = arg_parser.get_switch("file-names");
-            if (path != "")
-            {
-                io::FileByteStream stream(path, io::FileMode::Read);
-                std::string line;
-                while ((line = stream.read_line().str()) != "")
-                    fn_set.insert(line);
-            }
+            file_names_path = arg_parser.get_switch("file-names");
+            // the list itself is loaded lazily, but fail early if it's missing
+            if (file_names_path != "")
+                io::FileByteStream(file_names_path, io::FileMode::Read);
         });
 }
 
@@ -388,9 +413,7 @@ std::unique_ptr<dec::ArchiveMeta> TfpkArchiveDecoder::read_meta_impl(
         ? TfpkVersion::Th135
         : TfpkVersion::Th145;
 
-    HashLookupMap user_fn_map;
-    for (const auto &fn : fn_set)
-        user_fn_map[get_file_name_hash(fn, meta->version)] = fn;
+    const auto user_fn_map = get_user_fn_map(file_names_path, meta->version);
 
     RsaReader reader(input_file.stream);
     HashLookupMap fn_map;
@@ -398,47 +421,62 @@ std::unique_ptr<dec::ArchiveMeta> TfpkArchiveDecoder::read_meta_impl(
     // TH135 contains file hashes, TH145 contains garbage
     const auto dir_entries = read_dir_entries(reader);
     if (dir_entries.size() > 0)
-        fn_map = read_fn_map(reader, dir_entries, user_fn_map, meta->version);
+        fn_map = read_fn_map(reader, dir_entries, *user_fn_map, meta->version);
 
-    for (const auto &it : user_fn_map)
-        fn_map[it.first] = it.second;
+    // names from the user's list take precedence over the archive's own
+    const auto find_name = [&](const u32 fn_hash) -> const std::string*
+    {
+        auto it = user_fn_map->find(fn_hash);
+        if (it != user_fn_map->end())
+            return &it->second;
+        it = fn_map.find(fn_hash);
+        return it == fn_map.end() ? nullptr : &it->second;
+    };
 
-    const auto file_count = reader.read_block()->read_le<u32>();
+    const auto file_count
+        = io::MemoryByteStream(reader.read_blocks(1)).read_le<u32>();
+    io::MemoryByteStream table_stream(reader.read_blocks(file_count * 3));
     for (const auto i : algo::range(file_count))
     {
         auto entry = std::make_unique<CustomArchiveEntry>();
-        const auto b1 = reader.read_block();
-        const auto b2 = reader.read_block();
-        const auto b3 = reader.read_block();
+        const auto b1 = i * 3 * block_data_size;
+        const auto b2 = b1 + block_data_size;
+        const auto b3 = b2 + block_data_size;
         if (meta->version == TfpkVersion::Th135)
         {
-            entry->size = b1->read_le<u32>();
-            entry->offset = b1->read_le<u32>();
+            table_stream.seek(b1);
+            entry->size = table_stream.read_le<u32>();
+            entry->offset = table_stream.read_le<u32>();
 
-            const auto fn_hash = b2->read_le<u32>();
-            const auto it = fn_map.find(fn_hash);
-            entry->path = it == fn_map.end()
-                ? get_unknown_name(i, fn_hash)
-                : it->second;
+            const auto fn_hash = table_stream.seek(b2).read_le<u32>();
+            const auto name = find_name(fn_hash);
+            entry->path = name ? *name : get_unknown_name(i, fn_hash);
 
-            entry->key = b3->read(16);
+            entry->key = table_stream.seek(b3).read(16);
         }
         else
         {
-            entry->size   = b1->read_le<u32>() ^ b3->read_le<u32>();
-            entry->offset = b1->read_le<u32>() ^ b3->read_le<u32>();
+            u32 b1_words[2], b2_words[2], key_words[4];
+            table_stream.seek(b1);
+            for (const auto j : algo::range(2))
+                b1_words[j] = table_stream.read_le<u32>();
+            table_stream.seek(b2);
+            for (const auto j : algo::range(2))
+                b2_words[j] = table_stream.read_le<u32>();
+            table_stream.seek(b3);
+            for (const auto j : algo::range(4))
+                key_words[j] = table_stream.read_le<u32>();
+
+            entry->size   = b1_words[0] ^ key_words[0];
+            entry->offset = b1_words[1] ^ key_words[1];
 
-            const auto fn_hash = b2->read_le<u32>() ^ b3->read_le<u32>();
-            const auto unk = b2->read_le<u32>() ^ b3->read_le<u32>();
-            const auto it = fn_map.find(fn_hash);
-            entry->path = it == fn_map.end()
-                ? get_unknown_name(i + 1, fn_hash)
-                : it->second;
+            const auto fn_hash = b2_words[0] ^ key_words[2];
+            const auto name = find_name(fn_hash);
+            entry->path = name ? *name : get_unknown_name(i + 1, fn_hash);
 
-            b3->seek(0);
             io::MemoryByteStream key_stream;
             for (const auto j : algo::range(4))
-                key_stream.write_le<u32>(neg32(b3->read_le<u32>()));
+                key_stream.write_le<u32>(neg32(key_words[j]));
 
             key_stream.seek(0);
             entry->key = key_stream.read_to_eof();
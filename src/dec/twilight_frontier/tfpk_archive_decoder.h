@@ -17,7 +17,6 @@
 
 #pragma once
 
-#include <set>
 #include "dec/base_archive_decoder.h"
 
 namespace au {
@@ -44,7 +43,7 @@ namespace twilight_frontier {
             const ArchiveEntry &e) const override;
 
     private:
-        std::set<std::string> fn_set;
+        std::string file_names_path;
     };
 
 } } }
@@ -16,14 +16,59 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "dec/unity/assets_archive_decoder.h"
+#include <map>
+#include "algo/format.h"
 #include "dec/unity/assets_archive_decoder/meta.h"
+#include "dec/unity/assets_archive_decoder/read_plan.h"
+#include "dec/unity/assets_archive_decoder/texture.h"
+#include "enc/png/png_image_encoder.h"
 #include "err.h"
+#include "io/file.h"
+#include "io/file_system.h"
+#include "virtual_file_system.h"
 
 using namespace au;
 using namespace au::dec::unity;
 
+// Names of the fields read from objects of the classes that get decoded.
+// m_Name always comes first so that entries can be named by reading just
+// the beginning of each object.
+static const std::map<int, std::vector<std::string>> class_fields =
+{
+    {28, { // Texture2D
+        "m_Name",
+        "m_Width",
+        "m_Height",
+        "m_TextureFormat",
+        "image data",
+        "m_StreamData.offset",
+        "m_StreamData.size",
+        "m_StreamData.path",
+    }},
+    {49, { // TextAsset
+        "m_Name",
+        "m_Script",
+    }},
+    {83, { // AudioClip
+        "m_Name",
+        "m_AudioData",
+        "m_Resource.m_Source",
+        "m_Resource.m_Offset",
+        "m_Resource.m_Size",
+    }},
+};
+
+static const size_t name_prefix_size = 0x400;
+
 namespace
 {
+    enum ClassId
+    {
+        Texture2D = 28,
+        TextAsset = 49,
+        AudioClip = 83,
+    };
+
     struct Header final
     {
         uoff_t metadata_size;
@@ -32,6 +77,12 @@ namespace
         uoff_t data_offset;
         u8 endianness;
     };
+
+    struct CustomArchiveEntry final : dec::PlainArchiveEntry
+    {
+        int class_id;
+        std::shared_ptr<const ReadPlan> read_plan;
+    };
 }
 
 static Header read_header(CustomStream &input_stream)
@@ -49,6 +100,162 @@ static Header read_header(CustomStream &input_stream)
     return header;
 }
 
+static const TypeRoot *get_type(
+    const BaseTypeTree &type_tree,
+    const BaseObjectInfo &object_info,
+    const int version)
+{
+    if (version > 15)
+        return type_tree.get_by_index(object_info.type_id);
+    const auto it = type_tree.find(object_info.type_id);
+    return it == type_tree.end() ? nullptr : it->second.get();
+}
+
+static bool has_name(const Node &root_node)
+{
+    for (const auto &child : root_node.children)
+        if (child->type->name == "m_Name")
+            return true;
+    return false;
+}
+
+// Plans are compiled once per type, so that reading each object afterwards
+// is just a walk over a flat list of steps.
+static std::shared_ptr<const ReadPlan> get_read_plan(
+    std::map<const TypeRoot*, std::shared_ptr<const ReadPlan>> &plans,
+    const TypeRoot &type)
+{
+    const auto it = plans.find(&type);
+    if (it != plans.end())
+        return it->second;
+    std::shared_ptr<const ReadPlan> plan;
+    const auto fields_it = class_fields.find(type.class_id);
+    try
+    {
+        if (!type.root_node)
+            plan = nullptr;
+        else if (fields_it != class_fields.end())
+        {
+            plan = std::make_shared<ReadPlan>(
+                *type.root_node, fields_it->second);
+        }
+        else if (has_name(*type.root_node))
+        {
+            plan = std::make_shared<ReadPlan>(
+                *type.root_node, std::vector<std::string>{"m_Name"});
+        }
+    }
+    catch (const err::CorruptDataError &)
+    {
+        // the tree uses nodes plans can't express; leave its objects raw
+        plan = nullptr;
+    }
+    plans[&type] = plan;
+    return plan;
+}
+
+static std::string read_name(
+    io::BaseByteStream &input_stream,
+    const CustomArchiveEntry &entry)
+{
+    input_stream.seek(entry.offset);
+    const auto prefix = input_stream.read(
+        std::min<uoff_t>(entry.size, name_prefix_size));
+    try
+    {
+        return entry.read_plan->read(prefix, 0)[0].data.str();
+    }
+    catch (const err::EofError &)
+    {
+        if (prefix.size() == entry.size)
+            throw;
+    }
+    input_stream.seek(entry.offset);
+    const auto data = input_stream.read(entry.size);
+    return entry.read_plan->read(data, 0)[0].data.str();
+}
+
+static io::path get_entry_path(
+    const std::string &name, const int class_id, const uoff_t path_id)
+{
+    const auto stem = name.empty()
+        ? algo::format("%llu", static_cast<unsigned long long>(path_id))
+        : name;
+    switch (class_id)
+    {
+        case ClassId::Texture2D: return stem + ".png";
+        case ClassId::TextAsset: return stem + ".txt";
+        case ClassId::AudioClip: return stem + ".fsb";
+        default: return stem;
+    }
+}
+
+// Big data of newer Unity versions lives in .resS / .resource files placed
+// next to the asset file. The path refers to it by an archive-internal name,
+// so only its last component is taken into account. Assets unpacked from
+// another archive find their siblings through the virtual file system.
+static bstr read_external(
+    const io::path &input_path,
+    const std::string &external_path,
+    const uoff_t offset,
+    const uoff_t size)
+{
+    const auto path = input_path.parent() / io::path(external_path).name();
+    auto input_file = io::is_regular_file(path)
+        ? std::make_unique<io::File>(path, io::FileMode::Read)
+        : VirtualFileSystem::get_by_path(path);
+    if (!input_file)
+    {
+        throw err::NotSupportedError(algo::format(
+            "Resource file %s not found", path.c_str()));
+    }
+    input_file->stream.seek(offset);
+    return input_file->stream.read(size);
+}
+
+static std::unique_ptr<io::File> read_texture(
+    const Logger &logger,
+    const io::path &input_path,
+    const io::path &path,
+    const std::vector<FieldValue> &fields)
+{
+    const auto width = fields[1].number;
+    const auto height = fields[2].number;
+    const auto format = fields[3].number;
+    auto data = fields[4].data;
+    if (fields[6].present && fields[6].number > 0)
+    {
+        data = read_external(
+            input_path,
+            fields[7].data.str(),
+            fields[5].number,
+            fields[6].number);
+    }
+    if (width <= 0 || height <= 0)
+        throw err::BadDataSizeError();
+    const auto image = decode_texture(format, width, height, data);
+    return enc::png::PngImageEncoder().encode(logger, *image, path);
+}
+
+static std::unique_ptr<io::File> read_audio_clip(
+    const io::path &input_path,
+    io::path path,
+    const std::vector<FieldValue> &fields)
+{
+    auto data = fields[1].data;
+    if (fields[4].present && fields[4].number > 0)
+    {
+        data = read_external(
+            input_path,
+            fields[2].data.str(),
+            fields[3].number,
+            fields[4].number);
+    }
+    auto output_file = std::make_unique<io::File>(path, data);
+    output_file->guess_extension();
+    return output_file;
+}
+
 bool AssetsArchiveDecoder::is_recognized_impl(io::File &input_file) const
 {
     // TODO: support .split0 files
@@ -70,17 +277,38 @@ std::unique_ptr<dec::ArchiveMeta> AssetsArchiveDecoder::read_meta_impl(
 
     Meta assets_meta(custom_stream, header.version);
     const auto &object_info_map = *assets_meta.object_info_table;
-    const auto &type_tree_map = *assets_meta.type_tree;
+    const auto &type_tree = *assets_meta.type_tree;
 
+    std::map<const TypeRoot*, std::shared_ptr<const ReadPlan>> plans;
     auto meta = std::make_unique<ArchiveMeta>();
-
+    meta->entries.reserve(object_info_map.size());
     for (const auto &object_info_kv : object_info_map)
     {
-        auto entry = std::make_unique<PlainArchiveEntry>();
+        auto entry = meta->create_entry<CustomArchiveEntry>();
         const auto &object_info = object_info_kv.second;
         entry->offset = header.data_offset + object_info->offset;
         entry->size = object_info->size;
-        // const auto &type = type_tree_map.at(object_info->type_id);
+        entry->class_id = object_info->class_id;
+
+        const auto type = get_type(type_tree, *object_info, header.version);
+        if (type && header.endianness == 0)
+            entry->read_plan = get_read_plan(plans, *type);
+
+        if (entry->read_plan)
+        {
+            try
+            {
+                entry->path = get_entry_path(
+                    read_name(input_file.stream, *entry),
+                    entry->class_id,
+                    object_info_kv.first);
+            }
+            catch (const err::GeneralError &)
+            {
+                // the tree doesn't match the data; leave the object raw
+                entry->read_plan = nullptr;
+            }
+        }
         meta->entries.push_back(std::move(entry));
     }
 
@@ -93,9 +321,28 @@ std::unique_ptr<io::File> AssetsArchiveDecoder::read_file_impl(
     const dec::ArchiveMeta &m,
     const dec::ArchiveEntry &e) const
 {
-    const auto entry = static_cast<const PlainArchiveEntry*>(&e);
-    const auto data = input_file.stream.seek(entry->offset).read(entry->size);
-    return std::make_unique<io::File>(entry->path, data);
+    const auto entry = static_cast<const CustomArchiveEntry*>(&e);
+    if (!entry->read_plan || !class_fields.count(entry->class_id))
+    {
+        return read_stored_file(
+            input_file, entry->path, entry->offset, entry->size);
+    }
+
+    input_file.stream.seek(entry->offset);
+    const auto fields = entry->read_plan->read(
+        input_file.stream.read(entry->size));
+    switch (entry->class_id)
+    {
+        case ClassId::Texture2D:
+            return read_texture(
+                logger, input_file.path, entry->path, fields);
+
+        case ClassId::AudioClip:
+            return read_audio_clip(input_file.path, entry->path, fields);
+
+        default:
+            return std::make_unique<io::File>(entry->path, fields[1].data);
+    }
 }
 
 static auto _ = dec::register_decoder<AssetsArchiveDecoder>("unity/assets");
@@ -35,14 +35,32 @@ Meta::Meta(CustomStream &input_stream, const int version)
 {
     // tree
     if (version > 13)
-        type_tree = get_w_reader<TypeTreeV3, TypeV2>(input_stream);
+    {
+        type_tree = std::make_unique<TypeTreeV3>(
+            input_stream,
+            [](CustomStream &input_stream)
+            {
+                return std::make_unique<TypeV2>(input_stream);
+            },
+            version);
+    }
     else if (version > 6)
         type_tree = get_w_reader<TypeTreeV2, TypeV1>(input_stream);
     else
         type_tree = get_w_reader<TypeTreeV1, TypeV1>(input_stream);
 
     // objects
-    if (version > 14)
+    if (version > 16)
+    {
+        object_info_table
+            = get_w_reader<ObjectInfoTableV2, ObjectInfoV5>(input_stream);
+    }
+    else if (version > 15)
+    {
+        object_info_table
+            = get_w_reader<ObjectInfoTableV2, ObjectInfoV4>(input_stream);
+    }
+    else if (version > 14)
     {
         object_info_table
             = get_w_reader<ObjectInfoTableV2, ObjectInfoV3>(input_stream);
@@ -57,6 +75,15 @@ Meta::Meta(CustomStream &input_stream, const int version)
         object_info_table
             = get_w_reader<ObjectInfoTableV1, ObjectInfoV1>(input_stream);
     }
+    if (version > 15)
+    {
+        for (auto &object_info_kv : *object_info_table)
+        {
+            auto &object_info = *object_info_kv.second;
+            object_info.class_id
+                = type_tree->get_by_index(object_info.type_id)->class_id;
+        }
+    }
 
     // object ids
     if (version > 10)
@@ -17,8 +17,9 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
-#include "algo/any.h"
+#include "dec/unity/assets_archive_decoder/type.h"
 
 namespace au {
 namespace dec {
@@ -26,9 +27,9 @@ namespace unity {
 
     struct Node final
     {
-        algo::any data;
+        std::unique_ptr<BaseType> type;
         Node *parent;
-        std::vector<Node*> children;
+        std::vector<std::unique_ptr<Node>> children;
     };
 
 } } }
@@ -52,3 +52,21 @@ ObjectInfoV3::ObjectInfoV3(CustomStream &input_stream)
     script_type_index = input_stream.read<s16>();
     is_stripped = input_stream.read<u8>() != 0;
 }
+
+ObjectInfoV4::ObjectInfoV4(CustomStream &input_stream)
+{
+    offset = input_stream.read<u32>();
+    size = input_stream.read<u32>();
+    type_id = input_stream.read<s32>();
+    class_id = -1;
+    script_type_index = input_stream.read<s16>();
+    is_stripped = input_stream.read<u8>() != 0;
+}
+
+ObjectInfoV5::ObjectInfoV5(CustomStream &input_stream)
+{
+    offset = input_stream.read<u32>();
+    size = input_stream.read<u32>();
+    type_id = input_stream.read<s32>();
+    class_id = -1;
+}
@@ -56,4 +56,19 @@ namespace unity {
         bool is_stripped;
     };
 
+    // From here on type_id is an index into the type tree, and class_id is
+    // filled in from there once the tree is known.
+    struct ObjectInfoV4 final : BaseObjectInfo
+    {
+        ObjectInfoV4(CustomStream &input_stream);
+
+        short script_type_index;
+        bool is_stripped;
+    };
+
+    struct ObjectInfoV5 final : BaseObjectInfo
+    {
+        ObjectInfoV5(CustomStream &input_stream);
+    };
+
 } } }
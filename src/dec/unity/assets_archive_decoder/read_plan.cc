@@ -0,0 +1,352 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/unity/assets_archive_decoder/read_plan.h"
+#include <cstring>
+#include "algo/endian.h"
+#include "algo/range.h"
+#include "err.h"
+
+using namespace au;
+using namespace au::dec::unity;
+
+static const u32 align_flag = 0x4000;
+
+namespace
+{
+    enum class StepKind : u8
+    {
+        Skip,
+        Align,
+        Number,
+        Array,
+    };
+
+    struct Step final
+    {
+        StepKind kind;
+        bool is_signed;
+        int field;
+        // Skip: byte count; Number: byte width; Array: element size if the
+        // elements are fixed-size, 0 if they need the steps that follow
+        size_t size;
+        // Array of variable-sized elements: number of steps in the body
+        size_t body_size;
+    };
+
+    struct Cursor final
+    {
+        const u8 *start;
+        const u8 *ptr;
+        const u8 *end;
+    };
+
+    class Compiler final
+    {
+    public:
+        Compiler(const std::vector<std::string> &field_paths);
+        void compile_members(const Node &node, const std::string &path);
+        std::vector<Step> steps;
+
+    private:
+        void compile(const Node &node, const std::string &path, int field);
+        void compile_array(const Node &node, const int field);
+        void add_skip(const size_t size);
+        void add_align();
+        int get_field(const std::string &path) const;
+
+        const std::vector<std::string> &field_paths;
+        size_t merge_barrier;
+    };
+}
+
+static bool is_array(const Node &node)
+{
+    return (node.type->is_array || node.type->type == "TypelessData")
+        && node.children.size() == 2;
+}
+
+static bool is_aligned(const Node &node)
+{
+    return (node.type->meta_flag & align_flag) != 0;
+}
+
+// Size of the node if it never varies between objects, 0 otherwise.
+static size_t get_fixed_size(const Node &node)
+{
+    if (is_aligned(node) || is_array(node))
+        return 0;
+    if (node.children.empty())
+        return node.type->size > 0 ? node.type->size : 0;
+    size_t size = 0;
+    for (const auto &child : node.children)
+    {
+        const auto child_size = get_fixed_size(*child);
+        if (!child_size)
+            return 0;
+        size += child_size;
+    }
+    return size;
+}
+
+static bool is_signed_type(const std::string &type)
+{
+    return type == "int" || type == "short" || type == "long long"
+        || type == "SInt8" || type == "SInt16" || type == "SInt32"
+        || type == "SInt64";
+}
+
+Compiler::Compiler(const std::vector<std::string> &field_paths)
+    : field_paths(field_paths), merge_barrier(0)
+{
+}
+
+int Compiler::get_field(const std::string &path) const
+{
+    for (const auto i : algo::range(field_paths.size()))
+        if (field_paths[i] == path)
+            return i;
+    return -1;
+}
+
+void Compiler::add_skip(const size_t size)
+{
+    if (steps.size() > merge_barrier && steps.back().kind == StepKind::Skip)
+    {
+        steps.back().size += size;
+        return;
+    }
+    steps.push_back({StepKind::Skip, false, -1, size, 0});
+}
+
+void Compiler::add_align()
+{
+    if (steps.size() > merge_barrier && steps.back().kind == StepKind::Align)
+        return;
+    steps.push_back({StepKind::Align, false, -1, 4, 0});
+}
+
+void Compiler::compile_members(const Node &node, const std::string &path)
+{
+    for (const auto &child : node.children)
+    {
+        const auto child_path = path.empty()
+            ? child->type->name
+            : path + "." + child->type->name;
+        compile(*child, child_path, get_field(child_path));
+    }
+}
+
+void Compiler::compile_array(const Node &node, const int field)
+{
+    const auto &element = *node.children[1];
+    const auto element_size = get_fixed_size(element);
+    steps.push_back({StepKind::Array, false, field, element_size, 0});
+    if (!element_size)
+    {
+        const auto array_step = steps.size() - 1;
+        merge_barrier = steps.size();
+        compile(element, "", -1);
+        steps[array_step].body_size = steps.size() - array_step - 1;
+    }
+    // nothing after the array may be merged into its body
+    merge_barrier = steps.size();
+}
+
+void Compiler::compile(const Node &node, const std::string &path, int field)
+{
+    if (is_array(node))
+        compile_array(node, field);
+    else if (node.children.empty())
+    {
+        const auto size = node.type->size;
+        if (size != 1 && size != 2 && size != 4 && size != 8)
+            throw err::CorruptDataError("Bad primitive field size");
+        if (field >= 0)
+        {
+            steps.push_back({
+                StepKind::Number,
+                is_signed_type(node.type->type),
+                field,
+                static_cast<size_t>(size),
+                0});
+        }
+        else
+            add_skip(size);
+    }
+    else if (field >= 0
+        && node.children.size() == 1
+        && is_array(*node.children[0]))
+    {
+        // strings and similar wrappers: capture the array itself
+        compile(*node.children[0], path, field);
+    }
+    else
+        compile_members(node, path);
+
+    if (is_aligned(node))
+        add_align();
+}
+
+static void check_left(const Cursor &cursor, const size_t size)
+{
+    if (static_cast<size_t>(cursor.end - cursor.ptr) < size)
+        throw err::EofError();
+}
+
+static s64 read_number(const u8 *ptr, const size_t size, const bool is_signed)
+{
+    switch (size)
+    {
+        case 1:
+            return is_signed ? static_cast<s8>(*ptr) : *ptr;
+        case 2:
+        {
+            u16 tmp;
+            std::memcpy(&tmp, ptr, 2);
+            tmp = algo::from_little_endian(tmp);
+            return is_signed ? static_cast<s16>(tmp) : tmp;
+        }
+        case 4:
+        {
+            u32 tmp;
+            std::memcpy(&tmp, ptr, 4);
+            tmp = algo::from_little_endian(tmp);
+            return is_signed ? static_cast<s32>(tmp) : tmp;
+        }
+        default:
+        {
+            u64 tmp;
+            std::memcpy(&tmp, ptr, 8);
+            tmp = algo::from_little_endian(tmp);
+            return static_cast<s64>(tmp);
+        }
+    }
+}
+
+// Returns true once last_field has been read.
+static bool run(
+    const Step *step,
+    const Step *end,
+    Cursor &cursor,
+    std::vector<FieldValue> &values,
+    const int last_field)
+{
+    while (step < end)
+    {
+        const auto current = step;
+        switch (step->kind)
+        {
+            case StepKind::Skip:
+                check_left(cursor, step->size);
+                cursor.ptr += step->size;
+                break;
+
+            case StepKind::Align:
+            {
+                const auto pos = cursor.ptr - cursor.start;
+                cursor.ptr = cursor.start + ((pos + 3) & ~3);
+                if (cursor.ptr > cursor.end)
+                    throw err::EofError();
+                break;
+            }
+
+            case StepKind::Number:
+                check_left(cursor, step->size);
+                values[step->field].number
+                    = read_number(cursor.ptr, step->size, step->is_signed);
+                values[step->field].present = true;
+                cursor.ptr += step->size;
+                break;
+
+            case StepKind::Array:
+            {
+                check_left(cursor, 4);
+                u32 count;
+                std::memcpy(&count, cursor.ptr, 4);
+                count = algo::from_little_endian(count);
+                cursor.ptr += 4;
+                if (step->size)
+                {
+                    const auto size = static_cast<u64>(count) * step->size;
+                    check_left(cursor, size);
+                    if (step->field >= 0)
+                    {
+                        values[step->field].data = bstr(cursor.ptr, size);
+                        values[step->field].number = count;
+                        values[step->field].present = true;
+                    }
+                    cursor.ptr += size;
+                }
+                else
+                {
+                    const auto body_end = step + 1 + step->body_size;
+                    for (u32 i = 0; i < count; i++)
+                        run(step + 1, body_end, cursor, values, -1);
+                    step += step->body_size;
+                }
+                break;
+            }
+        }
+
+        if (last_field >= 0
+            && current->field == last_field
+            && current->kind != StepKind::Skip)
+        {
+            return true;
+        }
+        step++;
+    }
+    return false;
+}
+
+struct ReadPlan::Priv final
+{
+    std::vector<Step> steps;
+    size_t field_count;
+};
+
+ReadPlan::ReadPlan(
+    const Node &root_node, const std::vector<std::string> &field_paths)
+    : p(new Priv())
+{
+    Compiler compiler(field_paths);
+    compiler.compile_members(root_node, "");
+    p->steps = std::move(compiler.steps);
+    p->field_count = field_paths.size();
+}
+
+ReadPlan::~ReadPlan()
+{
+}
+
+std::vector<FieldValue> ReadPlan::read(
+    const bstr &object_data, const int last_field) const
+{
+    std::vector<FieldValue> values(p->field_count);
+    Cursor cursor;
+    cursor.start = object_data.get<const u8>();
+    cursor.ptr = cursor.start;
+    cursor.end = cursor.start + object_data.size();
+    run(
+        p->steps.data(),
+        p->steps.data() + p->steps.size(),
+        cursor,
+        values,
+        last_field);
+    return values;
+}
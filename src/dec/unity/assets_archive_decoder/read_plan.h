@@ -0,0 +1,60 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "dec/unity/assets_archive_decoder/node.h"
+
+namespace au {
+namespace dec {
+namespace unity {
+
+    struct FieldValue final
+    {
+        bool present = false;
+        s64 number = 0;
+        bstr data;
+    };
+
+    // Type tree compiled into a flat list of steps. Fields that weren't asked
+    // for are merged into plain skips, so reading an object only does work
+    // for the requested fields and for arrays of variable-sized elements.
+    class ReadPlan final
+    {
+    public:
+        // Field paths are member names joined with dots, e.g.
+        // "m_StreamData.offset". Strings and byte arrays end up in
+        // FieldValue::data, numbers in FieldValue::number.
+        ReadPlan(
+            const Node &root_node,
+            const std::vector<std::string> &field_paths);
+        ~ReadPlan();
+
+        // Reads the requested fields from serialized object data, in the
+        // order of the field paths. With last_field set, stops as soon as
+        // that field is read, so long objects can be read partially.
+        std::vector<FieldValue> read(
+            const bstr &object_data, const int last_field = -1) const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} } }
@@ -0,0 +1,249 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/unity/assets_archive_decoder/texture.h"
+#include "algo/format.h"
+#include "algo/range.h"
+#include "dec/microsoft/dxt/dxt_decoders.h"
+#include "err.h"
+#include "io/memory_byte_stream.h"
+
+using namespace au;
+using namespace au::dec::unity;
+
+namespace
+{
+    enum TextureFormat
+    {
+        Alpha8 = 1,
+        ARGB4444 = 2,
+        RGB24 = 3,
+        RGBA32 = 4,
+        ARGB32 = 5,
+        RGB565 = 7,
+        DXT1 = 10,
+        DXT5 = 12,
+        RGBA4444 = 13,
+        BGRA32 = 14,
+        ETC_RGB4 = 34,
+    };
+}
+
+static const int etc1_modifiers[8][2] =
+{
+    {2, 8}, {5, 17}, {9, 29}, {13, 42},
+    {18, 60}, {24, 80}, {33, 106}, {47, 183},
+};
+
+static u8 clamp(const int value)
+{
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+static void decode_etc1_block(
+    const u8 *block, res::Image &image, const size_t block_x, size_t block_y)
+{
+    const u32 high = (block[0] << 24) | (block[1] << 16)
+        | (block[2] << 8) | block[3];
+    const u32 low = (block[4] << 24) | (block[5] << 16)
+        | (block[6] << 8) | block[7];
+    const bool diff = (high & 2) != 0;
+    const bool flip = (high & 1) != 0;
+
+    int base[2][3];
+    for (const auto c : algo::range(3))
+    {
+        const int shift = 24 - c * 8;
+        if (diff)
+        {
+            int value = (high >> (shift + 3)) & 0x1F;
+            int delta = (high >> shift) & 7;
+            if (delta >= 4)
+                delta -= 8;
+            const int value2 = value + delta;
+            base[0][c] = (value << 3) | (value >> 2);
+            base[1][c] = ((value2 & 0x1F) << 3) | ((value2 & 0x1F) >> 2);
+        }
+        else
+        {
+            base[0][c] = ((high >> (shift + 4)) & 0xF) * 17;
+            base[1][c] = ((high >> shift) & 0xF) * 17;
+        }
+    }
+    const int table[2] = {
+        static_cast<int>((high >> 5) & 7),
+        static_cast<int>((high >> 2) & 7),
+    };
+
+    for (const auto x : algo::range(4))
+    for (const auto y : algo::range(4))
+    {
+        const auto i = x * 4 + y;
+        const auto sub_block = flip ? (y >= 2) : (x >= 2);
+        const auto msb = (low >> (i + 16)) & 1;
+        const auto lsb = (low >> i) & 1;
+        const auto modifier
+            = etc1_modifiers[table[sub_block]][lsb] * (msb ? -1 : 1);
+        const auto &color = base[sub_block];
+        auto &pixel = image.at(block_x + x, block_y + y);
+        pixel.r = clamp(color[0] + modifier);
+        pixel.g = clamp(color[1] + modifier);
+        pixel.b = clamp(color[2] + modifier);
+        pixel.a = 0xFF;
+    }
+}
+
+static std::unique_ptr<res::Image> decode_etc1(
+    const bstr &data, const size_t width, const size_t height)
+{
+    const auto block_width = (width + 3) / 4;
+    const auto block_height = (height + 3) / 4;
+    if (data.size() < block_width * block_height * 8)
+        throw err::BadDataSizeError();
+    auto image = std::make_unique<res::Image>(
+        block_width * 4, block_height * 4);
+    auto block = data.get<const u8>();
+    for (const auto block_y : algo::range(block_height))
+    for (const auto block_x : algo::range(block_width))
+    {
+        decode_etc1_block(block, *image, block_x * 4, block_y * 4);
+        block += 8;
+    }
+    image->crop(width, height);
+    return image;
+}
+
+static std::unique_ptr<res::Image> decode_custom(
+    const bstr &data,
+    const size_t width,
+    const size_t height,
+    const size_t bpp,
+    res::Pixel (*read_pixel)(const u8 *))
+{
+    if (data.size() < width * height * bpp)
+        throw err::BadDataSizeError();
+    auto image = std::make_unique<res::Image>(width, height);
+    auto ptr = data.get<const u8>();
+    for (auto &pixel : *image)
+    {
+        pixel = read_pixel(ptr);
+        ptr += bpp;
+    }
+    return image;
+}
+
+static res::Pixel read_alpha8(const u8 *ptr)
+{
+    return {0xFF, 0xFF, 0xFF, ptr[0]};
+}
+
+static res::Pixel read_argb32(const u8 *ptr)
+{
+    return {ptr[3], ptr[2], ptr[1], ptr[0]};
+}
+
+static res::Pixel read_rgba4444(const u8 *ptr)
+{
+    const u16 tmp = ptr[0] | (ptr[1] << 8);
+    return {
+        static_cast<u8>(((tmp >> 4) & 0xF) * 17),
+        static_cast<u8>(((tmp >> 8) & 0xF) * 17),
+        static_cast<u8>(((tmp >> 12) & 0xF) * 17),
+        static_cast<u8>((tmp & 0xF) * 17),
+    };
+}
+
+static std::unique_ptr<res::Image> decode_dxt(
+    const bstr &data,
+    const size_t width,
+    const size_t height,
+    const bool has_alpha)
+{
+    io::MemoryByteStream data_stream(data);
+    auto image = has_alpha
+        ? dec::microsoft::dxt::decode_dxt5(data_stream, width, height)
+        : dec::microsoft::dxt::decode_dxt1(data_stream, width, height);
+    image->crop(width, height);
+    return image;
+}
+
+static std::unique_ptr<res::Image> decode_plain(
+    const bstr &data,
+    const size_t width,
+    const size_t height,
+    const res::PixelFormat pixel_format)
+{
+    if (data.size() < width * height * res::pixel_format_to_bpp(pixel_format))
+        throw err::BadDataSizeError();
+    return std::make_unique<res::Image>(width, height, data, pixel_format);
+}
+
+std::unique_ptr<res::Image> dec::unity::decode_texture(
+    const int format,
+    const size_t width,
+    const size_t height,
+    const bstr &data)
+{
+    std::unique_ptr<res::Image> image;
+    switch (format)
+    {
+        case TextureFormat::Alpha8:
+            image = decode_custom(data, width, height, 1, read_alpha8);
+            break;
+        case TextureFormat::ARGB4444:
+            image = decode_plain(
+                data, width, height, res::PixelFormat::BGRA4444);
+            break;
+        case TextureFormat::RGB24:
+            image = decode_plain(
+                data, width, height, res::PixelFormat::RGB888);
+            break;
+        case TextureFormat::RGBA32:
+            image = decode_plain(
+                data, width, height, res::PixelFormat::RGBA8888);
+            break;
+        case TextureFormat::ARGB32:
+            image = decode_custom(data, width, height, 4, read_argb32);
+            break;
+        case TextureFormat::RGB565:
+            image = decode_plain(
+                data, width, height, res::PixelFormat::BGR565);
+            break;
+        case TextureFormat::DXT1:
+            image = decode_dxt(data, width, height, false);
+            break;
+        case TextureFormat::DXT5:
+            image = decode_dxt(data, width, height, true);
+            break;
+        case TextureFormat::RGBA4444:
+            image = decode_custom(data, width, height, 2, read_rgba4444);
+            break;
+        case TextureFormat::BGRA32:
+            image = decode_plain(
+                data, width, height, res::PixelFormat::BGRA8888);
+            break;
+        case TextureFormat::ETC_RGB4:
+            image = decode_etc1(data, width, height);
+            break;
+        default:
+            throw err::NotSupportedError(
+                algo::format("Texture format %d is not supported", format));
+    }
+    // Unity stores textures bottom-up
+    image->flip_vertically();
+    return image;
+}
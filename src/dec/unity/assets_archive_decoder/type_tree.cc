@@ -22,6 +22,51 @@
 using namespace au;
 using namespace au::dec::unity;
 
+// Strings shared by all type trees. Node type and name offsets with the top
+// bit set point here instead of into the tree's own string buffer.
+static const char common_strings[] =
+    "AABB\0AnimationClip\0AnimationCurve\0AnimationState\0Array\0Base\0"
+    "BitField\0bitset\0bool\0char\0ColorRGBA\0Component\0data\0deque\0"
+    "double\0dynamic_array\0FastPropertyName\0first\0float\0Font\0"
+    "GameObject\0Generic Mono\0GradientNEW\0GUID\0GUIStyle\0int\0list\0"
+    "long long\0map\0Matrix4x4f\0MdFour\0MonoBehaviour\0MonoScript\0"
+    "m_ByteSize\0m_Curve\0m_EditorClassIdentifier\0m_EditorHideFlags\0"
+    "m_Enabled\0m_ExtensionPtr\0m_GameObject\0m_Index\0m_IsArray\0"
+    "m_IsStatic\0m_MetaFlag\0m_Name\0m_ObjectHideFlags\0m_PrefabInternal\0"
+    "m_PrefabParentObject\0m_Script\0m_StaticEditorFlags\0m_Type\0"
+    "m_Version\0Object\0pair\0PPtr<Component>\0PPtr<GameObject>\0"
+    "PPtr<Material>\0PPtr<MonoBehaviour>\0PPtr<MonoScript>\0PPtr<Object>\0"
+    "PPtr<Prefab>\0PPtr<Sprite>\0PPtr<TextAsset>\0PPtr<Texture>\0"
+    "PPtr<Texture2D>\0PPtr<Transform>\0Prefab\0Quaternionf\0Rectf\0RectInt\0"
+    "RectOffset\0second\0set\0short\0size\0SInt16\0SInt32\0SInt64\0SInt8\0"
+    "staticvector\0string\0TextAsset\0TextMesh\0Texture\0Texture2D\0"
+    "Transform\0TypelessData\0UInt16\0UInt32\0UInt64\0UInt8\0unsigned int\0"
+    "unsigned long long\0unsigned short\0vector\0Vector2f\0Vector3f\0"
+    "Vector4f\0m_ScriptingClassIdentifier\0Gradient\0Type*\0int2_storage\0"
+    "int3_storage\0BoundsInt\0m_CorrespondingSourceObject\0m_PrefabInstance\0"
+    "m_PrefabAsset\0FileSize\0Hash128";
+
+static std::string get_string(const bstr &local_strings, const uoff_t offset)
+{
+    if (offset & 0x80000000)
+    {
+        const auto common_offset = offset & 0x7FFFFFFF;
+        if (common_offset >= sizeof(common_strings))
+            throw err::CorruptDataError("Bad common string offset");
+        return common_strings + common_offset;
+    }
+    if (offset >= local_strings.size())
+        throw err::CorruptDataError("Bad type string offset");
+    return local_strings.get<const char>() + offset;
+}
+
+const TypeRoot *BaseTypeTree::get_by_index(const size_t index) const
+{
+    if (index >= types_in_order.size())
+        throw err::CorruptDataError("Bad type index");
+    return types_in_order[index];
+}
+
 TypeTreeV1::TypeTreeV1(
     CustomStream &input_stream, const TypeReader type_reader)
 {
@@ -37,13 +82,51 @@ TypeTreeV2::TypeTreeV2(
 static std::unique_ptr<Node> read_node_v3(
     CustomStream &input_stream, const TypeReader &type_reader)
 {
-    throw err::NotSupportedError("Type 3 tree nodes are not implemented");
+    // flat list of nodes in depth-first order, followed by their strings
+    const auto node_count = input_stream.read<u32>();
+    const auto string_buffer_size = input_stream.read<u32>();
+    std::vector<std::unique_ptr<BaseType>> types;
+    types.reserve(node_count);
+    for (const auto i : algo::range(node_count))
+        types.push_back(type_reader(input_stream));
+    const auto local_strings = input_stream.read(string_buffer_size);
+
+    std::unique_ptr<Node> root_node;
+    std::vector<Node*> stack;
+    for (auto &type : types)
+    {
+        const auto type_v2 = static_cast<TypeV2*>(type.get());
+        type->type = get_string(local_strings, type_v2->type_offset);
+        type->name = get_string(local_strings, type_v2->name_offset);
+        const auto tree_level = type_v2->tree_level;
+
+        auto node = std::make_unique<Node>();
+        node->type = std::move(type);
+        if (!root_node)
+        {
+            if (tree_level != 0)
+                throw err::CorruptDataError("Type tree has no root");
+            node->parent = nullptr;
+            stack.push_back(node.get());
+            root_node = std::move(node);
+            continue;
+        }
+        if (tree_level < 1 || tree_level > static_cast<int>(stack.size()))
+            throw err::CorruptDataError("Bad type tree level");
+        stack.resize(tree_level);
+        node->parent = stack.back();
+        stack.push_back(node.get());
+        node->parent->children.push_back(std::move(node));
+    }
+    return root_node;
 }
 
 TypeTreeV3::TypeTreeV3(
-    CustomStream &input_stream, const TypeReader type_reader)
+    CustomStream &input_stream,
+    const TypeReader type_reader,
+    const int version)
 {
-    const auto revision = input_stream.read_to_zero();
+    revision = input_stream.read_to_zero().str();
     attributes = input_stream.read<u32>();
 
     is_embedded = input_stream.read<u8>() != 0;
@@ -52,11 +135,24 @@ TypeTreeV3::TypeTreeV3(
     {
         auto type_root = std::make_unique<TypeRoot>();
         type_root->class_id = input_stream.read<s32>();
-        if (type_root->class_id < 0)
+        if (version >= 16)
+            input_stream.skip(1); // is stripped
+        if (version >= 17)
+            input_stream.skip(2); // script type index
+        const auto has_script_id = version >= 16
+            ? type_root->class_id == 114
+            : type_root->class_id < 0;
+        if (has_script_id)
             type_root->script_id = Hash(input_stream);
         type_root->old_type_hash = Hash(input_stream);
         if (is_embedded)
             type_root->root_node = read_node_v3(input_stream, type_reader);
-        operator[](type_root->class_id) = std::move(type_root);
+        types_in_order.push_back(type_root.get());
+        // MonoBehaviours share one class ID, but every script has its own
+        // type; keep them all alive for the index-based lookup.
+        if (find(type_root->class_id) == end())
+            operator[](type_root->class_id) = std::move(type_root);
+        else
+            shadowed_types.push_back(std::move(type_root));
     }
 }
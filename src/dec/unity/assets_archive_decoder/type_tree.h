@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <map>
+#include <vector>
 #include "dec/unity/assets_archive_decoder/custom_stream.h"
 #include "dec/unity/assets_archive_decoder/type.h"
 #include "dec/unity/assets_archive_decoder/type_root.h"
@@ -34,7 +35,13 @@ namespace unity {
     {
         virtual ~BaseTypeTree() {}
 
+        // Objects from format 16 on refer to types by their index in the
+        // file rather than by class ID.
+        const TypeRoot *get_by_index(const size_t index) const;
+
         bool is_embedded;
+        std::vector<const TypeRoot*> types_in_order;
+        std::vector<std::unique_ptr<TypeRoot>> shadowed_types;
     };
 
     struct TypeTreeV1 final : BaseTypeTree
@@ -49,7 +56,10 @@ namespace unity {
 
     struct TypeTreeV3 final : BaseTypeTree
     {
-        TypeTreeV3(CustomStream &input_stream, const TypeReader);
+        TypeTreeV3(
+            CustomStream &input_stream,
+            const TypeReader,
+            const int version);
 
         std::string revision;
         u32 attributes;
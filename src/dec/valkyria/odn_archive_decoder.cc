@@ -82,7 +82,7 @@ static OdnVariant guess_odn_variant(io::BaseByteStream &input_stream)
 
 static void fill_sizes(
     const io::BaseByteStream &input_stream,
-    std::vector<std::unique_ptr<dec::ArchiveEntry>> &entries)
+    std::vector<dec::ArchiveEntryPtr<dec::ArchiveEntry>> &entries)
 {
     if (!entries.size())
         return;
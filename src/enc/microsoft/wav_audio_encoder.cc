@@ -21,68 +21,97 @@
 using namespace au;
 using namespace au::enc::microsoft;
 
-void WavAudioEncoder::encode_impl(
-    const Logger &logger,
-    const res::Audio &input_audio,
-    io::File &output_file) const
+WavAudioStreamWriter::WavAudioStreamWriter(io::BaseByteStream &output_stream)
+    : output_stream(output_stream), start_pos(0), data_size_pos(0), data_size(0)
 {
-    const auto block_align
-        = input_audio.channel_count * input_audio.bits_per_sample / 8;
-    const auto byte_rate = input_audio.sample_rate * block_align;
+}
 
-    output_file.stream.write("RIFF"_b);
-    output_file.stream.write("\x00\x00\x00\x00"_b);
-    output_file.stream.write("WAVE"_b);
+void WavAudioStreamWriter::begin(const res::Audio &format)
+{
+    const auto block_align = format.channel_count * format.bits_per_sample / 8;
+    const auto byte_rate = format.sample_rate * block_align;
 
-    output_file.stream.write("fmt "_b);
-    output_file.stream.write_le<u32>(
-        18 + input_audio.extra_codec_headers.size());
-    output_file.stream.write_le<u16>(input_audio.codec);
-    output_file.stream.write_le<u16>(input_audio.channel_count);
-    output_file.stream.write_le<u32>(input_audio.sample_rate);
-    output_file.stream.write_le<u32>(byte_rate);
-    output_file.stream.write_le<u16>(block_align);
-    output_file.stream.write_le<u16>(input_audio.bits_per_sample);
-    output_file.stream.write_le<u16>(input_audio.extra_codec_headers.size());
-    output_file.stream.write(input_audio.extra_codec_headers);
+    loops = format.loops;
+    start_pos = output_stream.pos();
 
-    output_file.stream.write("data"_b);
-    output_file.stream.write_le<u32>(input_audio.samples.size());
-    output_file.stream.write(input_audio.samples);
+    output_stream.write("RIFF"_b);
+    output_stream.write("\x00\x00\x00\x00"_b);
+    output_stream.write("WAVE"_b);
+
+    output_stream.write("fmt "_b);
+    output_stream.write_le<u32>(18 + format.extra_codec_headers.size());
+    output_stream.write_le<u16>(format.codec);
+    output_stream.write_le<u16>(format.channel_count);
+    output_stream.write_le<u32>(format.sample_rate);
+    output_stream.write_le<u32>(byte_rate);
+    output_stream.write_le<u16>(block_align);
+    output_stream.write_le<u16>(format.bits_per_sample);
+    output_stream.write_le<u16>(format.extra_codec_headers.size());
+    output_stream.write(format.extra_codec_headers);
+
+    output_stream.write("data"_b);
+    data_size_pos = output_stream.pos();
+    output_stream.write("\x00\x00\x00\x00"_b);
+    data_size = 0;
+}
+
+void WavAudioStreamWriter::write(const bstr &samples)
+{
+    output_stream.write(samples);
+    data_size += samples.size();
+}
 
-    if (!input_audio.loops.empty())
+void WavAudioStreamWriter::finish()
+{
+    if (!loops.empty())
     {
         const auto extra_data = ""_b;
-        output_file.stream.write("smpl"_b);
-        output_file.stream.write_le<u32>(36
-            + (24 * input_audio.loops.size()) + extra_data.size());
-        output_file.stream.write_le<u32>(0); // manufacturer
-        output_file.stream.write_le<u32>(0); // product
-        output_file.stream.write_le<u32>(0); // sample period
-        output_file.stream.write_le<u32>(0); // midi unity note
-        output_file.stream.write_le<u32>(0); // midi pitch fraction
-        output_file.stream.write_le<u32>(0); // smpte format
-        output_file.stream.write_le<u32>(0); // smpte offset
-        output_file.stream.write_le<u32>(input_audio.loops.size());
-        output_file.stream.write_le<u32>(extra_data.size());
-        for (const auto i : algo::range(input_audio.loops.size()))
+        output_stream.write("smpl"_b);
+        output_stream.write_le<u32>(36
+            + (24 * loops.size()) + extra_data.size());
+        output_stream.write_le<u32>(0); // manufacturer
+        output_stream.write_le<u32>(0); // product
+        output_stream.write_le<u32>(0); // sample period
+        output_stream.write_le<u32>(0); // midi unity note
+        output_stream.write_le<u32>(0); // midi pitch fraction
+        output_stream.write_le<u32>(0); // smpte format
+        output_stream.write_le<u32>(0); // smpte offset
+        output_stream.write_le<u32>(loops.size());
+        output_stream.write_le<u32>(extra_data.size());
+        for (const auto i : algo::range(loops.size()))
         {
-            const auto loop = input_audio.loops[i];
-            output_file.stream.write_le<u32>(i);
-            output_file.stream.write_le<u32>(0); // type
-            output_file.stream.write_le<u32>(loop.start);
-            output_file.stream.write_le<u32>(loop.end);
-            output_file.stream.write_le<u32>(0); // fraction
-            output_file.stream.write_le<u32>(loop.play_count);
+            const auto loop = loops[i];
+            output_stream.write_le<u32>(i);
+            output_stream.write_le<u32>(0); // type
+            output_stream.write_le<u32>(loop.start);
+            output_stream.write_le<u32>(loop.end);
+            output_stream.write_le<u32>(0); // fraction
+            output_stream.write_le<u32>(loop.play_count);
         }
-        output_file.stream.write(extra_data);
+        output_stream.write(extra_data);
     }
 
-    output_file.stream.seek(4);
-    output_file.stream.write_le<u32>(output_file.stream.size() - 8);
+    const auto end_pos = output_stream.pos();
+    output_stream.seek(data_size_pos);
+    output_stream.write_le<u32>(data_size);
+    output_stream.seek(start_pos + 4);
+    output_stream.write_le<u32>(end_pos - start_pos - 8);
+    output_stream.seek(end_pos);
+}
+
+std::string WavAudioStreamWriter::get_extension() const
+{
+    return loops.empty() ? "wav" : "wavloop";
+}
 
-    if (!input_audio.loops.empty())
-        output_file.path.change_extension("wavloop");
-    else
-        output_file.path.change_extension("wav");
+void WavAudioEncoder::encode_impl(
+    const Logger &logger,
+    const res::Audio &input_audio,
+    io::File &output_file) const
+{
+    WavAudioStreamWriter writer(output_file.stream);
+    writer.begin(input_audio);
+    writer.write(input_audio.samples);
+    writer.finish();
+    output_file.path.change_extension(writer.get_extension());
 }
@@ -32,4 +32,26 @@ namespace microsoft {
             io::File &output_file) const override;
     };
 
+    // Writes a .wav incrementally: the RIFF and data chunk sizes are left
+    // blank and patched by finish(), once the sample count is known.
+    class WavAudioStreamWriter final : public res::IAudioSink
+    {
+    public:
+        WavAudioStreamWriter(io::BaseByteStream &output_stream);
+
+        void begin(const res::Audio &format) override;
+        void write(const bstr &samples) override;
+        void finish();
+
+        // "wav" or "wavloop", available after begin()
+        std::string get_extension() const;
+
+    private:
+        io::BaseByteStream &output_stream;
+        std::vector<res::AudioLoopInfo> loops;
+        uoff_t start_pos;
+        uoff_t data_size_pos;
+        uoff_t data_size;
+    };
+
 } } }
@@ -18,12 +18,16 @@
 #include "flow/cli_facade.h"
 #include <algorithm>
 #include <map>
+#include "algo/format.h"
 #include "algo/range.h"
 #include "algo/str.h"
 #include "arg_parser.h"
 #include "dec/idecoder.h"
 #include "dec/registry.h"
+#include "err.h"
+#include "flow/file_saver_archive.h"
 #include "flow/file_saver_hdd.h"
+#include "flow/input_collector.h"
 #include "flow/parallel_unpacker.h"
 #include "io/file_system.h"
 #include "version.h"
@@ -32,21 +36,42 @@
 using namespace au;
 using namespace au::flow;
 
+static const size_t default_max_breadth = 1024;
+
+static int get_int_switch(
+    const ArgParser &arg_parser, const std::string &name, const int min_value)
+{
+    const auto value = algo::from_string<int>(arg_parser.get_switch(name));
+    if (value < min_value)
+    {
+        throw err::UsageError(algo::format(
+            "%s must be at least %d", name.c_str(), min_value));
+    }
+    return value;
+}
+
 namespace
 {
     struct Options final
     {
         std::string decoder;
         io::path output_dir;
+        io::path output_archive_path;
+        io::path stats_path;
         std::vector<io::path> input_paths;
+        EntryFilter entry_filter;
         bool overwrite;
         bool enable_nested_decoding;
         bool enable_virtual_file_system;
         bool should_show_help;
         bool should_show_version;
         bool should_list_decoders;
+        bool should_list_entries;
+        bool read_ahead;
         int verbosity = 3;
         unsigned int thread_count;
+        unsigned int save_thread_count;
+        size_t max_breadth;
     };
 }
 
@@ -179,6 +204,13 @@ void CliFacade::Priv::register_cli_options()
         ->set_value_name("NUM")
         ->set_description("Sets worker thread count.");
 
+    arg_parser.register_switch({"--save-threads"})
+        ->set_value_name("NUM")
+        ->set_description(
+            "Saves the decoded files on NUM separate threads, so that the "
+            "workers can decode the next files in the meantime. 0 makes the "
+            "workers save the files themselves (default).");
+
     {
         auto sw = arg_parser.register_switch({"-v", "--verbosity"})
             ->set_description(
@@ -202,6 +234,51 @@ void CliFacade::Priv::register_cli_options()
     arg_parser.register_flag({"--no-recurse"})
         ->set_description("Disables automatic decoding of nested files.");
 
+    arg_parser.register_switch({"--include"})
+        ->set_value_name("GLOB")
+        ->set_description(
+            "Extracts only the archive entries matching given pattern. "
+            "Nested archives are still unpacked to look for them. "
+            "Can be used multiple times. * and ? don't match /, ** does. "
+            "Patterns without / are matched against file names.");
+
+    arg_parser.register_switch({"--exclude"})
+        ->set_value_name("GLOB")
+        ->set_description(
+            "Skips the archive entries matching given pattern. "
+            "Can be used multiple times.");
+
+    arg_parser.register_flag({"--list"})
+        ->set_description(
+            "Lists archive entries with their sizes and offsets "
+            "instead of extracting them.");
+
+    arg_parser.register_flag({"--read-ahead"})
+        ->set_description(
+            "Reads each archive from start to end on one thread, leaving "
+            "the decoding to the other threads. Faster on hard drives and "
+            "network storage.");
+
+    arg_parser.register_switch({"--out-archive"})
+        ->set_value_name("FILE")
+        ->set_description(
+            "Writes all the files into one uncompressed archive instead of "
+            "the output directory. The archive is a zip if FILE ends with "
+            ".zip and a tar otherwise.");
+
+    arg_parser.register_switch({"--breadth"})
+        ->set_value_name("NUM")
+        ->set_description(
+            "Queues at most NUM entries of each archive at a time, so that "
+            "nested archives are unpacked before the next entries get read "
+            "(defaults to 1024).");
+
+    arg_parser.register_switch({"--stats"})
+        ->set_value_name("FILE")
+        ->set_description(
+            "Writes per-decoder timings of recognition, reading, decoding, "
+            "encoding and saving to given file as JSON.");
+
     arg_parser.register_flag({"--no-vfs"})
         ->set_description("Disables virtual file system lookups.");
 
@@ -219,6 +296,10 @@ void CliFacade::Priv::parse_cli_options()
     options.should_list_decoders
         = arg_parser.has_flag("-l") || arg_parser.has_flag("--list-decoders");
 
+    options.should_list_entries = arg_parser.has_flag("--list");
+
+    options.read_ahead = arg_parser.has_flag("--read-ahead");
+
     options.overwrite
         = !arg_parser.has_flag("-r") && !arg_parser.has_flag("--rename");
 
@@ -244,6 +325,19 @@ void CliFacade::Priv::parse_cli_options()
     else
         options.thread_count = 0;
 
+    options.save_thread_count = arg_parser.has_switch("--save-threads")
+        ? get_int_switch(arg_parser, "--save-threads", 0)
+        : 0;
+
+    options.max_breadth = arg_parser.has_switch("--breadth")
+        ? get_int_switch(arg_parser, "--breadth", 1)
+        : default_max_breadth;
+
+    for (const auto &pattern : arg_parser.get_switch_values("--include"))
+        options.entry_filter.include(pattern);
+    for (const auto &pattern : arg_parser.get_switch_values("--exclude"))
+        options.entry_filter.exclude(pattern);
+
     if (arg_parser.has_flag("--no-vfs"))
         VirtualFileSystem::disable();
 
@@ -254,24 +348,19 @@ void CliFacade::Priv::parse_cli_options()
     else
         options.output_dir = "./";
 
+    if (arg_parser.has_switch("--out-archive"))
+        options.output_archive_path = arg_parser.get_switch("--out-archive");
+
+    if (arg_parser.has_switch("--stats"))
+        options.stats_path = arg_parser.get_switch("--stats");
+
     if (arg_parser.has_switch("-d"))
         options.decoder = arg_parser.get_switch("-d");
     if (arg_parser.has_switch("--dec"))
         options.decoder = arg_parser.get_switch("--dec");
 
     for (const auto &stray : arg_parser.get_stray())
-    {
-        if (io::is_directory(stray))
-        {
-            for (const auto &path : io::recursive_directory_range(stray))
-                if (!io::is_directory(path))
-                    options.input_paths.push_back(path);
-        }
-        else
-        {
-            options.input_paths.push_back(stray);
-        }
-    }
+        options.input_paths.push_back(stray);
 }
 
 int CliFacade::Priv::run() const
@@ -306,29 +395,107 @@ int CliFacade::Priv::run() const
         ? std::set<std::string>(name_list.begin(), name_list.end())
         : std::set<std::string>{options.decoder};
 
-    FileSaverHdd file_saver(options.output_dir, options.overwrite);
+    // inputs are collected before the output archive gets created, and an
+    // archive left by an earlier run is skipped, so that it never ends up
+    // decoding its own output
+    auto input_files = collect_input_files(
+        options.input_paths, options.thread_count);
+    if (io::exists(options.output_archive_path))
+    {
+        input_files.erase(
+            std::remove_if(
+                input_files.begin(),
+                input_files.end(),
+                [&](const InputFile &input_file)
+                {
+                    return io::is_same_file(
+                        input_file.path, options.output_archive_path);
+                }),
+            input_files.end());
+    }
+    for (const auto &directory : get_input_directories(input_files))
+        VirtualFileSystem::register_directory(directory);
+
+    std::unique_ptr<FileSaverArchive> archive_file_saver;
+    std::unique_ptr<FileSaverHdd> hdd_file_saver;
+    if (!options.output_archive_path.str().empty())
+    {
+        try
+        {
+            archive_file_saver = std::make_unique<FileSaverArchive>(
+                options.output_archive_path,
+                FileSaverArchive::guess_format(options.output_archive_path));
+        }
+        catch (const std::exception &e)
+        {
+            logger.err("Error creating output archive (%s)\n", e.what());
+            return 1;
+        }
+    }
+    else
+    {
+        hdd_file_saver = std::make_unique<FileSaverHdd>(
+            options.output_dir, options.overwrite);
+    }
+    const IFileSaver &file_saver = archive_file_saver
+        ? static_cast<const IFileSaver&>(*archive_file_saver)
+        : *hdd_file_saver;
+
     ParallelUnpackerContext context(
         logger,
         file_saver,
         registry,
         options.enable_nested_decoding,
         arguments,
-        available_decoders);
+        available_decoders,
+        options.entry_filter,
+        options.should_list_entries,
+        options.read_ahead,
+        options.max_breadth);
 
     ParallelUnpacker unpacker(context);
-    for (const auto &input_path : options.input_paths)
+    for (const auto &input_file : input_files)
     {
+        const auto &input_path = input_file.path;
         unpacker.add_input_file(
             io::path(input_path).change_stem(input_path.stem() + "~").name(),
             [&]()
             {
-                VirtualFileSystem::register_directory(
-                    io::absolute(input_path).parent());
                 return std::make_shared<io::File>(
                     io::absolute(input_path), io::FileMode::Read);
             });
     }
-    return unpacker.run(options.thread_count) ? 0 : 1;
+    const auto result = unpacker.run(
+        options.thread_count, options.save_thread_count);
+
+    if (archive_file_saver)
+    {
+        try
+        {
+            archive_file_saver->finish();
+        }
+        catch (const std::exception &e)
+        {
+            logger.err("Error finishing output archive (%s)\n", e.what());
+            return 1;
+        }
+    }
+
+    if (!options.stats_path.str().empty())
+    {
+        try
+        {
+            io::File stats_file(options.stats_path, io::FileMode::Write);
+            stats_file.stream.write(unpacker.get_stats().to_json());
+        }
+        catch (const std::exception &e)
+        {
+            logger.err("Error writing stats (%s)\n", e.what());
+            return 1;
+        }
+    }
+
+    return result ? 0 : 1;
 }
 
 CliFacade::CliFacade(Logger &logger, const std::vector<std::string> &arguments)
@@ -0,0 +1,62 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/entry_filter.h"
+#include <algorithm>
+
+using namespace au;
+using namespace au::flow;
+
+void EntryFilter::include(const std::string &pattern)
+{
+    included.emplace_back(pattern);
+}
+
+void EntryFilter::exclude(const std::string &pattern)
+{
+    excluded.emplace_back(pattern);
+}
+
+bool EntryFilter::is_empty() const
+{
+    return included.empty() && excluded.empty();
+}
+
+bool EntryFilter::includes(const io::path &path) const
+{
+    if (included.empty())
+        return true;
+    const auto str = path.str();
+    return std::any_of(
+        included.begin(),
+        included.end(),
+        [&](const algo::Glob &glob) { return glob.matches(str); });
+}
+
+bool EntryFilter::excludes(const io::path &path) const
+{
+    const auto str = path.str();
+    return std::any_of(
+        excluded.begin(),
+        excluded.end(),
+        [&](const algo::Glob &glob) { return glob.matches(str); });
+}
+
+bool EntryFilter::accepts(const io::path &path) const
+{
+    return includes(path) && !excludes(path);
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "algo/glob.h"
+#include "io/path.h"
+
+namespace au {
+namespace flow {
+
+    // Selects archive entries to extract by their path in the archive.
+    // An entry is accepted if it matches any of the included patterns (or
+    // there are none) and none of the excluded ones. The two halves can be
+    // checked apart, since excluded entries can be skipped right away while
+    // the included ones may sit inside nested archives.
+    class EntryFilter final
+    {
+    public:
+        void include(const std::string &pattern);
+        void exclude(const std::string &pattern);
+
+        bool is_empty() const;
+        bool includes(const io::path &path) const;
+        bool excludes(const io::path &path) const;
+        bool accepts(const io::path &path) const;
+
+    private:
+        std::vector<algo::Glob> included;
+        std::vector<algo::Glob> excluded;
+    };
+
+} }
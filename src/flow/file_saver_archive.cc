@@ -0,0 +1,504 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "flow/file_saver_archive.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "algo/format.h"
+#include "algo/hash/crc.h"
+#include "algo/str.h"
+#include "err.h"
+#include "io/file_byte_stream.h"
+#include "io/file_range.h"
+#include "io/memory_byte_stream.h"
+
+using namespace au;
+using namespace au::flow;
+
+// the headers and small files are gathered in memory and written in chunks
+// of this size
+static const size_t write_buffer_size = 4 * 1024 * 1024;
+
+// files up to this size are read before taking the lock, so that the writes
+// are the only thing the saving threads wait for each other with
+static const uoff_t max_preloaded_file_size = 1024 * 1024;
+
+static const size_t crc_chunk_size = 1024 * 1024;
+static const size_t tar_block_size = 512;
+static const uoff_t max_tar_size = 077777777777;
+static const size_t max_tar_name_size = 100;
+static const u32 zip_limit = 0xFFFFFFFF;
+static const u16 zip_count_limit = 0xFFFF;
+
+// names are in UTF-8
+static const u16 zip_flags = 0x800;
+
+namespace
+{
+    struct ZipEntry final
+    {
+        std::string name;
+        u32 crc;
+        uoff_t size;
+        uoff_t offset;
+    };
+}
+
+// Archives can hold neither absolute paths nor ones leading outside of them.
+static std::string get_entry_name(const io::path &path)
+{
+    std::string name;
+    for (const auto &part : algo::split(path.str(), '/', false))
+    {
+        if (part.empty() || part == "." || part == "..")
+            continue;
+        if (!name.empty())
+            name += "/";
+        name += part;
+    }
+    return name.empty() ? "unnamed" : name;
+}
+
+static void write_octal(char *target, const size_t size, const u64 value)
+{
+    const auto str = algo::format(
+        "%0*llo", static_cast<int>(size - 1), value);
+    std::memcpy(target, str.c_str(), size);
+}
+
+static bstr make_tar_header(
+    const std::string &name,
+    const uoff_t size,
+    const char type,
+    const u64 mtime)
+{
+    bstr header(tar_block_size);
+    const auto data = header.get<char>();
+    std::memcpy(data, name.c_str(), std::min(name.size(), max_tar_name_size));
+    write_octal(data + 100, 8, 0644);
+    write_octal(data + 108, 8, 0);
+    write_octal(data + 116, 8, 0);
+    write_octal(data + 124, 12, std::min(size, max_tar_size));
+    write_octal(data + 136, 12, mtime);
+    data[156] = type;
+    std::memcpy(data + 257, "ustar", 6);
+    std::memcpy(data + 263, "00", 2);
+
+    // computed with the checksum field itself filled with spaces
+    std::memset(data + 148, ' ', 8);
+    u32 checksum = 0;
+    for (const auto c : header)
+        checksum += c;
+    write_octal(data + 148, 7, checksum);
+    return header;
+}
+
+static std::string make_pax_record(
+    const std::string &key, const std::string &value)
+{
+    // the length includes its own digits
+    const auto body = " " + key + "=" + value + "\n";
+    auto size = body.size() + 1;
+    while (algo::format("%d", size).size() + body.size() != size)
+        size++;
+    return algo::format("%d", size) + body;
+}
+
+static bstr get_tar_padding(const uoff_t size)
+{
+    return bstr((tar_block_size - size % tar_block_size) % tar_block_size);
+}
+
+static void get_dos_time(const std::time_t time, u16 &dos_time, u16 &dos_date)
+{
+    const auto tm = std::localtime(&time);
+    if (!tm || tm->tm_year < 80)
+    {
+        dos_time = 0;
+        dos_date = (1 << 5) | 1;
+        return;
+    }
+    dos_time = (tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2);
+    dos_date = ((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5)
+        | tm->tm_mday;
+}
+
+struct FileSaverArchive::Priv final
+{
+    Priv(const io::path &output_path, const ArchiveFormat format);
+
+    std::string make_name_unique(const std::string &name);
+    void write(const bstr &data);
+    void write(io::BaseByteStream &input_stream, const uoff_t size);
+    void flush();
+    void fail();
+    void write_tar_headers(const std::string &name, const uoff_t size);
+    void write_zip_header(
+        const std::string &name, const uoff_t size, const u32 crc);
+    void write_zip_central_directory();
+
+    std::mutex mutex;
+    const io::path output_path;
+    const ArchiveFormat format;
+    std::unique_ptr<io::FileByteStream> output_stream;
+    bstr buffer;
+    uoff_t position;
+    bool failed;
+
+    // Files count as saved only once the buffer holding their last bytes is
+    // written out.
+    size_t saved_file_count;
+    size_t buffered_file_count;
+    std::unordered_set<std::string> names;
+    std::vector<ZipEntry> zip_entries;
+    u64 mtime;
+    u16 dos_time, dos_date;
+};
+
+FileSaverArchive::Priv::Priv(
+    const io::path &output_path, const ArchiveFormat format) :
+        output_path(output_path),
+        format(format),
+        output_stream(std::make_unique<io::FileByteStream>(
+            output_path, io::FileMode::Write)),
+        position(0),
+        failed(false),
+        saved_file_count(0),
+        buffered_file_count(0)
+{
+    buffer.reserve(write_buffer_size);
+    const auto now = std::time(nullptr);
+    mtime = std::max<std::time_t>(now, 0);
+    get_dos_time(now, dos_time, dos_date);
+}
+
+std::string FileSaverArchive::Priv::make_name_unique(const std::string &name)
+{
+    io::path new_name = name;
+    int i = 1;
+    while (names.find(new_name.str()) != names.end())
+        new_name.change_stem(io::path(name).stem() + algo::format("(%d)", i++));
+    names.insert(new_name.str());
+    return new_name.str();
+}
+
+void FileSaverArchive::Priv::write(const bstr &data)
+{
+    if (buffer.size() + data.size() > write_buffer_size)
+        flush();
+    if (data.size() >= write_buffer_size)
+        output_stream->write(data);
+    else
+        buffer += data;
+    position += data.size();
+}
+
+void FileSaverArchive::Priv::write(
+    io::BaseByteStream &input_stream, const uoff_t size)
+{
+    flush();
+    if (const auto range = io::get_file_range(input_stream))
+        output_stream->write_file_range(*range);
+    else
+        output_stream->write(input_stream.seek(0));
+    position += size;
+}
+
+void FileSaverArchive::Priv::flush()
+{
+    if (!buffer.empty())
+    {
+        output_stream->write(buffer);
+        buffer.resize(0);
+    }
+    output_stream->flush();
+    saved_file_count += buffered_file_count;
+    buffered_file_count = 0;
+}
+
+// After a failed write, the position no longer matches the file and the
+// entry being written is cut short, so nothing after it could be read back.
+// The archive stops taking files rather than pretending to.
+void FileSaverArchive::Priv::fail()
+{
+    failed = true;
+    output_stream.reset();
+    buffer = bstr();
+    buffered_file_count = 0;
+    zip_entries.clear();
+}
+
+void FileSaverArchive::Priv::write_tar_headers(
+    const std::string &name, const uoff_t size)
+{
+    std::string pax_records;
+    if (name.size() > max_tar_name_size)
+        pax_records += make_pax_record("path", name);
+    if (size > max_tar_size)
+        pax_records += make_pax_record("size", algo::format("%llu", size));
+    if (!pax_records.empty())
+    {
+        write(make_tar_header("PaxHeader", pax_records.size(), 'x', mtime));
+        write(bstr(pax_records));
+        write(get_tar_padding(pax_records.size()));
+    }
+    write(make_tar_header(name, size, '0', mtime));
+}
+
+void FileSaverArchive::Priv::write_zip_header(
+    const std::string &name, const uoff_t size, const u32 crc)
+{
+    const auto zip64 = size >= zip_limit;
+    io::MemoryByteStream header_stream;
+    header_stream.write_le<u32>(0x04034B50);
+    header_stream.write_le<u16>(zip64 ? 45 : 20);
+    header_stream.write_le<u16>(zip_flags);
+    header_stream.write_le<u16>(0);
+    header_stream.write_le<u16>(dos_time);
+    header_stream.write_le<u16>(dos_date);
+    header_stream.write_le<u32>(crc);
+    header_stream.write_le<u32>(zip64 ? zip_limit : size);
+    header_stream.write_le<u32>(zip64 ? zip_limit : size);
+    header_stream.write_le<u16>(name.size());
+    header_stream.write_le<u16>(zip64 ? 20 : 0);
+    header_stream.write(name);
+    if (zip64)
+    {
+        header_stream.write_le<u16>(1);
+        header_stream.write_le<u16>(16);
+        header_stream.write_le<u64>(size);
+        header_stream.write_le<u64>(size);
+    }
+    write(header_stream.seek(0).read_to_eof());
+}
+
+void FileSaverArchive::Priv::write_zip_central_directory()
+{
+    const auto directory_offset = position;
+    io::MemoryByteStream header_stream;
+    for (const auto &entry : zip_entries)
+    {
+        const auto zip64_size = entry.size >= zip_limit;
+        const auto zip64_offset = entry.offset >= zip_limit;
+        const auto zip64 = zip64_size || zip64_offset;
+        header_stream.write_le<u32>(0x02014B50);
+        header_stream.write_le<u16>(zip64 ? 45 : 20);
+        header_stream.write_le<u16>(zip64 ? 45 : 20);
+        header_stream.write_le<u16>(zip_flags);
+        header_stream.write_le<u16>(0);
+        header_stream.write_le<u16>(dos_time);
+        header_stream.write_le<u16>(dos_date);
+        header_stream.write_le<u32>(entry.crc);
+        header_stream.write_le<u32>(zip64_size ? zip_limit : entry.size);
+        header_stream.write_le<u32>(zip64_size ? zip_limit : entry.size);
+        header_stream.write_le<u16>(entry.name.size());
+        header_stream.write_le<u16>(
+            zip64 ? 4 + zip64_size * 16 + zip64_offset * 8 : 0);
+        header_stream.write_le<u16>(0);
+        header_stream.write_le<u16>(0);
+        header_stream.write_le<u16>(0);
+        header_stream.write_le<u32>(0);
+        header_stream.write_le<u32>(zip64_offset ? zip_limit : entry.offset);
+        header_stream.write(entry.name);
+        if (zip64)
+        {
+            header_stream.write_le<u16>(1);
+            header_stream.write_le<u16>(zip64_size * 16 + zip64_offset * 8);
+            if (zip64_size)
+            {
+                header_stream.write_le<u64>(entry.size);
+                header_stream.write_le<u64>(entry.size);
+            }
+            if (zip64_offset)
+                header_stream.write_le<u64>(entry.offset);
+        }
+    }
+    write(header_stream.seek(0).read_to_eof());
+
+    const auto directory_size = position - directory_offset;
+    const auto count = zip_entries.size();
+    const auto zip64 = count >= zip_count_limit
+        || directory_offset >= zip_limit
+        || directory_size >= zip_limit;
+    io::MemoryByteStream end_stream;
+    if (zip64)
+    {
+        const auto end_offset = position;
+        end_stream.write_le<u32>(0x06064B50);
+        end_stream.write_le<u64>(44);
+        end_stream.write_le<u16>(45);
+        end_stream.write_le<u16>(45);
+        end_stream.write_le<u32>(0);
+        end_stream.write_le<u32>(0);
+        end_stream.write_le<u64>(count);
+        end_stream.write_le<u64>(count);
+        end_stream.write_le<u64>(directory_size);
+        end_stream.write_le<u64>(directory_offset);
+
+        end_stream.write_le<u32>(0x07064B50);
+        end_stream.write_le<u32>(0);
+        end_stream.write_le<u64>(end_offset);
+        end_stream.write_le<u32>(1);
+    }
+    end_stream.write_le<u32>(0x06054B50);
+    end_stream.write_le<u16>(0);
+    end_stream.write_le<u16>(0);
+    end_stream.write_le<u16>(zip64 ? zip_count_limit : count);
+    end_stream.write_le<u16>(zip64 ? zip_count_limit : count);
+    end_stream.write_le<u32>(zip64 ? zip_limit : directory_size);
+    end_stream.write_le<u32>(zip64 ? zip_limit : directory_offset);
+    end_stream.write_le<u16>(0);
+    write(end_stream.seek(0).read_to_eof());
+}
+
+FileSaverArchive::FileSaverArchive(
+    const io::path &output_path, const ArchiveFormat format)
+    : p(new Priv(output_path, format))
+{
+}
+
+FileSaverArchive::~FileSaverArchive()
+{
+    try
+    {
+        finish();
+    }
+    catch (...)
+    {
+    }
+}
+
+ArchiveFormat FileSaverArchive::guess_format(const io::path &output_path)
+{
+    return output_path.has_extension("zip")
+        ? ArchiveFormat::Zip
+        : ArchiveFormat::Tar;
+}
+
+io::path FileSaverArchive::save(std::shared_ptr<io::File> file) const
+{
+    auto &input_stream = file->stream;
+    const auto size = input_stream.size();
+    const auto preload = size <= max_preloaded_file_size
+        && !io::get_file_range(input_stream);
+    bstr content;
+    if (preload)
+        content = input_stream.seek(0).read(size);
+
+    // computed before taking the lock, so the threads can do it in parallel
+    u32 crc = 0;
+    if (p->format == ArchiveFormat::Zip)
+    {
+        if (preload)
+            crc = algo::hash::crc32(content);
+        else
+        {
+            input_stream.seek(0);
+            while (input_stream.left())
+            {
+                crc = algo::hash::crc32(
+                    input_stream.read(
+                        std::min<uoff_t>(crc_chunk_size, input_stream.left())),
+                    crc);
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(p->mutex);
+    if (p->failed)
+        throw err::IoError("The archive could not be written");
+    if (!p->output_stream)
+        throw err::IoError("The archive is already finished");
+    const auto name = p->make_name_unique(get_entry_name(file->path));
+    const auto offset = p->position;
+    try
+    {
+        if (p->format == ArchiveFormat::Zip)
+            p->write_zip_header(name, size, crc);
+        else
+            p->write_tar_headers(name, size);
+        if (preload)
+            p->write(content);
+        else
+            p->write(input_stream, size);
+        if (p->format == ArchiveFormat::Zip)
+            p->zip_entries.push_back({name, crc, size, offset});
+        else
+            p->write(get_tar_padding(size));
+    }
+    catch (const std::exception &e)
+    {
+        const auto lost_file_count = p->buffered_file_count;
+        p->fail();
+        throw err::IoError(algo::format(
+            "%s; %d earlier files were lost with it",
+            e.what(),
+            static_cast<int>(lost_file_count)));
+    }
+    p->buffered_file_count++;
+    if (p->buffer.empty())
+    {
+        p->saved_file_count += p->buffered_file_count;
+        p->buffered_file_count = 0;
+    }
+    return p->output_path / name;
+}
+
+io::path FileSaverArchive::save(const FileWriter &writer) const
+{
+    auto file = std::make_shared<io::File>();
+    file->path = writer(file->stream);
+    return save(file);
+}
+
+size_t FileSaverArchive::get_saved_file_count() const
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    return p->saved_file_count;
+}
+
+void FileSaverArchive::finish()
+{
+    std::unique_lock<std::mutex> lock(p->mutex);
+    if (p->failed)
+        throw err::IoError("The archive could not be written");
+    if (!p->output_stream)
+        return;
+    try
+    {
+        if (p->format == ArchiveFormat::Zip)
+            p->write_zip_central_directory();
+        else
+            p->write(bstr(tar_block_size * 2));
+        p->flush();
+    }
+    catch (const std::exception &e)
+    {
+        const auto lost_file_count = p->buffered_file_count;
+        p->fail();
+        throw err::IoError(algo::format(
+            "%s; %d files were lost with it",
+            e.what(),
+            static_cast<int>(lost_file_count)));
+    }
+    p->output_stream.reset();
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <memory>
+#include "flow/ifile_saver.h"
+
+namespace au {
+namespace flow {
+
+    enum class ArchiveFormat : u8
+    {
+        Tar,
+        Zip,
+    };
+
+    // Appends all the saved files to one uncompressed tar or store-only zip
+    // instead of creating them one by one. Files are appended in the order
+    // they're saved; the archive is complete only after finish().
+    class FileSaverArchive final : public IFileSaver
+    {
+    public:
+        FileSaverArchive(const io::path &output_path, const ArchiveFormat);
+        ~FileSaverArchive();
+
+        // Picks zip for paths ending with .zip and tar for everything else.
+        static ArchiveFormat guess_format(const io::path &output_path);
+
+        io::path save(std::shared_ptr<io::File> file) const override;
+        io::path save(const FileWriter &writer) const override;
+        size_t get_saved_file_count() const override;
+
+        // Writes the archive trailer (and the central directory of zips).
+        void finish();
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+} }
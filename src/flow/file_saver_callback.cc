@@ -58,6 +58,13 @@ io::path FileSaverCallback::save(std::shared_ptr<io::File> file) const
     return file->path;
 }
 
+io::path FileSaverCallback::save(const FileWriter &writer) const
+{
+    auto file = std::make_shared<io::File>();
+    file->path = writer(file->stream);
+    return save(file);
+}
+
 size_t FileSaverCallback::get_saved_file_count() const
 {
     return p->saved_file_count;
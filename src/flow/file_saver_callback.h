@@ -34,6 +34,7 @@ namespace flow {
 
         void set_callback(FileSaveCallback callback);
         io::path save(std::shared_ptr<io::File> file) const override;
+        io::path save(const FileWriter &writer) const override;
         size_t get_saved_file_count() const override;
 
     private:
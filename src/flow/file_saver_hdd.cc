@@ -17,28 +17,57 @@
 
 #include "flow/file_saver_hdd.h"
 #include <mutex>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include "algo/format.h"
+#include "algo/str.h"
+#include "err.h"
 #include "io/file_byte_stream.h"
+#include "io/file_range.h"
 #include "io/file_system.h"
 
 using namespace au;
 using namespace au::flow;
 
+// files up to this size are written with a single system call
+static const uoff_t max_small_file_size = 1024 * 1024;
+
 static std::mutex mutex;
 
+// The default file systems of Windows and macOS ignore case, so names that
+// differ only in case have to be told apart as if they were the same.
+static std::string get_name_key(const std::string &name)
+{
+    #if _WIN32 || __APPLE__
+        return algo::lower(name);
+    #else
+        return name;
+    #endif
+}
+
 struct FileSaverHdd::Priv final
 {
     Priv(
         const io::path &output_dir,
         const bool overwrite);
 
+    void prepare_directory(const io::path &directory);
     io::path make_path_unique(const io::path &path);
+    io::path create_file(const io::path &target_path, const bstr &content);
 
     io::path output_dir;
     bool overwrite;
     size_t saved_file_count;
-    std::set<io::path> paths;
+
+    // Kept as plain strings, since comparing io::paths is comparatively slow
+    // and all of these are built the same way anyway.
+    std::unordered_set<std::string> paths;
+
+    // Directories known to exist, along with the names of the files they
+    // held before anything was saved there, so that each is listed only once
+    // instead of probing the disk for every saved file.
+    std::unordered_map<std::string, std::unordered_set<std::string>>
+        directories;
 };
 
 FileSaverHdd::Priv::Priv(const io::path &output_dir, const bool overwrite)
@@ -46,19 +75,62 @@ FileSaverHdd::Priv::Priv(const io::path &output_dir, const bool overwrite)
 {
 }
 
+void FileSaverHdd::Priv::prepare_directory(const io::path &directory)
+{
+    const auto key = get_name_key(directory.str());
+    if (directories.find(key) != directories.end())
+        return;
+    std::unordered_set<std::string> existing_names;
+    if (!io::is_directory(directory))
+        io::create_directories(directory);
+    else if (!overwrite)
+    {
+        for (const auto &path : io::directory_range(directory))
+            existing_names.insert(get_name_key(path.name()));
+    }
+    directories[key] = std::move(existing_names);
+}
+
 io::path FileSaverHdd::Priv::make_path_unique(const io::path &path)
 {
+    const auto &existing_names
+        = directories[get_name_key(path.parent().str())];
     io::path new_path = path;
     int i = 1;
-    while (paths.find(new_path) != paths.end()
-        || (!overwrite && io::exists(new_path)))
+    while (paths.find(get_name_key(new_path.str())) != paths.end()
+        || (!overwrite && existing_names.count(get_name_key(new_path.name()))))
     {
         new_path.change_stem(path.stem() + algo::format("(%d)", i++));
     }
-    paths.insert(new_path);
+    paths.insert(get_name_key(new_path.str()));
     return new_path;
 }
 
+// Creating the file with O_EXCL is what actually reserves the name; the
+// cached directory listings only make the first guess right most of the
+// time. A file that shows up after its directory was listed, be it from
+// another process or another file saver, gets the next free name instead.
+io::path FileSaverHdd::Priv::create_file(
+    const io::path &target_path, const bstr &content)
+{
+    io::path full_path;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        prepare_directory(target_path.parent());
+        full_path = make_path_unique(target_path);
+    }
+
+    // the name is reserved, so the data can be written without the lock
+    while (!io::write_file(full_path, content, overwrite))
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        directories[get_name_key(full_path.parent().str())].insert(
+            get_name_key(full_path.name()));
+        full_path = make_path_unique(target_path);
+    }
+    return full_path;
+}
+
 FileSaverHdd::FileSaverHdd(
     const io::path &output_dir, const bool overwrite)
     : p(new Priv(output_dir, overwrite))
@@ -71,12 +143,83 @@ FileSaverHdd::~FileSaverHdd()
 
 io::path FileSaverHdd::save(std::shared_ptr<io::File> file) const
 {
+    // small files are written with a single system call, bigger ones get
+    // created empty first and filled in afterwards
+    const auto range = io::get_file_range(file->stream);
+    const auto is_small
+        = !range && file->stream.size() <= max_small_file_size;
+    const auto full_path = p->create_file(
+        p->output_dir / file->path,
+        is_small ? file->stream.seek(0).read_to_eof() : bstr());
+
+    if (!is_small)
+    {
+        io::FileByteStream output_stream(full_path, io::FileMode::Write);
+        if (range)
+        {
+            output_stream.write_file_range(*range);
+        }
+        else
+        {
+            file->stream.seek(0);
+            output_stream.write(file->stream);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ++p->saved_file_count;
+    return full_path;
+}
+
+io::path FileSaverHdd::save(const FileWriter &writer) const
+{
+    // the final name is known only after writing, so write to a temporary
+    // file next to the target and move it in place afterwards
+    std::unique_ptr<io::FileByteStream> output_stream;
+    io::path temp_path;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        io::create_directories(p->output_dir);
+        int i = 0;
+        do
+        {
+            temp_path = p->output_dir / algo::format(".au-%d.part", i++);
+        }
+        while (!io::write_file(temp_path, bstr(), false));
+        output_stream = std::make_unique<io::FileByteStream>(
+            temp_path, io::FileMode::Write);
+    }
+
+    io::path target_path;
+    try
+    {
+        target_path = writer(*output_stream);
+        output_stream.reset();
+    }
+    catch (...)
+    {
+        output_stream.reset();
+        io::remove(temp_path);
+        throw;
+    }
+
+    // the target is created first so that the rename only ever replaces
+    // a file of our own
+    io::path full_path;
+    try
+    {
+        full_path = p->create_file(p->output_dir / target_path, bstr());
+        io::rename(temp_path, full_path);
+    }
+    catch (const std::exception &e)
+    {
+        io::remove(temp_path);
+        if (!full_path.str().empty() && io::exists(full_path))
+            io::remove(full_path);
+        throw err::IoError(e.what());
+    }
+
     std::unique_lock<std::mutex> lock(mutex);
-    const auto full_path = p->make_path_unique(p->output_dir / file->path);
-    io::create_directories(full_path.parent());
-    io::FileByteStream output_stream(full_path, io::FileMode::Write);
-    file->stream.seek(0);
-    output_stream.write(file->stream);
     ++p->saved_file_count;
     return full_path;
 }
@@ -22,11 +22,16 @@
 namespace au {
 namespace flow {
 
+    // Streams the file contents straight into the output and returns the
+    // final file name, which may depend on what was written.
+    using FileWriter = std::function<io::path(io::BaseByteStream &)>;
+
     class IFileSaver
     {
     public:
         virtual ~IFileSaver() {}
         virtual io::path save(std::shared_ptr<io::File> file) const = 0;
+        virtual io::path save(const FileWriter &writer) const = 0;
         virtual size_t get_saved_file_count() const = 0;
     };
 
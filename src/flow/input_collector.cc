@@ -0,0 +1,282 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/input_collector.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "algo/range.h"
+#include "io/file_system.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    struct Candidate final
+    {
+        io::path path;
+        uoff_t size;
+        size_t input_index;
+    };
+
+    // Walks directory trees on several threads; each thread lists one
+    // directory at a time and queues the subdirectories it finds.
+    class DirectoryWalker final
+    {
+    public:
+        void add_directory(const io::path &path, const size_t input_index);
+        std::vector<Candidate> run(size_t thread_count);
+
+    private:
+        void work();
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::pair<io::path, size_t>> directories;
+        std::vector<Candidate> files;
+        size_t busy_count = 0;
+        std::exception_ptr error;
+    };
+}
+
+static uoff_t get_size(const io::path &path)
+{
+    return io::is_regular_file(path) ? io::file_size(path) : 0;
+}
+
+static bool is_pattern(const std::string &name)
+{
+    return name.find_first_of("*?") != std::string::npos;
+}
+
+static bool matches_pattern(const char *name, const char *pattern)
+{
+    const char *last_star = nullptr;
+    const char *last_star_name = nullptr;
+    while (*name)
+    {
+        if (*pattern == '*')
+        {
+            last_star = pattern++;
+            last_star_name = name;
+        }
+        else if (*pattern == '?' || *pattern == *name)
+        {
+            pattern++;
+            name++;
+        }
+        else if (last_star)
+        {
+            // let the last * swallow one more character
+            pattern = last_star + 1;
+            name = ++last_star_name;
+        }
+        else
+            return false;
+    }
+    while (*pattern == '*')
+        pattern++;
+    return !*pattern;
+}
+
+void DirectoryWalker::add_directory(
+    const io::path &path, const size_t input_index)
+{
+    directories.emplace_back(path, input_index);
+}
+
+std::vector<Candidate> DirectoryWalker::run(size_t thread_count)
+{
+    if (directories.empty())
+        return {};
+    if (!thread_count)
+        thread_count = std::thread::hardware_concurrency();
+    if (!thread_count)
+        thread_count = 1;
+
+    std::vector<std::thread> threads;
+    for (const auto i : algo::range(thread_count))
+        threads.emplace_back(&DirectoryWalker::work, this);
+    for (auto &thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+    return std::move(files);
+}
+
+void DirectoryWalker::work()
+{
+    while (true)
+    {
+        std::pair<io::path, size_t> directory;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(
+                lock,
+                [&]() { return !directories.empty() || !busy_count; });
+            // nothing is queued and no thread is left to queue more
+            if (directories.empty())
+                return;
+            directory = directories.front();
+            directories.pop_front();
+            busy_count++;
+        }
+
+        std::vector<Candidate> local_files;
+        std::vector<io::path> local_directories;
+        std::exception_ptr local_error;
+        try
+        {
+            for (const auto &path : io::directory_range(directory.first))
+            {
+                // symlinked directories are skipped, as they can form loops
+                if (!io::is_directory(path))
+                {
+                    local_files.push_back(
+                        {path, get_size(path), directory.second});
+                }
+                else if (!io::is_symlink(path))
+                    local_directories.push_back(path);
+            }
+        }
+        catch (...)
+        {
+            local_error = std::current_exception();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::move(
+                local_files.begin(),
+                local_files.end(),
+                std::back_inserter(files));
+            for (const auto &path : local_directories)
+                directories.emplace_back(path, directory.second);
+            if (local_error && !error)
+            {
+                error = local_error;
+                directories.clear();
+            }
+            busy_count--;
+        }
+        cv.notify_all();
+    }
+}
+
+std::vector<InputFile> flow::collect_input_files(
+    const std::vector<io::path> &input_paths, const size_t thread_count)
+{
+    std::vector<Candidate> candidates;
+    DirectoryWalker walker;
+
+    for (const auto i : algo::range(input_paths.size()))
+    {
+        const size_t input_index = i;
+        const auto &input_path = input_paths[i];
+        if (io::is_directory(input_path))
+        {
+            walker.add_directory(input_path, input_index);
+            continue;
+        }
+
+        if (!io::exists(input_path) && is_pattern(input_path.name()))
+        {
+            const auto parent = input_path.parent().str().empty()
+                ? io::path(".")
+                : input_path.parent();
+            bool matched = false;
+            if (io::is_directory(parent))
+            {
+                for (const auto &path : io::directory_range(parent))
+                {
+                    if (!matches_pattern(
+                        path.name().c_str(), input_path.name().c_str()))
+                    {
+                        continue;
+                    }
+                    matched = true;
+                    if (io::is_directory(path))
+                    {
+                        walker.add_directory(path, input_index);
+                    }
+                    else
+                    {
+                        candidates.push_back(
+                            {path, get_size(path), input_index});
+                    }
+                }
+            }
+            if (matched)
+                continue;
+        }
+
+        candidates.push_back(
+            {input_path, get_size(input_path), input_index});
+    }
+
+    for (auto &candidate : walker.run(thread_count))
+        candidates.push_back(std::move(candidate));
+
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const Candidate &a, const Candidate &b)
+        {
+            if (a.size != b.size)
+                return a.size > b.size;
+            if (a.input_index != b.input_index)
+                return a.input_index < b.input_index;
+            return a.path < b.path;
+        });
+
+    std::vector<InputFile> input_files;
+    input_files.reserve(candidates.size());
+    for (const auto &candidate : candidates)
+        input_files.push_back({candidate.path, candidate.size});
+    return input_files;
+}
+
+std::set<io::path> flow::get_input_directories(
+    const std::vector<InputFile> &input_files)
+{
+    std::set<io::path> all_directories;
+    for (const auto &input_file : input_files)
+        all_directories.insert(io::absolute(input_file.path).parent());
+
+    std::set<io::path> directories;
+    for (const auto &directory : all_directories)
+    {
+        bool is_nested = false;
+        auto current = directory;
+        while (!is_nested)
+        {
+            const auto parent = current.parent();
+            if (parent.str().empty() || parent == current)
+                break;
+            is_nested = all_directories.find(parent) != all_directories.end();
+            current = parent;
+        }
+        if (!is_nested)
+            directories.insert(directory);
+    }
+    return directories;
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <set>
+#include <vector>
+#include "io/path.h"
+#include "types.h"
+
+namespace au {
+namespace flow {
+
+    struct InputFile final
+    {
+        io::path path;
+        uoff_t size;
+    };
+
+    // Expands the paths given on the command line into regular files.
+    // Directories are walked recursively using up to thread_count threads,
+    // and names containing * or ? are matched against their parent
+    // directory. Paths that match nothing are kept as they are so that
+    // opening them reports the error. The result is sorted largest-first,
+    // so that the longest tasks start right away instead of trailing at the
+    // end of the run.
+    std::vector<InputFile> collect_input_files(
+        const std::vector<io::path> &input_paths, size_t thread_count);
+
+    // Returns the directories containing given files, leaving out those
+    // nested in another directory from the list.
+    std::set<io::path> get_input_directories(
+        const std::vector<InputFile> &input_files);
+
+} }
@@ -16,18 +16,284 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "flow/parallel_decoder_adapter.h"
+#include <algorithm>
 #include "algo/naming_strategies.h"
+#include "algo/range.h"
 #include "enc/microsoft/wav_audio_encoder.h"
 #include "enc/png/png_image_encoder.h"
 #include "flow/vfs_bridge.h"
+#include "io/prefetched_byte_stream.h"
 
 using namespace au;
 using namespace au::flow;
 
+// how much data is read at once in read-ahead mode
+static const uoff_t read_ahead_size = 32 * 1024 * 1024;
+
+namespace
+{
+    struct StoredRange final
+    {
+        uoff_t offset;
+        uoff_t size;
+    };
+
+    struct ReadAheadContext final
+    {
+        std::shared_ptr<const BaseParallelUnpackingTask> parent_task;
+        std::shared_ptr<const dec::BaseArchiveDecoder> decoder;
+        std::string decoder_name;
+        std::shared_ptr<dec::ArchiveMeta> meta;
+        std::shared_ptr<io::File> input_file;
+        std::shared_ptr<VirtualFileSystemBridge> vfs_bridge;
+        std::vector<std::pair<const dec::ArchiveEntry*, StoredRange>> entries;
+        std::unique_ptr<io::FileByteStream> reader_stream;
+        uoff_t input_size;
+    };
+
+    // Reads the next batch of entries, sorted by their offsets, then queues
+    // them for decoding along with a task that reads the batch after.
+    struct ReadAheadTask final : public ITask
+    {
+        ReadAheadTask(
+            const std::shared_ptr<ReadAheadContext> context,
+            const size_t first_entry);
+
+        bool work() const override;
+
+        const std::shared_ptr<ReadAheadContext> context;
+        const size_t first_entry;
+    };
+
+    struct QueueEntriesContext final
+    {
+        std::shared_ptr<const BaseParallelUnpackingTask> parent_task;
+        std::shared_ptr<const dec::BaseArchiveDecoder> decoder;
+        std::string decoder_name;
+        std::shared_ptr<dec::ArchiveMeta> meta;
+        std::shared_ptr<io::File> input_file;
+        std::shared_ptr<VirtualFileSystemBridge> vfs_bridge;
+        std::vector<const dec::ArchiveEntry*> entries;
+    };
+
+    // Queues the next max_breadth entries for decoding along with a task
+    // that queues the ones after, so that huge archives don't flood the
+    // scheduler with tasks waiting for their turn.
+    struct QueueEntriesTask final : public ITask
+    {
+        QueueEntriesTask(
+            const std::shared_ptr<QueueEntriesContext> context,
+            const size_t first_entry);
+
+        bool work() const override;
+
+        const std::shared_ptr<QueueEntriesContext> context;
+        const size_t first_entry;
+    };
+}
+
+// Tasks of the entries are one level deeper than the archive task.
+static int get_entry_priority(const BaseParallelUnpackingTask &parent_task)
+{
+    return parent_task.get_depth() + 1;
+}
+
+static bool get_stored_range(
+    const dec::ArchiveEntry &entry, StoredRange &range)
+{
+    if (const auto plain_entry
+        = dynamic_cast<const dec::PlainArchiveEntry*>(&entry))
+    {
+        range.offset = plain_entry->offset;
+        range.size = plain_entry->size;
+        return true;
+    }
+    if (const auto compressed_entry
+        = dynamic_cast<const dec::CompressedArchiveEntry*>(&entry))
+    {
+        range.offset = compressed_entry->offset;
+        range.size = compressed_entry->size_comp;
+        return true;
+    }
+    return false;
+}
+
+static void save_entry(
+    const BaseParallelUnpackingTask &parent_task,
+    const dec::BaseArchiveDecoder &decoder,
+    const std::string &decoder_name,
+    const std::shared_ptr<dec::ArchiveMeta> meta,
+    const std::shared_ptr<io::File> input_file,
+    const std::shared_ptr<VirtualFileSystemBridge> vfs_bridge,
+    const dec::ArchiveEntry *entry)
+{
+    auto &stats = parent_task.task_context.stats;
+    parent_task.save_file(
+        input_file,
+        [meta, entry, &decoder, &stats, decoder_name, vfs_bridge]
+        (io::File &input_file_copy, const Logger &logger)
+        {
+            RunPhaseTimer timer(stats, decoder_name, RunPhase::ReadFile);
+            auto output_file = decoder.read_file(
+                logger, input_file_copy, *meta, *entry);
+            StoredRange range;
+            timer.finish(
+                get_stored_range(*entry, range) ? range.size : 0,
+                output_file ? output_file->stream.size() : 0);
+            return output_file;
+        },
+        decoder,
+        decoder_name,
+        entry->path.str());
+}
+
+static void print_entry(const Logger &logger, const dec::ArchiveEntry &entry)
+{
+    std::string size = "-", offset = "-";
+    if (const auto plain_entry
+        = dynamic_cast<const dec::PlainArchiveEntry*>(&entry))
+    {
+        size = std::to_string(plain_entry->size);
+        offset = std::to_string(plain_entry->offset);
+    }
+    else if (const auto compressed_entry
+        = dynamic_cast<const dec::CompressedArchiveEntry*>(&entry))
+    {
+        size = std::to_string(compressed_entry->size_orig);
+        offset = std::to_string(compressed_entry->offset);
+    }
+    logger.log(
+        Logger::MessageType::Summary,
+        "%s\t%s\t%s\n",
+        entry.path.c_str(),
+        size.c_str(),
+        offset.c_str());
+}
+
+ReadAheadTask::ReadAheadTask(
+    const std::shared_ptr<ReadAheadContext> context,
+    const size_t first_entry) :
+        context(context),
+        first_entry(first_entry)
+{
+}
+
+bool ReadAheadTask::work() const
+{
+    const auto &parent_task = *context->parent_task;
+    const auto &entries = context->entries;
+
+    const auto max_breadth
+        = parent_task.task_context.unpacker_context.max_breadth;
+    size_t end = first_entry;
+    uoff_t batch_size = 0;
+    while (end < entries.size())
+    {
+        const auto size = entries[end].second.size;
+        if (end > first_entry && batch_size + size > read_ahead_size)
+            break;
+        if (max_breadth && end - first_entry >= max_breadth)
+            break;
+        batch_size += size;
+        end++;
+    }
+
+    const std::shared_ptr<const io::BaseByteStream> source_stream(
+        context->input_file, &context->input_file->stream);
+    std::vector<std::shared_ptr<io::File>> prefetched_files;
+    try
+    {
+        auto &reader_stream = *context->reader_stream;
+        for (const auto i : algo::range(first_entry, end))
+        {
+            const auto &range = entries[i].second;
+            const auto data = reader_stream.seek(range.offset).read(range.size);
+            prefetched_files.push_back(std::make_shared<io::File>(
+                context->input_file->path,
+                std::make_unique<io::PrefetchedByteStream>(
+                    source_stream, context->input_size, range.offset, data)));
+        }
+
+        // let the OS fetch the next batch while this one is being decoded
+        if (end < entries.size())
+            reader_stream.will_need(entries[end].second.offset, batch_size);
+    }
+    catch (const std::exception &e)
+    {
+        parent_task.logger.err("error reading ahead (%s)\n", e.what());
+        prefetched_files.clear();
+    }
+
+    if (prefetched_files.empty())
+        end = entries.size();
+    else if (end < entries.size())
+    {
+        parent_task.task_context.task_scheduler.push_front(
+            std::make_shared<ReadAheadTask>(context, end),
+            get_entry_priority(parent_task));
+    }
+
+    for (const auto i : algo::range(first_entry, end))
+    {
+        const auto offset = i - first_entry;
+        save_entry(
+            parent_task,
+            *context->decoder,
+            context->decoder_name,
+            context->meta,
+            offset < prefetched_files.size()
+                ? prefetched_files[offset]
+                : context->input_file,
+            context->vfs_bridge,
+            entries[i].first);
+    }
+    return !prefetched_files.empty();
+}
+
+QueueEntriesTask::QueueEntriesTask(
+    const std::shared_ptr<QueueEntriesContext> context,
+    const size_t first_entry) :
+        context(context),
+        first_entry(first_entry)
+{
+}
+
+bool QueueEntriesTask::work() const
+{
+    const auto &parent_task = *context->parent_task;
+    const auto &entries = context->entries;
+    const auto max_breadth
+        = parent_task.task_context.unpacker_context.max_breadth;
+    const auto end = max_breadth
+        ? std::min(entries.size(), first_entry + max_breadth)
+        : entries.size();
+    if (end < entries.size())
+    {
+        parent_task.task_context.task_scheduler.push_front(
+            std::make_shared<QueueEntriesTask>(context, end),
+            get_entry_priority(parent_task));
+    }
+    for (const auto i : algo::range(first_entry, end))
+    {
+        save_entry(
+            parent_task,
+            *context->decoder,
+            context->decoder_name,
+            context->meta,
+            context->input_file,
+            context->vfs_bridge,
+            entries[i]);
+    }
+    return true;
+}
+
 ParallelDecoderAdapter::ParallelDecoderAdapter(
     const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
-    const std::shared_ptr<io::File> input_file)
-    : parent_task(parent_task), input_file(input_file)
+    const std::shared_ptr<io::File> input_file,
+    const std::string &decoder_name) :
+        parent_task(parent_task),
+        input_file(input_file),
+        decoder_name(decoder_name)
 {
 }
 
@@ -38,11 +304,40 @@ ParallelDecoderAdapter::~ParallelDecoderAdapter()
 void ParallelDecoderAdapter::visit(const dec::BaseArchiveDecoder &decoder)
 {
     auto input_file = this->input_file;
+    RunPhaseTimer timer(
+        parent_task->task_context.stats, decoder_name, RunPhase::ReadMeta);
     auto meta = std::shared_ptr<dec::ArchiveMeta>(
         decoder.read_meta(parent_task->logger, *input_file));
+    timer.finish(input_file->stream.size(), 0);
     parent_task->logger.info(
         "archive contains %d files.\n", meta->entries.size());
 
+    const auto &unpacker_context = parent_task->task_context.unpacker_context;
+    std::vector<const dec::ArchiveEntry*> entries;
+    entries.reserve(meta->entries.size());
+    const auto &entry_filter = unpacker_context.entry_filter;
+    for (const auto &entry : meta->entries)
+    {
+        // any entry might be an archive holding included files, so include
+        // patterns are left for the files that get saved
+        const auto is_selected = unpacker_context.list_entries
+            ? entry_filter.accepts(entry->path)
+            : !entry_filter.excludes(entry->path);
+        if (is_selected)
+            entries.push_back(entry.get());
+    }
+    if (!entry_filter.is_empty())
+        parent_task->logger.info("%d files selected.\n", entries.size());
+
+    if (unpacker_context.list_entries)
+    {
+        Logger list_logger(parent_task->logger);
+        list_logger.set_prefix("");
+        for (const auto entry : entries)
+            print_entry(list_logger, *entry);
+        return;
+    }
+
     const auto vfs_bridge = std::make_shared<VirtualFileSystemBridge>(
         parent_task->logger,
         decoder,
@@ -50,54 +345,151 @@ void ParallelDecoderAdapter::visit(const dec::BaseArchiveDecoder &decoder)
         input_file,
         parent_task->base_name);
 
-    for (const auto &entry : meta->entries)
+    const auto file_stream
+        = dynamic_cast<const io::FileByteStream*>(&input_file->stream);
+    if (!unpacker_context.read_ahead || !file_stream)
     {
-        parent_task->save_file(
-            input_file,
-            [meta, &entry, &decoder, vfs_bridge]
-            (io::File &input_file_copy, const Logger &logger)
-            {
-                return decoder.read_file(
-                    logger, input_file_copy, *meta, *entry);
-            },
+        const auto context = std::make_shared<QueueEntriesContext>();
+        context->parent_task = parent_task;
+        context->decoder
+            = std::static_pointer_cast<const dec::BaseArchiveDecoder>(
+                decoder.shared_from_this());
+        context->decoder_name = decoder_name;
+        context->meta = meta;
+        context->input_file = input_file;
+        context->vfs_bridge = vfs_bridge;
+        context->entries = std::move(entries);
+        QueueEntriesTask(context, 0).work();
+        return;
+    }
+
+    // entries with unknown or huge data are read by the workers as usual
+    const auto context = std::make_shared<ReadAheadContext>();
+    for (const auto entry : entries)
+    {
+        StoredRange range;
+        if (get_stored_range(*entry, range) && range.size <= read_ahead_size)
+        {
+            context->entries.push_back({entry, range});
+            continue;
+        }
+        save_entry(
+            *parent_task,
             decoder,
-            entry->path.str());
+            decoder_name,
+            meta,
+            input_file,
+            vfs_bridge,
+            entry);
     }
+    if (context->entries.empty())
+        return;
+
+    std::stable_sort(
+        context->entries.begin(),
+        context->entries.end(),
+        [](const std::pair<const dec::ArchiveEntry*, StoredRange> &a,
+            const std::pair<const dec::ArchiveEntry*, StoredRange> &b)
+        {
+            return a.second.offset < b.second.offset;
+        });
+
+    context->parent_task = parent_task;
+    context->decoder = std::static_pointer_cast<const dec::BaseArchiveDecoder>(
+        decoder.shared_from_this());
+    context->decoder_name = decoder_name;
+    context->meta = meta;
+    context->input_file = input_file;
+    context->vfs_bridge = vfs_bridge;
+    context->reader_stream = std::make_unique<io::FileByteStream>(
+        file_stream->get_path(), io::FileMode::Read);
+    context->input_size = context->reader_stream->size();
+    parent_task->task_context.task_scheduler.push_front(
+        std::make_shared<ReadAheadTask>(context, 0),
+        get_entry_priority(*parent_task));
 }
 
 void ParallelDecoderAdapter::visit(const dec::BaseFileDecoder &decoder)
 {
+    auto &stats = parent_task->task_context.stats;
+    const auto decoder_name = this->decoder_name;
     parent_task->save_file(
         input_file,
-        [&decoder](io::File &input_file_copy, const Logger &logger)
+        [&decoder, &stats, decoder_name]
+        (io::File &input_file_copy, const Logger &logger)
         {
-            return decoder.decode(logger, input_file_copy);
+            RunPhaseTimer timer(stats, decoder_name, RunPhase::Decode);
+            auto output_file = decoder.decode(logger, input_file_copy);
+            timer.finish(
+                input_file_copy.stream.size(),
+                output_file ? output_file->stream.size() : 0);
+            return output_file;
         },
-        decoder);
+        decoder,
+        decoder_name);
 }
 
 void ParallelDecoderAdapter::visit(const dec::BaseImageDecoder &decoder)
 {
+    auto &stats = parent_task->task_context.stats;
+    const auto decoder_name = this->decoder_name;
     parent_task->save_file(
         input_file,
-        [&decoder](io::File &input_file_copy, const Logger &logger)
+        [&decoder, &stats, decoder_name]
+        (io::File &input_file_copy, const Logger &logger)
         {
+            RunPhaseTimer decode_timer(stats, decoder_name, RunPhase::Decode);
             auto output_file = decoder.decode(logger, input_file_copy);
+            const auto decoded_size = output_file.width()
+                * output_file.height() * sizeof(res::Pixel);
+            decode_timer.finish(input_file_copy.stream.size(), decoded_size);
+
+            RunPhaseTimer encode_timer(stats, decoder_name, RunPhase::Encode);
             const auto encoder = enc::png::PngImageEncoder();
-            return encoder.encode(logger, output_file, input_file_copy.path);
+            auto encoded_file
+                = encoder.encode(logger, output_file, input_file_copy.path);
+            encode_timer.finish(decoded_size, encoded_file->stream.size());
+            return encoded_file;
         },
-        decoder);
+        decoder,
+        decoder_name);
 }
 
 void ParallelDecoderAdapter::visit(const dec::BaseAudioDecoder &decoder)
 {
+    auto &stats = parent_task->task_context.stats;
+    const auto decoder_name = this->decoder_name;
     parent_task->save_file(
         input_file,
-        [&decoder](io::File &input_file_copy, const Logger &logger)
+        [&decoder, &stats, decoder_name]
+        (io::File &input_file_copy, const Logger &logger)
         {
+            RunPhaseTimer decode_timer(stats, decoder_name, RunPhase::Decode);
             auto output_file = decoder.decode(logger, input_file_copy);
+            const auto decoded_size = output_file.samples.size();
+            decode_timer.finish(input_file_copy.stream.size(), decoded_size);
+
+            RunPhaseTimer encode_timer(stats, decoder_name, RunPhase::Encode);
             const auto encoder = enc::microsoft::WavAudioEncoder();
-            return encoder.encode(logger, output_file, input_file_copy.path);
+            auto encoded_file
+                = encoder.encode(logger, output_file, input_file_copy.path);
+            encode_timer.finish(decoded_size, encoded_file->stream.size());
+            return encoded_file;
         },
-        decoder);
+        [&decoder, &stats, decoder_name](
+            io::File &input_file_copy,
+            const Logger &logger,
+            io::BaseByteStream &output_stream)
+        {
+            // encoding and saving happen as the samples are decoded
+            RunPhaseTimer timer(stats, decoder_name, RunPhase::Decode);
+            enc::microsoft::WavAudioStreamWriter writer(output_stream);
+            decoder.decode(logger, input_file_copy, writer);
+            writer.finish();
+            timer.finish(input_file_copy.stream.size(), output_stream.size());
+            return io::path(input_file_copy.path)
+                .change_extension(writer.get_extension());
+        },
+        decoder,
+        decoder_name);
 }
@@ -19,7 +19,10 @@
 #include <chrono>
 #include <set>
 #include <stack>
+#include <thread>
 #include "algo/format.h"
+#include "algo/hash/xxhash.h"
+#include "dec/base_archive_decoder.h"
 #include "dec/idecoder.h"
 #include "err.h"
 #include "flow/parallel_decoder_adapter.h"
@@ -27,7 +30,20 @@
 using namespace au;
 using namespace au::flow;
 
-static const auto max_depth = 10;
+// Files that decode to themselves are caught by their content hashes; this
+// only stops decoders that keep producing new files forever. Each nesting
+// level takes two tasks: one decoding the file and one processing its output.
+static const auto max_depth = 64;
+
+// Bigger files are hashed by their size and both ends only.
+static const uoff_t max_hashed_size = 16 * 1024 * 1024;
+
+// how many decoded files may wait for the save threads before the decoding
+// threads have to wait for them instead
+static const size_t max_queued_saves = 64;
+
+// stats key for the files no decoder recognized
+static const std::string unrecognized_name = "(none)";
 static int task_count = 0;
 static std::mutex mutex;
 
@@ -41,7 +57,8 @@ namespace
             const io::path &base_name,
             const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
             const std::set<std::string> &decoders_to_check,
-            const InputFileFactory file_factory);
+            const InputFileFactory file_factory,
+            const u64 content_hash = 0);
 
         bool work() const override;
 
@@ -58,25 +75,50 @@ namespace
             const std::set<std::string> &decoders_to_check,
             const std::shared_ptr<io::File> input_file,
             const DecoderFileFactory file_factory,
+            const DecoderStreamFactory stream_factory,
             const std::shared_ptr<const dec::IDecoder> origin_decoder,
+            const std::string &decoder_name,
             const std::string &target_name);
 
         bool work() const override;
+        bool work_streamed(io::File &input_file_copy) const;
 
         const std::shared_ptr<io::File> input_file;
         const DecoderFileFactory file_factory;
+        const DecoderStreamFactory stream_factory;
         const std::shared_ptr<const dec::IDecoder> origin_decoder;
+        const std::string decoder_name;
         const std::string target_name;
     };
+
+    // Writes a decoded file on one of the save threads.
+    struct SaveFileTask final : public ITask
+    {
+        SaveFileTask(
+            const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
+            const std::shared_ptr<io::File> file,
+            const std::string &decoder_name);
+
+        bool work() const override;
+
+        const std::shared_ptr<const BaseParallelUnpackingTask> parent_task;
+        const std::shared_ptr<io::File> file;
+        const std::string decoder_name;
+    };
 }
 
-static bool save(
-    const BaseParallelUnpackingTask &task, std::shared_ptr<io::File> file)
+static bool save_immediately(
+    const BaseParallelUnpackingTask &task,
+    std::shared_ptr<io::File> file,
+    const std::string &decoder_name)
 {
     try
     {
+        RunPhaseTimer timer(
+            task.task_context.stats, decoder_name, RunPhase::Save);
         const auto full_path
             = task.task_context.unpacker_context.file_saver.save(file);
+        timer.finish(file->stream.size(), 0);
         task.logger.success("saved to %s\n", full_path.c_str());
         task.logger.flush();
         return true;
@@ -90,6 +132,53 @@ static bool save(
     }
 }
 
+// Include patterns are matched against the path of the archive entry the
+// file comes from. Files that don't come from an archive are always saved.
+static bool is_included(const BaseParallelUnpackingTask &task)
+{
+    const auto &entry_filter = task.task_context.unpacker_context.entry_filter;
+    for (auto current = &task; current; current = current->parent_task.get())
+    {
+        const auto output_task
+            = dynamic_cast<const ProcessOutputFileTask*>(current);
+        if (output_task && !output_task->target_name.empty())
+            return entry_filter.includes(output_task->target_name);
+    }
+    return true;
+}
+
+// Hands the file over to the save threads if there are any, in which case
+// the errors are counted for the save task rather than for the caller.
+static bool save(
+    const BaseParallelUnpackingTask &task,
+    std::shared_ptr<io::File> file,
+    const std::string &decoder_name)
+{
+    if (!is_included(task))
+    {
+        task.logger.info("not included, skipping.\n");
+        return true;
+    }
+    if (!task.task_context.save_in_background)
+        return save_immediately(task, file, decoder_name);
+    task.task_context.save_task_scheduler.push_back(
+        std::make_shared<SaveFileTask>(
+            task.shared_from_this(), file, decoder_name));
+    return true;
+}
+
+static u64 get_content_hash(io::BaseByteStream &stream)
+{
+    const auto size = stream.size();
+    if (size <= max_hashed_size)
+        return algo::hash::xxhash64(stream.seek(0).read(size), size);
+    const auto head = stream.seek(0).read(max_hashed_size / 2);
+    const auto tail = stream
+        .seek(size - max_hashed_size / 2)
+        .read(max_hashed_size / 2);
+    return algo::hash::xxhash64(head + tail, size);
+}
+
 static std::set<std::string> collect_linked_decoders(
     const dec::IDecoder &base_decoder, const dec::Registry &registry)
 {
@@ -118,7 +207,8 @@ static std::shared_ptr<dec::IDecoder> guess_decoder(
     const BaseParallelUnpackingTask &task,
     const std::set<std::string> &decoders_to_check,
     io::File &file,
-    const TaskSourceType source_type)
+    const TaskSourceType source_type,
+    std::string &decoder_name)
 {
     task.logger.info(
         "guessing decoder among %d decoders...\n", decoders_to_check.size());
@@ -134,8 +224,8 @@ static std::shared_ptr<dec::IDecoder> guess_decoder(
 
     if (matching_decoders.size() == 1)
     {
-        task.logger.success(
-            "recognized as %s.\n", matching_decoders.begin()->first.c_str());
+        decoder_name = matching_decoders.begin()->first;
+        task.logger.success("recognized as %s.\n", decoder_name.c_str());
         return matching_decoders.begin()->second;
     }
 
@@ -172,23 +262,36 @@ ParallelUnpackerContext::ParallelUnpackerContext(
     const dec::Registry &registry,
     const bool enable_nested_decoding,
     const std::vector<std::string> &arguments,
-    const std::set<std::string> &decoders_to_check) :
+    const std::set<std::string> &decoders_to_check,
+    const EntryFilter &entry_filter,
+    const bool list_entries,
+    const bool read_ahead,
+    const size_t max_breadth) :
         logger(logger),
         file_saver(file_saver),
         registry(registry),
         enable_nested_decoding(enable_nested_decoding),
         arguments(arguments),
-        decoders_to_check(decoders_to_check)
+        decoders_to_check(decoders_to_check),
+        entry_filter(entry_filter),
+        list_entries(list_entries),
+        read_ahead(read_ahead),
+        max_breadth(max_breadth)
 {
 }
 
 ParallelTaskContext::ParallelTaskContext(
     ParallelUnpacker &unpacker,
     const ParallelUnpackerContext &unpacker_context,
-    TaskScheduler &task_scheduler) :
+    TaskScheduler &task_scheduler,
+    TaskScheduler &save_task_scheduler,
+    RunStats &stats) :
         unpacker(unpacker),
         unpacker_context(unpacker_context),
-        task_scheduler(task_scheduler)
+        task_scheduler(task_scheduler),
+        save_task_scheduler(save_task_scheduler),
+        stats(stats),
+        save_in_background(false)
 {
 }
 
@@ -197,13 +300,16 @@ BaseParallelUnpackingTask::BaseParallelUnpackingTask(
     const TaskSourceType source_type,
     const io::path &base_name,
     const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
-    const std::set<std::string> &decoders_to_check) :
+    const std::set<std::string> &decoders_to_check,
+    const u64 content_hash) :
         logger(task_context.unpacker_context.logger),
         task_context(task_context),
         source_type(source_type),
         base_name(base_name),
         parent_task(parent_task),
-        decoders_to_check(decoders_to_check)
+        decoders_to_check(decoders_to_check),
+        depth(parent_task ? parent_task->depth + 1 : 0),
+        content_hash(content_hash)
 {
     mutex.lock();
     const auto task_id = task_count++;
@@ -214,23 +320,34 @@ BaseParallelUnpackingTask::BaseParallelUnpackingTask(
 
 size_t BaseParallelUnpackingTask::get_depth() const
 {
-    auto depth = 0;
-    auto task = parent_task;
-    while (task != nullptr)
-    {
-        ++depth;
-        task = task->parent_task;
-    }
     return depth;
 }
 
+bool BaseParallelUnpackingTask::is_content_being_decoded(
+    const u64 content_hash) const
+{
+    if (!content_hash)
+        return false;
+    for (auto task = this; task; task = task->parent_task.get())
+        if (task->content_hash == content_hash)
+            return true;
+    return false;
+}
+
+void BaseParallelUnpackingTask::schedule(
+    const std::shared_ptr<BaseParallelUnpackingTask> task) const
+{
+    task_context.task_scheduler.push_front(task, task->depth);
+}
+
 void BaseParallelUnpackingTask::save_file(
     const std::shared_ptr<io::File> input_file,
     const DecoderFileFactory file_factory,
     const dec::BaseDecoder &origin_decoder,
+    const std::string &decoder_name,
     const std::string &target_name) const
 {
-    task_context.task_scheduler.push_front(
+    schedule(
         std::make_shared<ProcessOutputFileTask>(
             task_context,
             source_type,
@@ -240,23 +357,50 @@ void BaseParallelUnpackingTask::save_file(
                 ? std::set<std::string>() : decoders_to_check,
             input_file,
             file_factory,
+            nullptr,
             origin_decoder.shared_from_this(),
+            decoder_name,
             target_name));
 }
 
+void BaseParallelUnpackingTask::save_file(
+    const std::shared_ptr<io::File> input_file,
+    const DecoderFileFactory file_factory,
+    const DecoderStreamFactory stream_factory,
+    const dec::BaseDecoder &origin_decoder,
+    const std::string &decoder_name) const
+{
+    schedule(
+        std::make_shared<ProcessOutputFileTask>(
+            task_context,
+            source_type,
+            base_name,
+            shared_from_this(),
+            source_type == TaskSourceType::InitialUserInput
+                ? std::set<std::string>() : decoders_to_check,
+            input_file,
+            file_factory,
+            stream_factory,
+            origin_decoder.shared_from_this(),
+            decoder_name,
+            ""));
+}
+
 DecodeInputFileTask::DecodeInputFileTask(
     ParallelTaskContext &task_context,
     const TaskSourceType source_type,
     const io::path &base_name,
     const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
     const std::set<std::string> &decoders_to_check,
-    const InputFileFactory file_factory) :
+    const InputFileFactory file_factory,
+    const u64 content_hash) :
         BaseParallelUnpackingTask(
             task_context,
             source_type,
             base_name,
             parent_task,
-            decoders_to_check),
+            decoders_to_check,
+            content_hash),
         file_factory(file_factory)
 {
 }
@@ -279,17 +423,25 @@ bool DecodeInputFileTask::work() const
         return false;
     }
 
+    std::string decoder_name = unrecognized_name;
     try
     {
         logger.info("initial recognition...\n");
 
+        const auto recognition_start = RunStats::Clock::now();
         const auto decoder = guess_decoder(
-            *this, decoders_to_check, *input_file, source_type);
+            *this, decoders_to_check, *input_file, source_type, decoder_name);
+        task_context.stats.add_sample(
+            decoder_name,
+            RunPhase::Recognition,
+            RunStats::Clock::now() - recognition_start,
+            input_file->stream.size(),
+            0);
 
         if (!decoder)
         {
             return source_type == TaskSourceType::NestedDecoding
-                ? save(*this, input_file)
+                ? save(*this, input_file, decoder_name)
                 : false;
         }
 
@@ -301,7 +453,15 @@ bool DecodeInputFileTask::work() const
         for (const auto &decorator : decorators)
             decorator.parse_cli_options(decoder_arg_parser);
 
-        ParallelDecoderAdapter adapter(shared_from_this(), input_file);
+        if (task_context.unpacker_context.list_entries
+            && !dynamic_cast<const dec::BaseArchiveDecoder*>(decoder.get()))
+        {
+            logger.info("not an archive, nothing to list.\n");
+            return true;
+        }
+
+        ParallelDecoderAdapter adapter(
+            shared_from_this(), input_file, decoder_name);
         decoder->accept(adapter);
         return true;
     }
@@ -309,7 +469,7 @@ bool DecodeInputFileTask::work() const
     {
         logger.err("recognition finished with errors:\n%s\n", e.what());
         if (source_type == TaskSourceType::NestedDecoding)
-            save(*this, input_file);
+            save(*this, input_file, decoder_name);
         return false;
     }
 }
@@ -322,7 +482,9 @@ ProcessOutputFileTask::ProcessOutputFileTask(
     const std::set<std::string> &decoders_to_check,
     const std::shared_ptr<io::File> input_file,
     const DecoderFileFactory file_factory,
+    const DecoderStreamFactory stream_factory,
     const std::shared_ptr<const dec::IDecoder> origin_decoder,
+    const std::string &decoder_name,
     const std::string &target_name) :
         BaseParallelUnpackingTask(
             task_context,
@@ -332,7 +494,9 @@ ProcessOutputFileTask::ProcessOutputFileTask(
             decoders_to_check),
         input_file(input_file),
         file_factory(file_factory),
+        stream_factory(stream_factory),
         origin_decoder(origin_decoder),
+        decoder_name(decoder_name),
         target_name(target_name)
 {
 }
@@ -351,6 +515,28 @@ bool ProcessOutputFileTask::work() const
     }
 
     io::File input_file_copy(*input_file);
+
+    std::set<std::string> linked_decoders;
+    if (task_context.unpacker_context.enable_nested_decoding)
+    {
+        linked_decoders = collect_linked_decoders(
+            *origin_decoder, task_context.unpacker_context.registry);
+        linked_decoders.insert(
+            decoders_to_check.begin(), decoders_to_check.end());
+    }
+
+    // the output is going to be saved as it is, so if it's not wanted,
+    // there is no need to read it at all
+    if (linked_decoders.empty() && !is_included(*this))
+    {
+        logger.info("not included, skipping.\n");
+        return true;
+    }
+
+    // nothing is going to inspect the output, so don't keep it in memory
+    if (stream_factory && linked_decoders.empty())
+        return work_streamed(input_file_copy);
+
     std::shared_ptr<io::File> output_file;
     try
     {
@@ -377,7 +563,7 @@ bool ProcessOutputFileTask::work() const
                 "error decoding \"%s\" (%s)\n", target_name.c_str(), e.what());
         }
         if (source_type == TaskSourceType::NestedDecoding)
-            save(*this, input_file);
+            save(*this, input_file, decoder_name);
         return false;
     }
 
@@ -391,35 +577,78 @@ bool ProcessOutputFileTask::work() const
     output_file->path = algo::apply_naming_strategy(
         naming_strategy, base_name, output_file->path);
 
-    if (!task_context.unpacker_context.enable_nested_decoding)
-        return save(*this, output_file);
-
-    auto linked_decoders = collect_linked_decoders(
-        *origin_decoder, task_context.unpacker_context.registry);
-    linked_decoders.insert(
-        decoders_to_check.begin(), decoders_to_check.end());
-
     if (linked_decoders.empty())
-        return save(*this, output_file);
+        return save(*this, output_file, decoder_name);
 
-    if (get_depth() >= max_depth)
+    const auto content_hash = get_content_hash(output_file->stream);
+    if (is_content_being_decoded(content_hash))
     {
         logger.warn("cycle detected.\n");
-        return save(*this, output_file);
+        return save(*this, output_file, decoder_name);
+    }
+    if (get_depth() >= max_depth)
+    {
+        logger.warn("nesting too deep.\n");
+        return save(*this, output_file, decoder_name);
     }
 
-    task_context.task_scheduler.push_front(
+    schedule(
         std::make_shared<DecodeInputFileTask>(
             task_context,
             TaskSourceType::NestedDecoding,
             output_file->path,
             shared_from_this(),
             linked_decoders,
-            [=]() { return output_file; }));
+            [=]() { return output_file; },
+            content_hash));
+
+    return true;
+}
+
+bool ProcessOutputFileTask::work_streamed(io::File &input_file_copy) const
+{
+    const auto naming_strategy = origin_decoder->naming_strategy();
+    io::path full_path;
+    try
+    {
+        full_path = task_context.unpacker_context.file_saver.save(
+            [&](io::BaseByteStream &output_stream)
+            {
+                return algo::apply_naming_strategy(
+                    naming_strategy,
+                    base_name,
+                    stream_factory(input_file_copy, logger, output_stream));
+            });
+    }
+    catch (const std::exception &e)
+    {
+        logger.err("error decoding (%s)\n", e.what());
+        if (source_type == TaskSourceType::NestedDecoding)
+            save(*this, input_file, decoder_name);
+        return false;
+    }
 
+    logger.info("decoding finished\n");
+    logger.success("saved to %s\n", full_path.c_str());
+    logger.flush();
     return true;
 }
 
+SaveFileTask::SaveFileTask(
+    const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
+    const std::shared_ptr<io::File> file,
+    const std::string &decoder_name) :
+        parent_task(parent_task),
+        file(file),
+        decoder_name(decoder_name)
+{
+}
+
+bool SaveFileTask::work() const
+{
+    return save_immediately(*parent_task, file, decoder_name);
+}
+
 struct ParallelUnpacker::Priv final
 {
     Priv(
@@ -428,6 +657,8 @@ struct ParallelUnpacker::Priv final
 
     const ParallelUnpackerContext &unpacker_context;
     TaskScheduler task_scheduler;
+    TaskScheduler save_task_scheduler;
+    RunStats stats;
     ParallelTaskContext task_context;
 };
 
@@ -435,7 +666,13 @@ ParallelUnpacker::Priv::Priv(
     ParallelUnpacker &unpacker,
     const ParallelUnpackerContext &unpacker_context) :
         unpacker_context(unpacker_context),
-        task_context(unpacker, unpacker_context, task_scheduler)
+        save_task_scheduler(max_queued_saves),
+        task_context(
+            unpacker,
+            unpacker_context,
+            task_scheduler,
+            save_task_scheduler,
+            stats)
 {
 }
 
@@ -462,13 +699,52 @@ void ParallelUnpacker::add_input_file(
             file_factory));
 }
 
-bool ParallelUnpacker::run(const size_t thread_count)
+bool ParallelUnpacker::run(
+    const size_t thread_count, const size_t save_thread_count)
 {
     const auto begin = std::chrono::steady_clock::now();
-    const auto results = p->task_scheduler.run(thread_count);
+
+    // the save threads are kept waiting until no more files can come
+    TaskSchedulerResult save_results {0, 0, 0, {}};
+    std::thread save_thread;
+    p->task_context.save_in_background = save_thread_count > 0;
+    if (p->task_context.save_in_background)
+    {
+        p->save_task_scheduler.hold();
+        save_thread = std::thread([&]()
+        {
+            save_results = p->save_task_scheduler.run(save_thread_count);
+        });
+    }
+
+    auto results = p->task_scheduler.run(thread_count);
+    p->stats.set_stage(
+        "decode",
+        results.thread_count,
+        results.success_count + results.error_count,
+        results.busy_time);
+
+    if (p->task_context.save_in_background)
+    {
+        p->save_task_scheduler.release();
+        save_thread.join();
+        p->stats.set_stage(
+            "save",
+            save_results.thread_count,
+            save_results.success_count + save_results.error_count,
+            save_results.busy_time);
+        results.success_count += save_results.success_count;
+        results.error_count += save_results.error_count;
+    }
+
     const auto end = std::chrono::steady_clock::now();
     const auto diff
         = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin);
+    p->stats.set_summary(
+        end - begin,
+        results.success_count + results.error_count,
+        results.error_count,
+        p->unpacker_context.file_saver.get_saved_file_count());
 
     Logger logger(p->unpacker_context.logger);
 
@@ -497,3 +773,8 @@ bool ParallelUnpacker::run(const size_t thread_count)
 
     return results.error_count == 0;
 }
+
+const RunStats &ParallelUnpacker::get_stats() const
+{
+    return p->stats;
+}
@@ -22,7 +22,9 @@
 #include <set>
 #include "dec/base_decoder.h"
 #include "dec/registry.h"
+#include "flow/entry_filter.h"
 #include "flow/ifile_saver.h"
+#include "flow/run_stats.h"
 #include "flow/task_scheduler.h"
 #include "logger.h"
 
@@ -41,6 +43,11 @@ namespace flow {
     using DecoderFileFactory
         = std::function<std::shared_ptr<io::File>(io::File &, const Logger &)>;
 
+    // Writes the decoded contents directly into given stream and returns the
+    // output file name. Used when the output won't be decoded any further.
+    using DecoderStreamFactory = std::function<io::path(
+        io::File &, const Logger &, io::BaseByteStream &)>;
+
     struct ParallelUnpackerContext final
     {
         ParallelUnpackerContext(
@@ -49,7 +56,11 @@ namespace flow {
             const dec::Registry &registry,
             const bool enable_nested_decoding,
             const std::vector<std::string> &arguments,
-            const std::set<std::string> &decoders_to_check);
+            const std::set<std::string> &decoders_to_check,
+            const EntryFilter &entry_filter,
+            const bool list_entries,
+            const bool read_ahead,
+            const size_t max_breadth);
 
         const Logger &logger;
         const IFileSaver &file_saver;
@@ -57,6 +68,21 @@ namespace flow {
         const bool enable_nested_decoding;
         const std::vector<std::string> arguments;
         const std::set<std::string> decoders_to_check;
+
+        // Excluded archive entries are never read. Include patterns only
+        // select the files to save, so nested archives are still unpacked.
+        const EntryFilter &entry_filter;
+
+        // Prints the archive entries instead of extracting them.
+        const bool list_entries;
+
+        // Reads archive entries in the order they're stored, on one thread,
+        // and lets the others decode them from memory.
+        const bool read_ahead;
+
+        // How many entries of one archive are queued at a time; the next
+        // ones are queued once these are taken. 0 means no limit.
+        const size_t max_breadth;
     };
 
     struct ParallelTaskContext final
@@ -64,13 +90,23 @@ namespace flow {
         ParallelTaskContext(
             ParallelUnpacker &unpacker,
             const ParallelUnpackerContext &unpacker_context,
-            TaskScheduler &task_scheduler);
+            TaskScheduler &task_scheduler,
+            TaskScheduler &save_task_scheduler,
+            RunStats &stats);
 
         ParallelUnpacker &unpacker;
         const ParallelUnpackerContext &unpacker_context;
         TaskScheduler &task_scheduler;
+        TaskScheduler &save_task_scheduler;
+        RunStats &stats;
+
+        // Whether the decoded files go to the save threads instead of being
+        // saved by the tasks that decoded them.
+        bool save_in_background;
     };
 
+    // Tasks are scheduled with their depth as the priority, so nested files
+    // are unpacked before the next files of the outer archives are taken.
     struct BaseParallelUnpackingTask :
         public ITask,
         public std::enable_shared_from_this<BaseParallelUnpackingTask>
@@ -80,24 +116,44 @@ namespace flow {
             const TaskSourceType source_type,
             const io::path &base_name,
             const std::shared_ptr<const BaseParallelUnpackingTask> parent_task,
-            const std::set<std::string> &decoders_to_check);
+            const std::set<std::string> &decoders_to_check,
+            const u64 content_hash = 0);
 
         virtual ~BaseParallelUnpackingTask() {}
 
         size_t get_depth() const;
 
+        // Whether this task or any of its parents decodes a file with given
+        // content hash, meaning that decoding it again would loop forever.
+        bool is_content_being_decoded(const u64 content_hash) const;
+
+        void schedule(
+            const std::shared_ptr<BaseParallelUnpackingTask> task) const;
+
         void save_file(
             const std::shared_ptr<io::File> input_file,
             const DecoderFileFactory,
             const dec::BaseDecoder &origin_decoder,
+            const std::string &decoder_name,
             const std::string &custom_name = "") const;
 
+        void save_file(
+            const std::shared_ptr<io::File> input_file,
+            const DecoderFileFactory,
+            const DecoderStreamFactory,
+            const dec::BaseDecoder &origin_decoder,
+            const std::string &decoder_name) const;
+
         Logger logger;
         ParallelTaskContext &task_context;
         const TaskSourceType source_type;
         const io::path base_name;
         const std::shared_ptr<const BaseParallelUnpackingTask> parent_task;
         const std::set<std::string> decoders_to_check;
+        const size_t depth;
+
+        // Hash of the decoded file, 0 if unknown.
+        const u64 content_hash;
     };
 
     class ParallelUnpacker final
@@ -107,7 +163,14 @@ namespace flow {
         ~ParallelUnpacker();
 
         void add_input_file(const io::path &base_name, const InputFileFactory);
-        bool run(const size_t thread_count = 0);
+        // With save_thread_count of 0, the files are saved on the same
+        // threads that decode them.
+        bool run(
+            const size_t thread_count = 0,
+            const size_t save_thread_count = 0);
+
+        // Phase timings of the last run, per decoder.
+        const RunStats &get_stats() const;
 
     private:
         struct Priv;
@@ -0,0 +1,361 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/run_stats.h"
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "algo/format.h"
+#include "algo/range.h"
+
+using namespace au;
+using namespace au::flow;
+
+// Latencies are kept in a log-linear histogram: 8 buckets for every power of
+// two, so percentiles are off by at most 1/16 and the memory use is fixed.
+static const size_t sub_bucket_bits = 3;
+static const size_t sub_bucket_count = 1 << sub_bucket_bits;
+static const size_t bucket_count = sub_bucket_count * (64 - sub_bucket_bits + 1);
+
+static std::atomic<u64> last_stats_id(0);
+
+namespace
+{
+    struct Counters final
+    {
+        u64 count = 0;
+        u64 failed_count = 0;
+        u64 total_ns = 0;
+        u64 max_ns = 0;
+        uoff_t bytes_in = 0;
+        uoff_t bytes_out = 0;
+        std::array<u32, bucket_count> histogram {};
+    };
+
+    using CounterKey = std::pair<std::string, RunPhase>;
+
+    struct StageCounters final
+    {
+        size_t thread_count;
+        size_t task_count;
+        u64 busy_ns;
+    };
+
+    struct ThreadBuffer final
+    {
+        std::map<CounterKey, Counters> counters;
+    };
+
+    struct ThreadBufferCache final
+    {
+        u64 stats_id;
+        ThreadBuffer *buffer;
+    };
+}
+
+static thread_local ThreadBufferCache thread_buffer_cache = {0, nullptr};
+
+static size_t get_bucket(const u64 ns)
+{
+    if (ns < sub_bucket_count)
+        return ns;
+    size_t exponent = sub_bucket_bits;
+    while (ns >> (exponent + 1))
+        exponent++;
+    const auto shift = exponent - sub_bucket_bits;
+    return (shift + 1) * sub_bucket_count
+        + ((ns >> shift) & (sub_bucket_count - 1));
+}
+
+static u64 get_bucket_middle(const size_t bucket)
+{
+    if (bucket < sub_bucket_count)
+        return bucket;
+    const auto shift = bucket / sub_bucket_count - 1;
+    const auto mantissa = sub_bucket_count + bucket % sub_bucket_count;
+    return (static_cast<u64>(mantissa) << shift) + ((1ull << shift) >> 1);
+}
+
+static u64 get_percentile(const Counters &counters, const double fraction)
+{
+    if (!counters.count)
+        return 0;
+    const auto rank = std::max<u64>(
+        1, static_cast<u64>(counters.count * fraction + 0.999999));
+    u64 seen = 0;
+    for (const auto bucket : algo::range(bucket_count))
+    {
+        seen += counters.histogram[bucket];
+        if (seen >= rank)
+            return std::min(get_bucket_middle(bucket), counters.max_ns);
+    }
+    return counters.max_ns;
+}
+
+static const char *get_phase_name(const RunPhase phase)
+{
+    switch (phase)
+    {
+        case RunPhase::Recognition: return "recognition";
+        case RunPhase::ReadMeta: return "read_meta";
+        case RunPhase::ReadFile: return "read_file";
+        case RunPhase::Decode: return "decode";
+        case RunPhase::Encode: return "encode";
+        case RunPhase::Save: return "save";
+    }
+    return "unknown";
+}
+
+static std::string escape_json(const std::string &input)
+{
+    std::string output;
+    for (const auto c : input)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output += '\\';
+            output += c;
+        }
+        else if (static_cast<u8>(c) < 0x20)
+            output += algo::format("\\u%04x", static_cast<u8>(c));
+        else
+            output += c;
+    }
+    return output;
+}
+
+static std::string format_seconds(const u64 ns)
+{
+    return algo::format("%.6f", ns / 1e9);
+}
+
+struct RunStats::Priv final
+{
+    ThreadBuffer &get_thread_buffer();
+
+    const u64 id = ++last_stats_id;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+
+    Clock::duration wall_time = Clock::duration::zero();
+    size_t task_count = 0;
+    size_t error_count = 0;
+    size_t saved_file_count = 0;
+    std::map<std::string, StageCounters> stages;
+};
+
+ThreadBuffer &RunStats::Priv::get_thread_buffer()
+{
+    if (thread_buffer_cache.stats_id != id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        thread_buffers.push_back(std::make_unique<ThreadBuffer>());
+        thread_buffer_cache.stats_id = id;
+        thread_buffer_cache.buffer = thread_buffers.back().get();
+    }
+    return *thread_buffer_cache.buffer;
+}
+
+RunStats::RunStats() : p(new Priv())
+{
+}
+
+RunStats::~RunStats()
+{
+}
+
+void RunStats::add_sample(
+    const std::string &decoder_name,
+    const RunPhase phase,
+    const Clock::duration duration,
+    const uoff_t bytes_in,
+    const uoff_t bytes_out,
+    const bool failed)
+{
+    const auto ns = static_cast<u64>(std::max<Clock::rep>(
+        0,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+            .count()));
+    auto &counters
+        = p->get_thread_buffer().counters[CounterKey(decoder_name, phase)];
+    counters.count++;
+    if (failed)
+        counters.failed_count++;
+    counters.total_ns += ns;
+    counters.max_ns = std::max(counters.max_ns, ns);
+    counters.bytes_in += bytes_in;
+    counters.bytes_out += bytes_out;
+    counters.histogram[get_bucket(ns)]++;
+}
+
+void RunStats::set_summary(
+    const Clock::duration wall_time,
+    const size_t task_count,
+    const size_t error_count,
+    const size_t saved_file_count)
+{
+    p->wall_time = wall_time;
+    p->task_count = task_count;
+    p->error_count = error_count;
+    p->saved_file_count = saved_file_count;
+}
+
+void RunStats::set_stage(
+    const std::string &stage_name,
+    const size_t thread_count,
+    const size_t task_count,
+    const Clock::duration busy_time)
+{
+    auto &stage = p->stages[stage_name];
+    stage.thread_count = thread_count;
+    stage.task_count = task_count;
+    stage.busy_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        busy_time).count();
+}
+
+std::string RunStats::to_json() const
+{
+    std::map<CounterKey, Counters> merged;
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        for (const auto &thread_buffer : p->thread_buffers)
+        for (const auto &it : thread_buffer->counters)
+        {
+            auto &target = merged[it.first];
+            const auto &source = it.second;
+            target.count += source.count;
+            target.failed_count += source.failed_count;
+            target.total_ns += source.total_ns;
+            target.max_ns = std::max(target.max_ns, source.max_ns);
+            target.bytes_in += source.bytes_in;
+            target.bytes_out += source.bytes_out;
+            for (const auto i : algo::range(bucket_count))
+                target.histogram[i] += source.histogram[i];
+        }
+    }
+
+    std::string output = "{\n";
+    output += "  \"version\": 1,\n";
+    output += "  \"wall_time\": " + format_seconds(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(p->wall_time)
+            .count()) + ",\n";
+    output += algo::format("  \"tasks\": %llu,\n",
+        static_cast<unsigned long long>(p->task_count));
+    output += algo::format("  \"errors\": %llu,\n",
+        static_cast<unsigned long long>(p->error_count));
+    output += algo::format("  \"saved_files\": %llu,\n",
+        static_cast<unsigned long long>(p->saved_file_count));
+
+    const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        p->wall_time).count();
+    output += "  \"stages\": {";
+    bool first_stage = true;
+    for (const auto &it : p->stages)
+    {
+        const auto &stage = it.second;
+        const auto available_ns = static_cast<double>(wall_ns)
+            * stage.thread_count;
+        output += algo::format(
+            "%s\n    \"%s\": {"
+            "\"threads\": %llu, "
+            "\"tasks\": %llu, "
+            "\"busy\": %s, "
+            "\"utilization\": %.4f}",
+            first_stage ? "" : ",",
+            escape_json(it.first).c_str(),
+            static_cast<unsigned long long>(stage.thread_count),
+            static_cast<unsigned long long>(stage.task_count),
+            format_seconds(stage.busy_ns).c_str(),
+            available_ns > 0 ? stage.busy_ns / available_ns : 0.0);
+        first_stage = false;
+    }
+    output += p->stages.empty() ? "},\n" : "\n  },\n";
+    output += "  \"decoders\": {";
+
+    std::string last_decoder_name;
+    bool first_decoder = true;
+    for (const auto &it : merged)
+    {
+        const auto &decoder_name = it.first.first;
+        const auto &counters = it.second;
+        const auto new_decoder = first_decoder
+            || decoder_name != last_decoder_name;
+        if (new_decoder)
+        {
+            if (!first_decoder)
+                output += "\n    },";
+            output += "\n    \"" + escape_json(decoder_name) + "\": {";
+            first_decoder = false;
+            last_decoder_name = decoder_name;
+        }
+        else
+            output += ",";
+
+        output += algo::format(
+            "\n      \"%s\": {"
+            "\"count\": %llu, "
+            "\"failed\": %llu, "
+            "\"total\": %s, "
+            "\"p50\": %s, "
+            "\"p99\": %s, "
+            "\"max\": %s, "
+            "\"bytes_in\": %llu, "
+            "\"bytes_out\": %llu}",
+            get_phase_name(it.first.second),
+            static_cast<unsigned long long>(counters.count),
+            static_cast<unsigned long long>(counters.failed_count),
+            format_seconds(counters.total_ns).c_str(),
+            format_seconds(get_percentile(counters, 0.5)).c_str(),
+            format_seconds(get_percentile(counters, 0.99)).c_str(),
+            format_seconds(counters.max_ns).c_str(),
+            static_cast<unsigned long long>(counters.bytes_in),
+            static_cast<unsigned long long>(counters.bytes_out));
+    }
+    if (!first_decoder)
+        output += "\n    }\n  ";
+    output += "}\n}\n";
+    return output;
+}
+
+RunPhaseTimer::RunPhaseTimer(
+    RunStats &stats, const std::string &decoder_name, const RunPhase phase) :
+        stats(stats),
+        decoder_name(decoder_name),
+        phase(phase),
+        start(RunStats::Clock::now()),
+        finished(false)
+{
+}
+
+RunPhaseTimer::~RunPhaseTimer()
+{
+    if (!finished)
+        stats.add_sample(
+            decoder_name, phase, RunStats::Clock::now() - start, 0, 0, true);
+}
+
+void RunPhaseTimer::finish(const uoff_t bytes_in, const uoff_t bytes_out)
+{
+    if (finished)
+        return;
+    finished = true;
+    stats.add_sample(
+        decoder_name, phase, RunStats::Clock::now() - start,
+        bytes_in, bytes_out);
+}
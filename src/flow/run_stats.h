@@ -0,0 +1,99 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include "types.h"
+
+namespace au {
+namespace flow {
+
+    enum class RunPhase : u8
+    {
+        Recognition,
+        ReadMeta,
+        ReadFile,
+        Decode,
+        Encode,
+        Save,
+    };
+
+    // Aggregates phase timings per decoder. Samples go to per-thread buffers,
+    // so recording doesn't contend between the workers; the buffers are merged
+    // only by to_json(), which must not run concurrently with recording.
+    class RunStats final
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        RunStats();
+        ~RunStats();
+
+        void add_sample(
+            const std::string &decoder_name,
+            const RunPhase phase,
+            const Clock::duration duration,
+            const uoff_t bytes_in,
+            const uoff_t bytes_out,
+            const bool failed = false);
+
+        void set_summary(
+            const Clock::duration wall_time,
+            const size_t task_count,
+            const size_t error_count,
+            const size_t saved_file_count);
+
+        // Records how busy the workers of one pipeline stage were. Their
+        // utilization is reported relative to the wall time of the summary.
+        void set_stage(
+            const std::string &stage_name,
+            const size_t thread_count,
+            const size_t task_count,
+            const Clock::duration busy_time);
+
+        std::string to_json() const;
+
+    private:
+        struct Priv;
+        std::unique_ptr<Priv> p;
+    };
+
+    // Measures one phase from construction until finish(). If it's destroyed
+    // before that, e.g. by an exception, the sample is recorded as failed.
+    class RunPhaseTimer final
+    {
+    public:
+        RunPhaseTimer(
+            RunStats &stats,
+            const std::string &decoder_name,
+            const RunPhase phase);
+        ~RunPhaseTimer();
+
+        void finish(const uoff_t bytes_in, const uoff_t bytes_out);
+
+    private:
+        RunStats &stats;
+        const std::string decoder_name;
+        const RunPhase phase;
+        const RunStats::Clock::time_point start;
+        bool finished;
+    };
+
+} }
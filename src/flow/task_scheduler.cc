@@ -16,8 +16,9 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "flow/task_scheduler.h"
-#include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <map>
 #include <thread>
 #include <vector>
 #include "algo/range.h"
@@ -27,11 +28,45 @@ using namespace au::flow;
 
 struct TaskScheduler::Priv final
 {
-    std::deque<std::shared_ptr<ITask>> tasks;
+    Priv(const size_t capacity);
+    std::shared_ptr<ITask> pop();
+    void wait_for_room(std::unique_lock<std::mutex> &lock);
+
+    const size_t capacity;
+
+    // by priority, highest last
+    std::map<int, std::deque<std::shared_ptr<ITask>>> tasks;
     std::vector<std::unique_ptr<std::thread>> threads;
+    std::condition_variable task_added;
+    std::condition_variable task_taken;
+    size_t queued_task_count = 0;
+    size_t running_task_count = 0;
+    size_t hold_count = 0;
 };
 
-TaskScheduler::TaskScheduler() : p(new Priv())
+TaskScheduler::Priv::Priv(const size_t capacity) : capacity(capacity)
+{
+}
+
+std::shared_ptr<ITask> TaskScheduler::Priv::pop()
+{
+    const auto it = std::prev(tasks.end());
+    const auto task = it->second.front();
+    it->second.pop_front();
+    if (it->second.empty())
+        tasks.erase(it);
+    queued_task_count--;
+    task_taken.notify_one();
+    return task;
+}
+
+void TaskScheduler::Priv::wait_for_room(std::unique_lock<std::mutex> &lock)
+{
+    if (capacity)
+        task_taken.wait(lock, [&]() { return queued_task_count < capacity; });
+}
+
+TaskScheduler::TaskScheduler(const size_t capacity) : p(new Priv(capacity))
 {
 }
 
@@ -39,16 +74,35 @@ TaskScheduler::~TaskScheduler()
 {
 }
 
-void TaskScheduler::push_front(std::shared_ptr<ITask> task)
+void TaskScheduler::push_front(std::shared_ptr<ITask> task, const int priority)
 {
     std::unique_lock<std::mutex> lock(mutex);
-    p->tasks.push_front(task);
+    p->wait_for_room(lock);
+    p->tasks[priority].push_front(task);
+    p->queued_task_count++;
+    p->task_added.notify_one();
 }
 
-void TaskScheduler::push_back(std::shared_ptr<ITask> task)
+void TaskScheduler::push_back(std::shared_ptr<ITask> task, const int priority)
 {
     std::unique_lock<std::mutex> lock(mutex);
-    p->tasks.push_back(task);
+    p->wait_for_room(lock);
+    p->tasks[priority].push_back(task);
+    p->queued_task_count++;
+    p->task_added.notify_one();
+}
+
+void TaskScheduler::hold()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    p->hold_count++;
+}
+
+void TaskScheduler::release()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    p->hold_count--;
+    p->task_added.notify_all();
 }
 
 TaskSchedulerResult TaskScheduler::run(size_t number_of_threads)
@@ -61,41 +115,42 @@ TaskSchedulerResult TaskScheduler::run(size_t number_of_threads)
     TaskSchedulerResult result;
     result.success_count = 0;
     result.error_count = 0;
-    bool still_running = true;
+    result.thread_count = number_of_threads;
+    result.busy_time = std::chrono::steady_clock::duration::zero();
 
     for (const auto i : algo::range(number_of_threads))
     {
         p->threads.push_back(std::make_unique<std::thread>([&]()
         {
+            std::unique_lock<std::mutex> lock(mutex);
             while (true)
             {
-                std::shared_ptr<ITask> task;
-
+                // idle workers wait for as long as any task that is still
+                // running can queue new ones
+                p->task_added.wait(lock, [&]()
                 {
-                    std::unique_lock<std::mutex> lock(mutex);
-                    if (p->tasks.empty())
-                    {
-                        if (still_running && number_of_threads > 1)
-                        {
-                            lock.unlock();
-                            std::this_thread::sleep_for(
-                                std::chrono::milliseconds(10));
-                            continue;
-                        }
-                        break;
-                    }
-                    task = p->tasks.front();
-                    p->tasks.pop_front();
-                }
+                    return !p->tasks.empty()
+                        || (!p->running_task_count && !p->hold_count);
+                });
+                if (p->tasks.empty())
+                    break;
 
+                auto task = p->pop();
+                p->running_task_count++;
+                lock.unlock();
+
+                const auto start = std::chrono::steady_clock::now();
                 const auto local_success = task->work();
+                task.reset();
+                const auto busy_time = std::chrono::steady_clock::now() - start;
 
-                {
-                    std::unique_lock<std::mutex> lock(mutex);
-                    result.success_count += local_success;
-                    result.error_count += !local_success;
-                    still_running = !p->tasks.empty();
-                }
+                lock.lock();
+                p->running_task_count--;
+                result.success_count += local_success;
+                result.error_count += !local_success;
+                result.busy_time += busy_time;
+                if (p->tasks.empty() && !p->running_task_count)
+                    p->task_added.notify_all();
             }
         }));
     }
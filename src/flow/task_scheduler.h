@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 
@@ -34,17 +35,32 @@ namespace flow {
     {
         int success_count;
         int error_count;
+        size_t thread_count;
+
+        // Time the workers spent running tasks, summed over all of them.
+        std::chrono::steady_clock::duration busy_time;
     };
 
+    // Tasks with higher priority are always picked first. Among the tasks of
+    // the same priority, push_front makes the task the next one to run and
+    // push_back makes it the last one.
+    //
+    // With non-zero capacity, pushing blocks for as long as that many tasks
+    // are waiting, so tasks must not push into their own bounded scheduler.
     class TaskScheduler final
     {
     public:
-        TaskScheduler();
+        TaskScheduler(const size_t capacity = 0);
         ~TaskScheduler();
         TaskSchedulerResult run(const size_t number_of_threads = 0);
-        void push_front(std::shared_ptr<ITask> task);
-        void push_back(std::shared_ptr<ITask> task);
-        void join();
+        void push_front(std::shared_ptr<ITask> task, const int priority = 0);
+        void push_back(std::shared_ptr<ITask> task, const int priority = 0);
+
+        // While held, idle workers keep waiting for tasks even if there are
+        // none left, so that tasks can come from outside of the scheduler.
+        void hold();
+        void release();
+
         std::mutex mutex;
     private:
         struct Priv;
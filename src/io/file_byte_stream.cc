@@ -16,7 +16,9 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "io/file_byte_stream.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include "algo/locale.h"
 #include "err.h"
 
@@ -25,11 +27,106 @@
     #include <io.h>
     #include <sys/stat.h>
     #include <sys/types.h>
+#else
+    #include <cerrno>
+    #include <map>
+    #include <mutex>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/sendfile.h>
+    #endif
 #endif
 
+static const size_t copy_chunk_size = 1024 * 1024;
+static const size_t read_buffer_size = 16 * 1024;
+
 using namespace au;
 using namespace au::io;
 
+#if !_WIN32
+    namespace
+    {
+        // Descriptor shared by all the read-only streams of the same file.
+        // Streams read from it with pread, so they don't have to agree on
+        // the file position.
+        struct SharedHandle final
+        {
+            ~SharedHandle();
+
+            std::string path;
+            int fd;
+            struct stat stat;
+        };
+    }
+
+    static std::mutex handles_mutex;
+    static std::map<std::string, std::weak_ptr<SharedHandle>> handles;
+
+    SharedHandle::~SharedHandle()
+    {
+        ::close(fd);
+        std::unique_lock<std::mutex> lock(handles_mutex);
+        const auto it = handles.find(path);
+        if (it != handles.end() && it->second.expired())
+            handles.erase(it);
+    }
+
+    static bool is_same_file(const struct stat &a, const struct stat &b)
+    {
+        return a.st_dev == b.st_dev
+            && a.st_ino == b.st_ino
+            && a.st_size == b.st_size
+            && a.st_mtime == b.st_mtime;
+    }
+
+    static std::shared_ptr<SharedHandle> open_shared_handle(const path &path)
+    {
+        struct stat stat;
+        if (::stat(path.c_str(), &stat) != 0)
+            throw err::FileNotFoundError("Could not open " + path.str());
+
+        // A stale cached handle must be released only after the lock is
+        // gone, since its destructor takes the lock too.
+        std::shared_ptr<SharedHandle> cached_handle;
+        std::unique_lock<std::mutex> lock(handles_mutex);
+        auto &weak_handle = handles[path.str()];
+        cached_handle = weak_handle.lock();
+        if (cached_handle && is_same_file(cached_handle->stat, stat))
+            return cached_handle;
+
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw err::FileNotFoundError("Could not open " + path.str());
+        auto handle = std::make_shared<SharedHandle>();
+        handle->path = path.str();
+        handle->fd = fd;
+        if (::fstat(fd, &handle->stat) != 0)
+            handle->stat = stat;
+        weak_handle = handle;
+        return handle;
+    }
+
+    static bool read_at(
+        const int fd, void *destination, size_t size, uoff_t offset)
+    {
+        auto ptr = static_cast<char*>(destination);
+        while (size)
+        {
+            const auto ret = ::pread(fd, ptr, size, offset);
+            if (ret == -1 && errno == EINTR)
+                continue;
+            if (ret <= 0)
+                return false;
+            ptr += ret;
+            size -= ret;
+            offset += ret;
+        }
+        return true;
+    }
+#endif
+
 struct FileByteStream::Priv final
 {
     #if _WIN32
@@ -56,66 +153,245 @@ struct FileByteStream::Priv final
             return _telli64(fd);
         }
 
-        void seek(const uoff_t offset, const int whence)
+        uoff_t size()
+        {
+            const auto old_pos = tell();
+            _lseeki64(fd, 0, SEEK_END);
+            const auto size = tell();
+            _lseeki64(fd, old_pos, SEEK_SET);
+            return size;
+        }
+
+        void seek(const uoff_t offset)
         {
-            _lseeki64(fd, offset, whence);
+            _lseeki64(fd, offset, SEEK_SET);
         }
 
-        void read(void *source, const size_t size)
+        void read(void *destination, const size_t size)
         {
-            const size_t ret = _read(fd, source, size);
+            const size_t ret = _read(fd, destination, size);
             if (ret != size)
                 throw err::EofError();
         }
 
-        void write(const void *destination, const size_t size)
+        void write(const void *source, const size_t size)
         {
-            const size_t ret = _write(fd, destination, size);
+            const size_t ret = _write(fd, source, size);
             if (ret != size)
                 throw err::IoError("Could not write full data");
         }
 
+        void flush()
+        {
+        }
+
         int fd;
     #else
-        Priv(const path &path, FileMode mode) : path(path), mode(mode)
+        Priv(const path &path, FileMode mode) :
+            file(nullptr), position(0), path(path), mode(mode)
         {
-            fd = std::fopen(
-                path.c_str(),
-                mode == FileMode::Write ? "w+b" : "rb");
-            if (!fd)
+            if (mode == FileMode::Read)
+            {
+                handle = open_shared_handle(path);
+                return;
+            }
+            file = std::fopen(path.c_str(), "w+b");
+            if (!file)
                 throw err::FileNotFoundError("Could not open " + path.str());
         }
 
+        // Clones share the descriptor, but not the read buffer.
+        Priv(const Priv &other) :
+            file(nullptr),
+            handle(other.handle),
+            position(other.position),
+            path(other.path),
+            mode(other.mode)
+        {
+        }
+
         ~Priv()
         {
-            fclose(fd);
+            if (file)
+                fclose(file);
         }
 
         uoff_t tell()
         {
-            return ftello(fd);
+            return handle ? position : ftello(file);
         }
 
-        void seek(const uoff_t offset, const int whence)
+        uoff_t size()
         {
-            const auto ret = fseeko(fd, offset, whence);
-            if (ret != 0)
-                throw err::EofError();
+            if (handle)
+                return handle->stat.st_size;
+            const auto old_pos = ftello(file);
+            fseeko(file, 0, SEEK_END);
+            const auto size = ftello(file);
+            fseeko(file, old_pos, SEEK_SET);
+            return size;
         }
 
-        void read(void *source, const size_t size)
+        void seek(const uoff_t offset)
         {
-            if (fread(source, 1, size, fd) != size)
+            if (handle)
+                position = offset;
+            else if (fseeko(file, offset, SEEK_SET) != 0)
                 throw err::EofError();
         }
 
-        void write(const void *destination, const size_t size)
+        void read(void *destination, const size_t size)
+        {
+            if (!handle)
+            {
+                if (fread(destination, 1, size, file) != size)
+                    throw err::EofError();
+                return;
+            }
+
+            if (position < buffer_offset
+                || position + size > buffer_offset + buffer_size)
+            {
+                // big reads skip the buffer entirely
+                if (size >= read_buffer_size)
+                {
+                    if (!read_at(handle->fd, destination, size, position))
+                        throw err::EofError();
+                    position += size;
+                    return;
+                }
+
+                if (!buffer)
+                    buffer.reset(new u8[read_buffer_size]);
+                const auto ret = ::pread(
+                    handle->fd, buffer.get(), read_buffer_size, position);
+                buffer_offset = position;
+                buffer_size = ret > 0 ? ret : 0;
+                if (buffer_size < size
+                    && !read_at(
+                        handle->fd,
+                        buffer.get() + buffer_size,
+                        size - buffer_size,
+                        position + buffer_size))
+                {
+                    throw err::EofError();
+                }
+                buffer_size = std::max(buffer_size, size);
+            }
+
+            std::memcpy(
+                destination, buffer.get() + (position - buffer_offset), size);
+            position += size;
+        }
+
+        void write(const void *source, const size_t size)
+        {
+            if (!file || fwrite(source, 1, size, file) != size)
+                throw err::IoError("Could not write full data");
+        }
+
+        void flush()
         {
-            if (fwrite(destination, 1, size, fd) != size)
+            if (file && fflush(file) != 0)
                 throw err::IoError("Could not write full data");
         }
 
-        FILE *fd;
+        void write_range(const FileRange &range)
+        {
+            if (!file || fflush(file) != 0)
+                throw err::IoError("Could not write full data");
+
+            const auto input_fd = ::open(range.path.c_str(), O_RDONLY);
+            if (input_fd == -1)
+            {
+                throw err::FileNotFoundError(
+                    "Could not open " + range.path.str());
+            }
+
+            const auto output_fd = fileno(file);
+            off_t offset = range.offset;
+            auto left = range.size;
+
+            #ifdef __linux__
+                // both calls may be unsupported for a given pair of files, in
+                // which case they fail without copying anything
+                #if defined(__GLIBC__) \
+                    && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 27)
+                    while (left)
+                    {
+                        const auto ret = ::copy_file_range(
+                            input_fd, &offset, output_fd, nullptr, left, 0);
+                        if (ret <= 0)
+                            break;
+                        left -= ret;
+                    }
+                #endif
+                while (left)
+                {
+                    const auto ret = ::sendfile(
+                        output_fd, input_fd, &offset, left);
+                    if (ret <= 0)
+                        break;
+                    left -= ret;
+                }
+            #endif
+
+            std::unique_ptr<char[]> buffer;
+            while (left)
+            {
+                if (!buffer)
+                    buffer.reset(new char[copy_chunk_size]);
+                const auto ret = ::pread(
+                    input_fd,
+                    buffer.get(),
+                    std::min<uoff_t>(left, copy_chunk_size),
+                    offset);
+                if (ret <= 0)
+                {
+                    ::close(input_fd);
+                    throw err::EofError();
+                }
+                for (ssize_t written = 0; written < ret; )
+                {
+                    const auto ret2 = ::write(
+                        output_fd, buffer.get() + written, ret - written);
+                    if (ret2 <= 0)
+                    {
+                        ::close(input_fd);
+                        throw err::IoError("Could not write full data");
+                    }
+                    written += ret2;
+                }
+                offset += ret;
+                left -= ret;
+            }
+
+            ::close(input_fd);
+
+            // let stdio pick up the new file position
+            fseeko(file, 0, SEEK_CUR);
+        }
+
+        void will_need(const uoff_t offset, const uoff_t size)
+        {
+            #if defined(POSIX_FADV_WILLNEED)
+                ::posix_fadvise(
+                    handle ? handle->fd : fileno(file),
+                    offset,
+                    size,
+                    POSIX_FADV_WILLNEED);
+            #endif
+        }
+
+        // FileMode::Write
+        FILE *file;
+
+        // FileMode::Read
+        std::shared_ptr<SharedHandle> handle;
+        uoff_t position;
+        std::unique_ptr<u8[]> buffer;
+        uoff_t buffer_offset = 0;
+        size_t buffer_size = 0;
     #endif
 
     io::path path;
@@ -127,6 +403,10 @@ FileByteStream::FileByteStream(const path &path, const FileMode mode)
 {
 }
 
+FileByteStream::FileByteStream(std::unique_ptr<Priv> p) : p(std::move(p))
+{
+}
+
 FileByteStream::~FileByteStream()
 {
 }
@@ -135,7 +415,7 @@ void FileByteStream::seek_impl(const uoff_t offset)
 {
     if (offset > size())
         throw err::EofError();
-    p->seek(offset, SEEK_SET);
+    p->seek(offset);
 }
 
 void FileByteStream::read_impl(void *destination, const size_t size)
@@ -157,11 +437,7 @@ uoff_t FileByteStream::pos() const
 
 uoff_t FileByteStream::size() const
 {
-    const auto old_pos = p->tell();
-    p->seek(0, SEEK_END);
-    const auto size = p->tell();
-    p->seek(old_pos, SEEK_SET);
-    return size;
+    return p->size();
 }
 
 void FileByteStream::resize_impl(const uoff_t new_size)
@@ -171,8 +447,50 @@ void FileByteStream::resize_impl(const uoff_t new_size)
     throw err::NotSupportedError("Truncating real files is not implemented");
 }
 
+void FileByteStream::flush()
+{
+    p->flush();
+}
+
+const io::path &FileByteStream::get_path() const
+{
+    return p->path;
+}
+
+void FileByteStream::write_file_range(const FileRange &range)
+{
+    #if _WIN32
+        FileByteStream input_stream(range.path, FileMode::Read);
+        input_stream.seek(range.offset);
+        auto left = range.size;
+        while (left)
+        {
+            const auto chunk_size = std::min<uoff_t>(left, copy_chunk_size);
+            write(input_stream.read(chunk_size));
+            left -= chunk_size;
+        }
+    #else
+        p->write_range(range);
+    #endif
+}
+
+void FileByteStream::will_need(const uoff_t offset, const uoff_t size)
+{
+    #if !_WIN32
+        p->will_need(offset, size);
+    #endif
+}
+
 std::unique_ptr<io::BaseByteStream> FileByteStream::clone() const
 {
+    #if !_WIN32
+        // read-only streams share the descriptor, which costs no syscalls
+        if (p->mode == FileMode::Read)
+        {
+            return std::unique_ptr<BaseByteStream>(
+                new FileByteStream(std::make_unique<Priv>(*p)));
+        }
+    #endif
     auto ret = std::make_unique<FileByteStream>(p->path, p->mode);
     ret->seek(pos());
     return std::move(ret);
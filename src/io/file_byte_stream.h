@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include "io/base_byte_stream.h"
+#include "io/file_range.h"
 #include "io/path.h"
 
 namespace au {
@@ -42,6 +43,20 @@ namespace io {
 
         std::unique_ptr<BaseByteStream> clone() const override;
 
+        const path &get_path() const;
+
+        // Hands the data buffered by the C library over to the OS, so that
+        // the errors writing it show up here rather than on closing.
+        void flush();
+
+        // Appends a part of another file. Where the OS allows it, the data is
+        // copied by the kernel without passing through this process.
+        void write_file_range(const FileRange &range);
+
+        // Tells the OS that given part of the file will be read soon, so that
+        // it can start reading it in the background. Only a hint.
+        void will_need(const uoff_t offset, const uoff_t size);
+
     protected:
         void read_impl(void *destination, const size_t size) override;
         void write_impl(const void *source, const size_t size) override;
@@ -50,6 +65,7 @@ namespace io {
 
     private:
         struct Priv;
+        FileByteStream(std::unique_ptr<Priv> p);
         std::unique_ptr<Priv> p;
     };
 
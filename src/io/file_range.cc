@@ -0,0 +1,47 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "io/file_range.h"
+#include "io/file_byte_stream.h"
+#include "io/slice_byte_stream.h"
+
+using namespace au;
+using namespace au::io;
+
+std::unique_ptr<FileRange> io::get_file_range(const BaseByteStream &stream)
+{
+    if (const auto file_stream = dynamic_cast<const FileByteStream*>(&stream))
+    {
+        auto range = std::make_unique<FileRange>();
+        range->path = file_stream->get_path();
+        range->offset = 0;
+        range->size = file_stream->size();
+        return range;
+    }
+
+    if (const auto slice_stream = dynamic_cast<const SliceByteStream*>(&stream))
+    {
+        auto range = get_file_range(slice_stream->get_parent_stream());
+        if (!range)
+            return nullptr;
+        range->offset += slice_stream->get_slice_offset();
+        range->size = slice_stream->size();
+        return range;
+    }
+
+    return nullptr;
+}
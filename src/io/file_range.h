@@ -0,0 +1,38 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include "io/base_byte_stream.h"
+#include "io/path.h"
+
+namespace au {
+namespace io {
+
+    struct FileRange final
+    {
+        io::path path;
+        uoff_t offset;
+        uoff_t size;
+    };
+
+    // Returns the part of a physical file that the stream exposes verbatim,
+    // or nullptr if its contents come from memory or are transformed.
+    std::unique_ptr<FileRange> get_file_range(const BaseByteStream &stream);
+
+} }
@@ -17,6 +17,17 @@
 
 #include "io/file_system.h"
 #include <boost/filesystem/path.hpp>
+#include "err.h"
+
+#if _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 using namespace au;
 using namespace au::io;
@@ -36,6 +47,16 @@ bool io::is_directory(const path &p)
     return boost::filesystem::is_directory(p.str());
 }
 
+bool io::is_symlink(const path &p)
+{
+    return boost::filesystem::is_symlink(p.str());
+}
+
+uoff_t io::file_size(const path &p)
+{
+    return boost::filesystem::file_size(p.str());
+}
+
 path io::current_working_directory()
 {
     return boost::filesystem::current_path().string();
@@ -46,6 +67,12 @@ path io::absolute(const path &p)
     return boost::filesystem::absolute(p.str()).string();
 }
 
+bool io::is_same_file(const path &a, const path &b)
+{
+    boost::system::error_code ec;
+    return boost::filesystem::equivalent(a.str(), b.str(), ec) && !ec;
+}
+
 void io::create_directories(const path &p)
 {
     const auto bp = boost::filesystem::path(p.str());
@@ -57,3 +84,59 @@ void io::remove(const path &p)
 {
     boost::filesystem::remove(p.str());
 }
+
+void io::rename(const path &old_path, const path &new_path)
+{
+    boost::filesystem::rename(old_path.str(), new_path.str());
+}
+
+bool io::write_file(const path &p, const bstr &content, const bool overwrite)
+{
+    #if _WIN32
+        const auto fd = _wopen(
+            p.wstr().c_str(),
+            _O_WRONLY | _O_CREAT | _O_BINARY
+                | (overwrite ? _O_TRUNC : _O_EXCL),
+            _S_IREAD | _S_IWRITE);
+    #else
+        const auto fd = ::open(
+            p.c_str(),
+            O_WRONLY | O_CREAT | (overwrite ? O_TRUNC : O_EXCL),
+            0666);
+    #endif
+    if (fd == -1)
+    {
+        if (!overwrite && errno == EEXIST)
+            return false;
+        throw err::FileNotFoundError("Could not open " + p.str());
+    }
+
+    auto data = content.get<char>();
+    auto left = content.size();
+    bool failed = false;
+    while (left && !failed)
+    {
+        #if _WIN32
+            const auto ret = _write(fd, data, static_cast<unsigned>(left));
+        #else
+            const auto ret = ::write(fd, data, left);
+            if (ret == -1 && errno == EINTR)
+                continue;
+        #endif
+        failed = ret <= 0;
+        if (!failed)
+        {
+            data += ret;
+            left -= ret;
+        }
+    }
+
+    #if _WIN32
+        failed |= _close(fd) != 0;
+    #else
+        failed |= ::close(fd) != 0;
+    #endif
+    if (failed)
+        throw err::IoError("Could not write full data");
+    return true;
+}
@@ -19,6 +19,7 @@
 
 #include <boost/filesystem.hpp>
 #include "io/path.h"
+#include "types.h"
 
 namespace au {
 namespace io {
@@ -27,10 +28,20 @@ namespace io {
     bool exists(const path &p);
     bool is_directory(const path &p);
     bool is_regular_file(const path &p);
+    bool is_symlink(const path &p);
+    uoff_t file_size(const path &p);
     path absolute(const path &p);
 
+    // Tells whether both paths point to the same existing file.
+    bool is_same_file(const path &a, const path &b);
+
     void create_directories(const path &p);
     void remove(const path &p);
+    void rename(const path &old_path, const path &new_path);
+
+    // Writes the whole file at once, bypassing stdio buffering. Returns false
+    // if the file already exists and overwrite is false.
+    bool write_file(const path &p, const bstr &content, const bool overwrite);
 
     template<typename T> class BaseDirectoryRange final
     {
@@ -0,0 +1,108 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "io/prefetched_byte_stream.h"
+#include <cstring>
+#include "err.h"
+
+using namespace au;
+using namespace au::io;
+
+PrefetchedByteStream::PrefetchedByteStream(
+    const std::shared_ptr<const BaseByteStream> source_stream,
+    const uoff_t source_size,
+    const uoff_t prefetch_offset,
+    const bstr &prefetched_data) :
+        source_stream(source_stream),
+        source_size(source_size),
+        prefetch_offset(prefetch_offset),
+        prefetched_data(std::make_shared<const bstr>(prefetched_data)),
+        position(0)
+{
+    if (prefetch_offset + prefetched_data.size() > source_size)
+        throw err::BadDataSizeError();
+}
+
+PrefetchedByteStream::PrefetchedByteStream(
+    const PrefetchedByteStream &other_stream) :
+        source_stream(other_stream.source_stream),
+        source_size(other_stream.source_size),
+        prefetch_offset(other_stream.prefetch_offset),
+        prefetched_data(other_stream.prefetched_data),
+        position(other_stream.position)
+{
+}
+
+PrefetchedByteStream::~PrefetchedByteStream()
+{
+}
+
+void PrefetchedByteStream::seek_impl(const uoff_t offset)
+{
+    if (offset > source_size)
+        throw err::EofError();
+    position = offset;
+}
+
+void PrefetchedByteStream::read_impl(void *destination, const size_t size)
+{
+    if (size > source_size - position)
+        throw err::EofError();
+
+    if (position >= prefetch_offset
+        && position + size <= prefetch_offset + prefetched_data->size())
+    {
+        std::memcpy(
+            destination,
+            prefetched_data->get<u8>() + (position - prefetch_offset),
+            size);
+    }
+    else
+    {
+        if (!fallback_stream)
+            fallback_stream = source_stream->clone();
+        fallback_stream->seek(position);
+        const auto chunk = fallback_stream->read(size);
+        std::memcpy(destination, chunk.get<u8>(), size);
+    }
+    position += size;
+}
+
+void PrefetchedByteStream::write_impl(const void *source, const size_t size)
+{
+    throw err::NotSupportedError("Not implemented");
+}
+
+uoff_t PrefetchedByteStream::pos() const
+{
+    return position;
+}
+
+uoff_t PrefetchedByteStream::size() const
+{
+    return source_size;
+}
+
+void PrefetchedByteStream::resize_impl(const uoff_t new_size)
+{
+    throw err::NotSupportedError("Not implemented");
+}
+
+std::unique_ptr<io::BaseByteStream> PrefetchedByteStream::clone() const
+{
+    return std::unique_ptr<BaseByteStream>(new PrefetchedByteStream(*this));
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include "io/base_byte_stream.h"
+
+namespace au {
+namespace io {
+
+    // Read-only view of a stream, a part of which was read in advance.
+    // Reads within that part are served from memory; anything else goes
+    // through a clone of the source stream, made the first time it's needed.
+    class PrefetchedByteStream final : public BaseByteStream
+    {
+    public:
+        PrefetchedByteStream(
+            const std::shared_ptr<const BaseByteStream> source_stream,
+            const uoff_t source_size,
+            const uoff_t prefetch_offset,
+            const bstr &prefetched_data);
+        ~PrefetchedByteStream();
+
+        uoff_t size() const override;
+        uoff_t pos() const override;
+        std::unique_ptr<BaseByteStream> clone() const override;
+
+    protected:
+        void read_impl(void *destination, const size_t size) override;
+        void write_impl(const void *source, const size_t size) override;
+        void seek_impl(const uoff_t offset) override;
+        void resize_impl(const uoff_t new_size) override;
+
+    private:
+        PrefetchedByteStream(const PrefetchedByteStream &other_stream);
+
+        const std::shared_ptr<const BaseByteStream> source_stream;
+        const uoff_t source_size;
+        const uoff_t prefetch_offset;
+        const std::shared_ptr<const bstr> prefetched_data;
+        std::unique_ptr<BaseByteStream> fallback_stream;
+        uoff_t position;
+    };
+
+} }
@@ -75,6 +75,16 @@ void SliceByteStream::resize_impl(const uoff_t new_size)
     throw err::NotSupportedError("Not implemented");
 }
 
+const io::BaseByteStream &SliceByteStream::get_parent_stream() const
+{
+    return *parent_stream;
+}
+
+uoff_t SliceByteStream::get_slice_offset() const
+{
+    return slice_offset;
+}
+
 std::unique_ptr<io::BaseByteStream> SliceByteStream::clone() const
 {
     auto ret = std::make_unique<SliceByteStream>(
@@ -38,6 +38,9 @@ namespace io {
         uoff_t pos() const override;
         std::unique_ptr<BaseByteStream> clone() const override;
 
+        const BaseByteStream &get_parent_stream() const;
+        uoff_t get_slice_offset() const;
+
     protected:
         void read_impl(void *destination, const size_t size) override;
         void write_impl(const void *source, const size_t size) override;
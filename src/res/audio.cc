@@ -29,3 +29,14 @@ Audio::Audio() :
     samples(""_b)
 {
 }
+
+void AudioBuffer::begin(const Audio &format)
+{
+    audio = format;
+    audio.samples = ""_b;
+}
+
+void AudioBuffer::write(const bstr &samples)
+{
+    audio.samples += samples;
+}
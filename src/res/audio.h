@@ -45,4 +45,26 @@ namespace res {
         bstr samples;
     };
 
+    // Consumes PCM data as it gets decoded, so that long tracks don't need
+    // to be held in memory all at once. begin() receives the stream format
+    // and is called exactly once before any write(); the samples it carries,
+    // if any, are to be ignored.
+    class IAudioSink
+    {
+    public:
+        virtual ~IAudioSink() {}
+        virtual void begin(const Audio &format) = 0;
+        virtual void write(const bstr &samples) = 0;
+    };
+
+    // Sink that concatenates everything into a regular Audio.
+    class AudioBuffer final : public IAudioSink
+    {
+    public:
+        void begin(const Audio &format) override;
+        void write(const bstr &samples) override;
+
+        Audio audio;
+    };
+
 } }
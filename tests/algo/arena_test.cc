@@ -0,0 +1,58 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/arena.h"
+#include <cstring>
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("Arena allocation", "[algo]")
+{
+    algo::Arena arena(64);
+
+    SECTION("Alignment")
+    {
+        for (const size_t alignment : {1, 2, 4, 8, 16})
+        {
+            arena.allocate(1, 1);
+            const auto ptr = arena.allocate(3, alignment);
+            REQUIRE(reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+        }
+    }
+
+    SECTION("Allocations don't overlap")
+    {
+        std::vector<u8*> ptrs;
+        for (const auto i : {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})
+        {
+            ptrs.push_back(static_cast<u8*>(arena.allocate(20, 4)));
+            std::memset(ptrs.back(), i, 20);
+        }
+        for (const auto i : {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})
+            for (const auto j : {0, 19})
+                REQUIRE(ptrs[i][j] == i);
+    }
+
+    SECTION("Oversized allocations")
+    {
+        arena.allocate(10, 1);
+        const auto ptr = static_cast<u8*>(arena.allocate(1000, 8));
+        std::memset(ptr, 0xFF, 1000);
+        REQUIRE(arena.get_reserved_size() >= 1064);
+    }
+}
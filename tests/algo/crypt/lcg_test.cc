@@ -16,8 +16,10 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "algo/crypt/lcg.h"
+#include "algo/range.h"
 #include "test_support/catch.h"
 
+using namespace au;
 using namespace au::algo::crypt;
 
 TEST_CASE("Linear congruential generators", "[algo][crypt]")
@@ -60,4 +62,49 @@ TEST_CASE("Linear congruential generators", "[algo][crypt]")
         REQUIRE(l.next() == 179);
         REQUIRE(l.next() == 38);
     }
+
+    SECTION("Bulk generation, skipping and XOR match single values")
+    {
+        const auto key = "0123456789abcdefghi"_b;
+        for (const auto kind : {
+            LcgKind::MicrosoftVisualC,
+            LcgKind::ParkMiller,
+            LcgKind::ParkMillerRevised})
+        for (const auto seed : {0u, 1u, 0x7FFFFFFFu, 0xDEADBEEFu})
+        {
+            INFO("Seed " << seed);
+            Lcg single(kind, seed);
+            std::vector<u32> expected;
+            for (const auto i : algo::range(1000))
+                expected.push_back(single.next());
+
+            Lcg bulk(kind, seed);
+            std::vector<u32> actual(1000);
+            bulk.fill(&actual[0], 10);
+            bulk.fill(&actual[10], 990);
+            REQUIRE(actual == expected);
+
+            for (const auto count : {0, 1, 2, 500, 999})
+            {
+                Lcg skipping(kind, seed);
+                skipping.discard(count);
+                REQUIRE(skipping.next() == expected[count]);
+            }
+
+            // long enough to take the lookup table path
+            bstr data(70000), expected_data(70000);
+            for (const auto i : algo::range(data.size()))
+                data[i] = expected_data[i] = i;
+            Lcg reference(kind, seed);
+            for (const auto i : algo::range(0, expected_data.size(), 2))
+                expected_data[i] ^= key[reference.next() % key.size()];
+            Lcg xoring(kind, seed);
+            xoring.xor_with_key(data.get<u8>(), data.size(), key, 2);
+            REQUIRE(data == expected_data);
+            xoring.xor_with_key(data.get<u8>(), 10, key);
+            for (const auto i : algo::range(10))
+                expected_data[i] ^= key[reference.next() % key.size()];
+            REQUIRE(data == expected_data);
+        }
+    }
 }
@@ -0,0 +1,72 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/crypt/mt.h"
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::algo::crypt;
+
+TEST_CASE("Mersenne Twister", "[algo][crypt]")
+{
+    SECTION("Reference output")
+    {
+        // values from the reference implementation of MT19937
+        auto mt = MersenneTwister::Improved(5489);
+        REQUIRE(mt->next_u32() == 3499211612);
+        REQUIRE(mt->next_u32() == 581869302);
+        REQUIRE(mt->next_u32() == 3890346734);
+        for (const auto i : algo::range(3, 9999))
+            mt->next_u32();
+        REQUIRE(mt->next_u32() == 4123659995);
+    }
+
+    SECTION("Bulk generation matches single values")
+    {
+        using Factory = std::unique_ptr<MersenneTwister>(*)(const u32);
+        for (const auto factory : std::vector<Factory>{
+            &MersenneTwister::Knuth,
+            &MersenneTwister::Classic,
+            &MersenneTwister::Improved})
+        for (const auto seed : {0u, 1u, 0xDEADBEEFu})
+        {
+            INFO("Seed " << seed);
+            auto single = factory(seed);
+            auto bulk = factory(seed);
+
+            // odd sizes so that the batches straddle the state regeneration
+            std::vector<u32> expected, actual(2000);
+            for (const auto i : algo::range(actual.size()))
+                expected.push_back(single->next_u32());
+            bulk->fill(&actual[0], 7);
+            bulk->fill(&actual[7], 1000);
+            bulk->fill(&actual[1007], 993);
+            REQUIRE(actual == expected);
+
+            bstr data(1500);
+            for (const auto i : algo::range(data.size()))
+                data[i] = i;
+            auto expected_data = data;
+            for (const auto i : algo::range(expected_data.size()))
+                expected_data[i] ^= single->next_u32();
+            bulk->xor_bytes(data.get<u8>(), 700);
+            bulk->xor_bytes(data.get<u8>() + 700, 800);
+            REQUIRE(data == expected_data);
+        }
+    }
+}
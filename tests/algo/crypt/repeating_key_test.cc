@@ -0,0 +1,98 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/crypt/repeating_key.h"
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::algo::crypt;
+
+static bstr get_test_data(const size_t size)
+{
+    bstr data(size);
+    for (const auto i : algo::range(size))
+        data[i] = i * 37 + (i >> 3);
+    return data;
+}
+
+TEST_CASE("Repeating key ciphers", "[algo][crypt]")
+{
+    SECTION("Known values")
+    {
+        const RepeatingKey key("\x01\x02\x03"_b);
+        auto data = "\x10\x20\x30\x40\x50\x60\x70\x80\x90\xA0"_b;
+        key.xor_data(data.get<u8>(), data.size());
+        REQUIRE(data == "\x11\x22\x33\x41\x52\x63\x71\x82\x93\xA1"_b);
+        key.sub_data(data.get<u8>(), data.size());
+        REQUIRE(data == "\x10\x20\x30\x40\x50\x60\x70\x80\x90\xA0"_b);
+    }
+
+    SECTION("Empty key")
+    {
+        REQUIRE_THROWS(RepeatingKey(""_b));
+    }
+
+    SECTION("Word-wise paths match byte-wise definitions")
+    {
+        for (const auto key_size : {1, 3, 4, 7, 8, 13, 16, 31})
+        for (const auto size : {0, 1, 5, 8, 15, 16, 17, 100, 1001})
+        {
+            INFO("Key size " << key_size << ", data size " << size);
+            bstr key_data(key_size);
+            for (const auto i : algo::range(key_size))
+                key_data[i] = 0xF0 - i * 11;
+            const RepeatingKey key(key_data);
+            const auto input = get_test_data(size);
+
+            for (const auto offset : {0, 1, 5, 40})
+            {
+                auto expected = input;
+                for (const auto i : algo::range(size))
+                    expected[i] ^= key_data[(i + offset) % key_size];
+                auto actual = input;
+                key.xor_data(actual.get<u8>(), actual.size(), offset);
+                REQUIRE(actual == expected);
+            }
+
+            {
+                auto expected = input;
+                for (const auto i : algo::range(size))
+                    expected[i] -= key_data[i % key_size];
+                auto actual = input;
+                key.sub_data(actual.get<u8>(), actual.size());
+                REQUIRE(actual == expected);
+            }
+
+            {
+                const auto iv = "\xA1\xB2\xC3\xD4"_b;
+                auto expected = input;
+                u8 aux[4] = {iv[0], iv[1], iv[2], iv[3]};
+                for (const auto i : algo::range(size))
+                {
+                    const auto tmp = expected[i];
+                    expected[i] ^= key_data[i % key_size] ^ aux[i & 3];
+                    aux[i & 3] = tmp;
+                }
+                auto actual = input;
+                key.xor_data_with_feedback(
+                    actual.get<u8>(), actual.size(), iv);
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/crypt/rsa.h"
+#include "err.h"
+#include "test_support/catch.h"
+#include "test_support/common.h"
+
+using namespace au;
+using namespace au::algo::crypt;
+
+static const RsaKey test_key =
+{
+    {
+        0xC2, 0xE2, 0x58, 0x6F, 0x3C, 0x36, 0x19, 0xC8,
+        0xBA, 0x80, 0x72, 0xB4, 0x72, 0x17, 0x48, 0xF9,
+        0x20, 0x75, 0xE0, 0xF4, 0x5A, 0xC4, 0x35, 0xC6,
+        0xC8, 0x01, 0x63, 0x01, 0xCE, 0x35, 0x6F, 0xEB,
+        0xF6, 0x61, 0xB0, 0x2E, 0x78, 0xD6, 0x21, 0x70,
+        0x8E, 0x43, 0x6C, 0x1C, 0x86, 0x4A, 0xC1, 0x59,
+        0x87, 0xAC, 0xFA, 0x49, 0xE5, 0xD6, 0xEA, 0x7B,
+        0xEE, 0x5B, 0x24, 0x0D, 0xCE, 0x77, 0x36, 0x59,
+    },
+    65537,
+};
+
+// PKCS#1 type 1 signatures of the messages made with the matching private key
+static const auto block1 =
+    "\xAF\xE6\xE4\x20\x32\xAB\x5C\x4A\x59\x90\x7A\xB0\x3B\xAD\xAA\x26"
+    "\xBB\xB3\xDC\x2E\xB7\x51\xDC\xD7\x23\x01\x37\x80\xC4\xDD\x4C\xFD"
+    "\x49\x3E\x43\x22\x5B\x41\xDD\xA9\xED\x34\x66\x1F\x31\xCD\x6F\x89"
+    "\x7A\x96\x08\x2F\x45\xB5\xED\xEC\x0A\x46\xB9\x93\x98\x74\x1E\x0A"_b;
+static const auto block2 =
+    "\x4D\x4B\x89\x67\x87\xFA\xE9\x9D\x97\x53\x0D\xF6\x8E\x9F\x9A\x4E"
+    "\x8E\x23\x97\xBE\x6C\xDE\xC7\x28\x78\xE5\x51\xB2\xF1\x3A\xC6\x56"
+    "\x11\x8B\x5A\x93\x99\x27\x98\x89\x47\x9A\x9D\x0C\x8C\xA3\xCC\x45"
+    "\xB5\xE6\xB6\xA5\x62\xE1\xF1\x72\xB8\x81\x98\x3F\x04\x17\x2D\x79"_b;
+
+TEST_CASE("RSA", "[algo][crypt]")
+{
+    const Rsa rsa(test_key);
+
+    SECTION("Single block")
+    {
+        const auto output = rsa.decrypt(block1);
+        REQUIRE(output.size() == 64);
+        tests::compare_binary(
+            output.substr(0, 32), "first block of table data......."_b);
+    }
+
+    SECTION("Multiple blocks")
+    {
+        const auto output = rsa.decrypt_blocks(block1 + block2, 0x20);
+        REQUIRE(output.size() == 0x40);
+        tests::compare_binary(
+            output.substr(0, 0x20), rsa.decrypt(block1).substr(0, 0x20));
+        tests::compare_binary(
+            output.substr(0x20), rsa.decrypt(block2).substr(0, 0x20));
+        tests::compare_binary(
+            output.substr(0x20), "second"_b + bstr(0x20 - 6));
+    }
+
+    SECTION("Truncated output")
+    {
+        const auto output = rsa.decrypt_blocks(block2 + block1, 4);
+        tests::compare_binary(output, "secofirs"_b);
+    }
+
+    SECTION("Bad padding")
+    {
+        auto corrupt = block1;
+        corrupt[10] ^= 1;
+        REQUIRE_THROWS_AS(rsa.decrypt(corrupt), err::CorruptDataError);
+        REQUIRE_THROWS_AS(
+            rsa.decrypt_blocks(block2 + corrupt, 0x20),
+            err::CorruptDataError);
+    }
+
+    SECTION("Misaligned input")
+    {
+        REQUIRE_THROWS_AS(
+            rsa.decrypt_blocks(block1 + "x"_b, 0x20), err::CorruptDataError);
+    }
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/glob.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("Glob patterns", "[algo]")
+{
+    SECTION("Literal patterns")
+    {
+        REQUIRE(algo::Glob("dir/file.txt").matches("dir/file.txt"));
+        REQUIRE(!algo::Glob("dir/file.txt").matches("dir/file.txt2"));
+        REQUIRE(!algo::Glob("dir/file.txt").matches("dir/file.tx"));
+        REQUIRE(!algo::Glob("dir/file.txt").matches("sub/dir/file.txt"));
+    }
+
+    SECTION("Patterns without a slash match file names")
+    {
+        REQUIRE(algo::Glob("*.png").matches("image.png"));
+        REQUIRE(algo::Glob("*.png").matches("dir/sub/image.png"));
+        REQUIRE(!algo::Glob("*.png").matches("dir.png/image.jpg"));
+        REQUIRE(algo::Glob("image.png").matches("dir/image.png"));
+    }
+
+    SECTION("Single stars don't cross directories")
+    {
+        REQUIRE(algo::Glob("bg/*").matches("bg/01.png"));
+        REQUIRE(!algo::Glob("bg/*").matches("bg/sub/01.png"));
+        REQUIRE(algo::Glob("*/*.png").matches("bg/01.png"));
+        REQUIRE(!algo::Glob("*/*.png").matches("01.png"));
+        REQUIRE(algo::Glob("bg/*a*b").matches("bg/xaxbxab"));
+    }
+
+    SECTION("Double stars cross directories")
+    {
+        REQUIRE(algo::Glob("bg/**").matches("bg/sub/01.png"));
+        REQUIRE(algo::Glob("bg/**.png").matches("bg/sub/01.png"));
+        REQUIRE(algo::Glob("**/01.png").matches("bg/sub/01.png"));
+        REQUIRE(algo::Glob("**/01.png").matches("01.png"));
+        REQUIRE(algo::Glob("bg/**/01.png").matches("bg/01.png"));
+        REQUIRE(!algo::Glob("bg/**/01.png").matches("bg/x01.png"));
+    }
+
+    SECTION("Question marks")
+    {
+        REQUIRE(algo::Glob("??.png").matches("01.png"));
+        REQUIRE(!algo::Glob("??.png").matches("1.png"));
+        REQUIRE(!algo::Glob("bg?01.png").matches("bg/01.png"));
+    }
+
+    SECTION("Case is ignored")
+    {
+        REQUIRE(algo::Glob("*.PNG").matches("BG/image.png"));
+        REQUIRE(algo::Glob("bg/*.png").matches("BG/IMAGE.PNG"));
+    }
+
+    SECTION("Leading slashes are ignored")
+    {
+        REQUIRE(algo::Glob("/bg/*").matches("bg/01.png"));
+        REQUIRE(algo::Glob("bg/*").matches("/bg/01.png"));
+    }
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/hash/crc.h"
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::algo::hash;
+
+static bstr get_test_data(const size_t size)
+{
+    bstr data(size);
+    for (const auto i : algo::range(size))
+        data[i] = (i * 0x9E) ^ (i >> 3);
+    return data;
+}
+
+TEST_CASE("CRC", "[algo][hash]")
+{
+    const auto check = "123456789"_b;
+
+    SECTION("Check values")
+    {
+        REQUIRE(crc16(check) == 0xFEE8);
+        REQUIRE(crc32(check) == 0xCBF43926);
+        REQUIRE(crc32_mpeg2(check) == 0x0376E6E7);
+        REQUIRE(crc64(check) == 0x62EC59E3F1A4F00A);
+    }
+
+    SECTION("Empty input")
+    {
+        REQUIRE(crc16(""_b) == 0);
+        REQUIRE(crc32(""_b) == 0);
+        REQUIRE(crc32_mpeg2(""_b) == 0xFFFFFFFF);
+        REQUIRE(crc64(""_b) == 0);
+    }
+
+    SECTION("Hashing in pieces")
+    {
+        // covers both the eight byte loop and the byte by byte tail
+        const auto data = get_test_data(100);
+        for (const auto split : {0, 1, 7, 8, 9, 50, 99, 100})
+        {
+            INFO("Split at " << split);
+            const auto head = data.substr(0, split);
+            const auto tail = data.substr(split);
+            REQUIRE(crc16(tail, crc16(head)) == crc16(data));
+            REQUIRE(crc32(tail, crc32(head)) == crc32(data));
+            REQUIRE(crc32_mpeg2(tail, crc32_mpeg2(head))
+                == crc32_mpeg2(data));
+            REQUIRE(crc64(tail, crc64(head)) == crc64(data));
+        }
+    }
+
+    SECTION("CRC-16 of data followed by its checksum is zero")
+    {
+        auto data = get_test_data(37);
+        const auto crc = crc16(data);
+        data += static_cast<u8>(crc >> 8);
+        data += static_cast<u8>(crc);
+        REQUIRE(crc16(data) == 0);
+    }
+}
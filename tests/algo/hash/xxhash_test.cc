@@ -15,34 +15,28 @@
 // You should have received a copy of the GNU General Public License
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
-#include "algo/crypt/crc32.h"
-#include "algo/range.h"
+#include "algo/hash/xxhash.h"
+#include "test_support/catch.h"
 
 using namespace au;
+using namespace au::algo::hash;
 
-static u32 reverse(u32 x)
+TEST_CASE("xxHash", "[algo][hash]")
 {
-    x = ((x & 0x55555555) << 1) | ((x >> 1) & 0x55555555);
-    x = ((x & 0x33333333) << 2) | ((x >> 2) & 0x33333333);
-    x = ((x & 0x0F0F0F0F) << 4) | ((x >> 4) & 0x0F0F0F0F);
-    x = (x << 24) | ((x & 0xFF00) << 8) | ((x >> 8) & 0xFF00) | (x >> 24);
-    return x;
-}
+    SECTION("Short input")
+    {
+        REQUIRE(xxhash64(""_b) == 0xEF46DB3751D8E999);
+        REQUIRE(xxhash64("abc"_b) == 0x44BC2CF5AD770999);
+    }
 
-u32 algo::crypt::crc32(const bstr &input)
-{
-    u32 crc = 0xFFFFFFFF;
-    for (const auto c : input)
+    SECTION("Input longer than one stripe")
+    {
+        REQUIRE(xxhash64("Nobody inspects the spammish repetition"_b)
+            == 0xFBCEA83C8A378BF1);
+    }
+
+    SECTION("Seed")
     {
-        u32 byte = reverse(c);
-        for (const auto j : algo::range(8))
-        {
-            if (static_cast<int>(crc ^ byte) < 0)
-                crc = (crc << 1) ^ 0x04C11DB7;
-            else
-                crc = crc << 1;
-            byte <<= 1;
-        }
+        REQUIRE(xxhash64("abc"_b, 1) == 0xBEA9CA8199328908);
     }
-    return reverse(~crc);
 }
@@ -0,0 +1,84 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/image/idct.h"
+#include <random>
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+static void fill_block(
+    std::mt19937 &generator, s16 *block, const size_t nonzero_rows)
+{
+    std::uniform_int_distribution<int> distribution(-1024, 1023);
+    for (const auto i : algo::range(64))
+        block[i] = i / 8 < static_cast<int>(nonzero_rows)
+            ? distribution(generator)
+            : 0;
+}
+
+TEST_CASE("Inverse DCT", "[algo][image]")
+{
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> quant_distribution(1, 255);
+    u8 quant_table[64];
+    for (const auto i : algo::range(64))
+        quant_table[i] = quant_distribution(generator);
+
+    SECTION("Floating point, DC only")
+    {
+        f32 multipliers[64];
+        for (const auto i : algo::range(64))
+            multipliers[i] = 1.0f;
+        s16 block[64] = {0};
+        u8 output[64];
+        block[0] = 80;
+        algo::image::idct_8x8_float(block, multipliers, output);
+        for (const auto i : algo::range(64))
+            REQUIRE(output[i] == 0x80 + 10);
+    }
+
+    SECTION("Floating point, optimized matches reference")
+    {
+        f32 multipliers[64];
+        algo::image::make_aan_multipliers(quant_table, multipliers);
+        for (const auto nonzero_rows : {1, 2, 8})
+        for (const auto repetition : algo::range(100))
+        {
+            s16 block[64];
+            u8 expected[64], actual[64];
+            fill_block(generator, block, nonzero_rows);
+            algo::image::idct_8x8_float_scalar(block, multipliers, expected);
+            algo::image::idct_8x8_float(block, multipliers, actual);
+            for (const auto i : algo::range(64))
+                REQUIRE(static_cast<int>(actual[i]) == expected[i]);
+        }
+    }
+
+    SECTION("Fixed point, DC only")
+    {
+        s16 quant[64];
+        for (const auto i : algo::range(64))
+            quant[i] = 2;
+        s16 block[64] = {0};
+        block[0] = 40;
+        algo::image::idct_8x8_int(block, quant);
+        for (const auto i : algo::range(64))
+            REQUIRE(block[i] == 10);
+    }
+}
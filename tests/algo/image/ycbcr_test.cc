@@ -0,0 +1,93 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "algo/image/ycbcr.h"
+#include <random>
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("YCbCr to BGR conversion", "[algo][image]")
+{
+    SECTION("Floating point, optimized matches reference")
+    {
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<int> distribution(0, 255);
+        for (const auto repetition : algo::range(100))
+        {
+            u8 y[64], cb[64], cr[64];
+            for (const auto i : algo::range(64))
+            {
+                y[i] = distribution(generator);
+                cb[i] = distribution(generator);
+                cr[i] = distribution(generator);
+            }
+            bstr expected(16 * 8 * 4, 0x55);
+            bstr actual(16 * 8 * 4, 0x55);
+            algo::image::ycbcr_to_bgr_8x8_float_scalar(
+                y, cb, cr, expected.get<u8>(), 16 * 4);
+            algo::image::ycbcr_to_bgr_8x8_float(
+                y, cb, cr, actual.get<u8>(), 16 * 4);
+            REQUIRE(actual == expected);
+        }
+    }
+
+    SECTION("Floating point, gray")
+    {
+        u8 y[64], cb[64], cr[64];
+        for (const auto i : algo::range(64))
+        {
+            y[i] = 100;
+            cb[i] = cr[i] = 128;
+        }
+        bstr output(8 * 8 * 4, 0xFF);
+        algo::image::ycbcr_to_bgr_8x8_float(
+            y, cb, cr, output.get<u8>(), 8 * 4);
+        for (const auto i : algo::range(64))
+        {
+            REQUIRE(output[i * 4 + 0] == 100);
+            REQUIRE(output[i * 4 + 1] == 100);
+            REQUIRE(output[i * 4 + 2] == 100);
+            REQUIRE(output[i * 4 + 3] == 0xFF);
+        }
+    }
+
+    SECTION("Fixed point 4:2:0, saturation")
+    {
+        s16 y[64], cb[64], cr[64];
+        for (const auto i : algo::range(64))
+        {
+            y[i] = i < 8 ? 200 : 0;
+            cb[i] = 0;
+            cr[i] = i == 0 ? -200 : 0;
+        }
+        bstr output(8 * 8 * 4, 0x00);
+        algo::image::ycbcr420_to_bgr_8x8_int(
+            y, cb, cr, output.get<u8>(), 8 * 4);
+        // first row is saturated by luma, except for red in the top left
+        // 2x2 group that is pulled down by Cr
+        REQUIRE(output[0] == 0xFF);
+        REQUIRE(output[1] == 0xFF);
+        REQUIRE(output[2] == 47);
+        REQUIRE(output[8 * 4 + 0] == 0x80);
+        REQUIRE(output[8 * 4 + 1] == 0xFF);
+        REQUIRE(output[8 * 4 + 2] == 0);
+        REQUIRE(output[2 * 8 * 4 + 0] == 0x80);
+        REQUIRE(output[2 * 8 * 4 + 2] == 0x80);
+    }
+}
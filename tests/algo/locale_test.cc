@@ -50,6 +50,90 @@ TEST_CASE("Converting text encoding", "[algo]")
     {
         tests::compare_binary(algo::utf8_to_sjis(utf8), sjis);
     }
+
+    SECTION("Converting SJIS with halfwidth katakana and ASCII")
+    {
+        // "abc" "ｱｲｳ" "123456789"
+        const auto input = "abc\xB1\xB2\xB3" "123456789"_b;
+        const auto expected =
+            "abc\xEF\xBD\xB1\xEF\xBD\xB2\xEF\xBD\xB3" "123456789"_b;
+        tests::compare_binary(algo::sjis_to_utf8(input), expected);
+        tests::compare_binary(algo::utf8_to_sjis(expected), input);
+    }
+
+    SECTION("Converting SJIS user-defined characters")
+    {
+        tests::compare_binary(
+            algo::sjis_to_utf8("\xF0\x40\xF9\xFC"_b),
+            "\xEE\x80\x80\xEE\x9D\x97"_b);
+        tests::compare_binary(
+            algo::utf8_to_sjis("\xEE\x80\x80\xEE\x9D\x97"_b),
+            "\xF0\x40\xF9\xFC"_b);
+    }
+
+    SECTION("Converting characters with several SJIS sequences")
+    {
+        // "ⅰ" is both at 0xEEEF and 0xFA40
+        tests::compare_binary(
+            algo::sjis_to_utf8("\xEE\xEF"_b), "\xE2\x85\xB0"_b);
+        tests::compare_binary(
+            algo::sjis_to_utf8("\xFA\x40"_b), "\xE2\x85\xB0"_b);
+        tests::compare_binary(
+            algo::utf8_to_sjis("\xE2\x85\xB0"_b), "\xFA\x40"_b);
+
+        // WAVE DASH maps to the same sequence as FULLWIDTH TILDE
+        tests::compare_binary(
+            algo::utf8_to_sjis("\xE3\x80\x9C"_b), "\x81\x60"_b);
+    }
+
+    SECTION("Converting UTF16 to UTF8 and back")
+    {
+        // "aあ😀"
+        const auto utf16 = "a\x00\x42\x30\x3D\xD8\x00\xDE"_b;
+        const auto utf8 = "a\xE3\x81\x82\xF0\x9F\x98\x80"_b;
+        tests::compare_binary(algo::utf16_to_utf8(utf16), utf8);
+        tests::compare_binary(algo::utf8_to_utf16(utf8), utf16);
+    }
+
+    SECTION("Converting empty strings")
+    {
+        tests::compare_binary(algo::sjis_to_utf8(""_b), ""_b);
+        tests::compare_binary(algo::utf8_to_sjis(""_b), ""_b);
+        tests::compare_binary(algo::utf16_to_utf8(""_b), ""_b);
+        tests::compare_binary(algo::utf8_to_utf16(""_b), ""_b);
+    }
+
+    SECTION("Invalid SJIS")
+    {
+        // truncated sequence
+        REQUIRE_THROWS(algo::sjis_to_utf8("abc\x82"_b));
+        // unassigned sequence
+        REQUIRE_THROWS(algo::sjis_to_utf8("\x85\x40"_b));
+        // lone byte
+        REQUIRE_THROWS(algo::sjis_to_utf8("\x80"_b));
+    }
+
+    SECTION("Invalid UTF16")
+    {
+        // odd size
+        REQUIRE_THROWS(algo::utf16_to_utf8("a\x00" "b"_b));
+        // lone high surrogate
+        REQUIRE_THROWS(algo::utf16_to_utf8("\x3D\xD8" "a\x00"_b));
+        // lone low surrogate
+        REQUIRE_THROWS(algo::utf16_to_utf8("\x00\xDE"_b));
+    }
+
+    SECTION("Invalid UTF8")
+    {
+        // overlong
+        REQUIRE_THROWS(algo::utf8_to_utf16("\xC0\xAF"_b));
+        // encoded surrogate
+        REQUIRE_THROWS(algo::utf8_to_utf16("\xED\xA0\x80"_b));
+        // truncated
+        REQUIRE_THROWS(algo::utf8_to_utf16("\xE3\x81"_b));
+        // not representable in SJIS
+        REQUIRE_THROWS(algo::utf8_to_sjis("\xF0\x9F\x98\x80"_b));
+    }
 }
 
 TEST_CASE("Normalizing SJIS strings", "[algo]")
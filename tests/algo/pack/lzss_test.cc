@@ -17,6 +17,7 @@
 
 #include "algo/pack/lzss.h"
 #include "algo/range.h"
+#include "io/msb_bit_stream.h"
 #include "test_support/catch.h"
 #include "test_support/common.h"
 
@@ -106,6 +107,28 @@ TEST_CASE("LZSS unpacking", "[algo][pack]")
         test_bytes("\x07\x61\x61\x61\xEE\xF0\xEE\xF3\xEE\xF9\xEE\xFC'"_b, 39);
         test_bytes("\x07\x61\x61\x61\xEE\xF0\xEE\xF3\xEE\xF9\xEE\xFD'"_b, 40);
     }
+
+    SECTION("Bytewise, reading from initial dictionary")
+    {
+        test_bytes("\x00\xEE\xF0"_b, "\x00\x00\x00"_b);
+        test_bytes("\x01\x61\xED\xF0"_b, "a\x00""a\x00"_b);
+    }
+
+    SECTION("Bytewise, truncated input")
+    {
+        test_bytes("\x07""12"_b, "12\x00\x00\x00"_b);
+        test_bytes("\x07""123\xEE"_b, "123\x00\x00\x00"_b);
+    }
+
+    SECTION("Bitwise, truncated input")
+    {
+        BitwiseLzssSettings settings;
+        settings.position_bits = 12;
+        settings.size_bits = 4;
+        settings.min_match_size = 3;
+        settings.initial_dictionary_pos = 0xFEE;
+        REQUIRE_THROWS(lzss_decompress("\xBAYnw"_b, 9, settings));
+    }
 }
 
 TEST_CASE("LZSS packing", "[algo][pack]")
@@ -132,6 +155,30 @@ TEST_CASE("LZSS packing", "[algo][pack]")
             input);
     }
 
+    SECTION("Bitwise, long matches")
+    {
+        bstr input;
+        for (const auto i : algo::range(2000))
+            input += static_cast<u8>((i * 7) % 61 + (i / 300) * 3);
+        input += input.substr(100, 500);
+        input += bstr(300, 'x');
+
+        BitwiseLzssSettings settings;
+        settings.position_bits = 12;
+        settings.size_bits = 8;
+        settings.initial_dictionary_pos = 0;
+        settings.min_match_size = 2;
+        const auto x = lzss_compress(input, settings);
+        tests::compare_binary(
+            lzss_decompress(x, input.size(), settings),
+            input);
+
+        io::MsbBitStream input_stream(x);
+        tests::compare_binary(
+            lzss_decompress(input_stream, input.size(), settings),
+            input);
+    }
+
     SECTION("Bytewise")
     {
         const auto input =
@@ -150,4 +197,42 @@ TEST_CASE("LZSS packing", "[algo][pack]")
             lzss_decompress(x, input.size(), settings),
             input);
     }
+
+    SECTION("Compression levels")
+    {
+        bstr input;
+        for (const auto i : algo::range(5000))
+            input += static_cast<u8>((i * i) % 251 < 40 ? 0 : 'a' + i % 13);
+
+        BitwiseLzssSettings settings;
+        settings.position_bits = 12;
+        settings.size_bits = 4;
+        settings.initial_dictionary_pos = 0xFEE;
+        settings.min_match_size = 3;
+
+        for (const auto level :
+            {
+                CompressionLevel::Best,
+                CompressionLevel::Good,
+                CompressionLevel::Fast,
+                CompressionLevel::Store,
+            })
+        {
+            const auto x = lzss_compress(input, settings, level);
+            tests::compare_binary(
+                lzss_decompress(x, input.size(), settings),
+                input);
+
+            const auto y = lzss_compress(
+                input, BytewiseLzssSettings(), level);
+            tests::compare_binary(
+                lzss_decompress(y, input.size()),
+                input);
+
+            if (level == CompressionLevel::Store)
+                REQUIRE(y.size() == input.size() + input.size() / 8);
+            else
+                REQUIRE(y.size() < input.size() / 2);
+        }
+    }
 }
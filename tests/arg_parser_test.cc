@@ -104,6 +104,17 @@ TEST_CASE("ArgParser", "[core]")
         REQUIRE(ap.get_switch("--long") == "long2");
     }
 
+    SECTION("All values of repeated switches are retained")
+    {
+        ArgParser ap;
+        ap.register_switch({"-s", "--long"});
+        ap.register_switch({"--other"});
+        ap.parse(std::vector<std::string>{"-s=1", "--long=2", "-s=3"});
+        REQUIRE(ap.get_switch_values("-s")
+            == std::vector<std::string>({"1", "2", "3"}));
+        REQUIRE(ap.get_switch_values("--other").empty());
+    }
+
     SECTION("Switches with values containing spaces")
     {
         ArgParser ap;
@@ -16,6 +16,8 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "flow/cli_facade.h"
+#include "err.h"
+#include "io/file.h"
 #include "io/file_system.h"
 #include "test_support/catch.h"
 
@@ -60,4 +62,58 @@ TEST_CASE("CLI facade", "[core]")
         io::remove("./xp3-v2~.xp3/123.txt");
         io::remove("./xp3-v2~.xp3");
     }
+
+    SECTION("Rejecting queue breadths below 1")
+    {
+        REQUIRE_THROWS_AS(
+            flow::CliFacade(logger, {"./tests", "--breadth=0"}),
+            err::UsageError);
+        REQUIRE_THROWS_AS(
+            flow::CliFacade(logger, {"./tests", "--breadth=-1"}),
+            err::UsageError);
+    }
+
+    SECTION("Rejecting negative save thread counts")
+    {
+        REQUIRE_THROWS_AS(
+            flow::CliFacade(logger, {"./tests", "--save-threads=-1"}),
+            err::UsageError);
+    }
+
+    SECTION("Saving into an archive inside the input directory")
+    {
+        io::create_directories("./tests/trash");
+        {
+            io::File input_file(
+                "./tests/dec/kirikiri/files/xp3/xp3-v2.xp3",
+                io::FileMode::Read);
+            io::File output_file(
+                "./tests/trash/xp3-v2.xp3", io::FileMode::Write);
+            output_file.stream.write(input_file.stream.read_to_eof());
+        }
+
+        const flow::CliFacade cli_facade(
+            logger,
+            {
+                "./tests/trash",
+                "--out-archive=./tests/trash/out.tar",
+                "--dec=kirikiri/xp3",
+                "--plugin=noop"
+            });
+
+        // the second run must skip the archive left by the first one
+        REQUIRE(cli_facade.run() == 0);
+        REQUIRE(cli_facade.run() == 0);
+
+        {
+            io::File output_file("./tests/trash/out.tar", io::FileMode::Read);
+            const auto content = output_file.stream.read_to_eof();
+            REQUIRE(content.find("xp3-v2~.xp3/123.txt"_b) != bstr::npos);
+            REQUIRE(content.find("out~.tar"_b) == bstr::npos);
+        }
+
+        io::remove("./tests/trash/out.tar");
+        io::remove("./tests/trash/xp3-v2.xp3");
+        io::remove("./tests/trash");
+    }
 }
@@ -229,3 +229,36 @@ TEST_CASE("Archive files get proper fallback names", "[dec]")
         test_naming_strategy<algo::NamingStrategy::Sibling>("test");
     }
 }
+
+TEST_CASE("Archive entries created in the meta's arena", "[dec]")
+{
+    struct CountingArchiveEntry final : ArchiveEntry
+    {
+        ~CountingArchiveEntry()
+        {
+            (*counter)++;
+        }
+
+        int *counter;
+    };
+
+    int destroyed = 0;
+    {
+        ArchiveMeta meta;
+        for (const auto i : algo::range(100))
+        {
+            auto entry = meta.create_entry<CountingArchiveEntry>();
+            entry->path = algo::format("file %d with a long name", i);
+            entry->counter = &destroyed;
+            meta.entries.push_back(std::move(entry));
+        }
+        auto entry = std::make_unique<CountingArchiveEntry>();
+        entry->counter = &destroyed;
+        meta.entries.push_back(std::move(entry));
+
+        REQUIRE(meta.entries.size() == 101);
+        tests::compare_paths(
+            meta.entries[99]->path, "file 99 with a long name");
+    }
+    REQUIRE(destroyed == 101);
+}
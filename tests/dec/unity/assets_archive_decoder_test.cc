@@ -0,0 +1,134 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "dec/unity/assets_archive_decoder.h"
+#include "algo/range.h"
+#include "test_support/catch.h"
+#include "test_support/decoder_support.h"
+#include "test_support/file_support.h"
+#include "test_support/image_support.h"
+#include "virtual_file_system.h"
+
+using namespace au;
+using namespace au::dec::unity;
+
+static const std::string dir = "tests/dec/unity/files/";
+
+static res::Image get_rgba_image()
+{
+    // stored bottom-up, one byte counter for every channel
+    res::Image image(4, 2);
+    for (const auto y : algo::range(2))
+    for (const auto x : algo::range(4))
+    {
+        const auto i = ((1 - y) * 4 + x) * 4;
+        image.at(x, y) = {
+            static_cast<u8>(i + 2),
+            static_cast<u8>(i + 1),
+            static_cast<u8>(i + 0),
+            static_cast<u8>(i + 3)};
+    }
+    return image;
+}
+
+static res::Image get_etc_image()
+{
+    res::Image image(4, 4);
+    for (const auto y : algo::range(4))
+    for (const auto x : algo::range(4))
+    {
+        const u8 value = x < 2 ? 138 : 70;
+        image.at(x, y) = {value, value, value, 0xFF};
+    }
+    image.at(0, 3) = {128, 128, 128, 0xFF};
+    image.at(1, 2) = {144, 144, 144, 0xFF};
+    image.at(3, 3) = {66, 66, 66, 0xFF};
+    return image;
+}
+
+TEST_CASE("Unity assets", "[dec]")
+{
+    const auto decoder = AssetsArchiveDecoder();
+    const auto input_file = tests::file_from_path(dir + "test.assets");
+    const auto actual_files = tests::unpack(decoder, *input_file);
+    REQUIRE(actual_files.size() == 4);
+
+    SECTION("Textures")
+    {
+        REQUIRE(actual_files[0]->path.str() == "rgba.png");
+        tests::compare_images(*actual_files[0], get_rgba_image());
+        REQUIRE(actual_files[3]->path.str() == "etc.png");
+        tests::compare_images(*actual_files[3], get_etc_image());
+    }
+
+    SECTION("Text assets")
+    {
+        const auto expected_file = tests::stub_file(
+            "readme.txt", "hello world"_b);
+        tests::compare_files(*actual_files[1], *expected_file, true);
+    }
+
+    SECTION("Other named objects")
+    {
+        REQUIRE(actual_files[2]->path.str() == "Player");
+        actual_files[2]->stream.seek(0);
+        REQUIRE(actual_files[2]->stream.size() == 48);
+    }
+}
+
+TEST_CASE("Unity assets with unsupported type trees", "[dec]")
+{
+    // the GameObject tree has a 3-byte leaf; such objects must stay raw
+    // without breaking the rest of the file
+    const auto decoder = AssetsArchiveDecoder();
+    const auto input_file = tests::file_from_path(dir + "odd-field.assets");
+    const auto actual_files = tests::unpack(decoder, *input_file);
+    REQUIRE(actual_files.size() == 2);
+
+    const auto expected_file = tests::stub_file(
+        "readme.txt", "hello world"_b);
+    tests::compare_files(*actual_files[0], *expected_file, true);
+
+    actual_files[1]->stream.seek(0);
+    REQUIRE(actual_files[1]->stream.read_to_eof()
+        == "\x07\x00\x00\x00rgb\x00\x03\x00\x00\x00Odd\x00"_b);
+}
+
+TEST_CASE("Unity assets with external data from another archive", "[dec]")
+{
+    // the .resS file only exists as an entry of the enclosing archive
+    const auto resource_path = dir + "CAB-test.resS";
+    VirtualFileSystem::register_file(
+        resource_path,
+        []()
+        {
+            bstr pixels(32);
+            for (const auto i : algo::range(pixels.size()))
+                pixels[i] = i;
+            return tests::stub_file("CAB-test.resS", "padding!"_b + pixels);
+        });
+
+    const auto decoder = AssetsArchiveDecoder();
+    const auto input_file = tests::file_from_path(
+        dir + "external-texture.assets");
+    const auto actual_files = tests::unpack(decoder, *input_file);
+    VirtualFileSystem::unregister_file(resource_path);
+
+    REQUIRE(actual_files.size() == 1);
+    REQUIRE(actual_files[0]->path.str() == "external.png");
+    tests::compare_images(*actual_files[0], get_rgba_image());
+}
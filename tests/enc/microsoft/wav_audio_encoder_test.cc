@@ -0,0 +1,78 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "enc/microsoft/wav_audio_encoder.h"
+#include "algo/range.h"
+#include "dec/microsoft/wav_audio_decoder.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/audio_support.h"
+#include "test_support/catch.h"
+#include "test_support/common.h"
+
+using namespace au;
+using namespace au::enc::microsoft;
+
+static bstr encode_streamed(const res::Audio &audio, const size_t chunk_size)
+{
+    io::MemoryByteStream output_stream;
+    WavAudioStreamWriter writer(output_stream);
+    writer.begin(audio);
+    for (size_t pos = 0; pos < audio.samples.size(); pos += chunk_size)
+        writer.write(audio.samples.substr(pos, chunk_size));
+    writer.finish();
+    return output_stream.seek(0).read_to_eof();
+}
+
+TEST_CASE("Microsoft WAV audio encoding", "[enc]")
+{
+    Logger dummy_logger;
+    dummy_logger.mute();
+    const auto wav_encoder = WavAudioEncoder();
+    const auto wav_decoder = dec::microsoft::WavAudioDecoder();
+
+    SECTION("Plain audio")
+    {
+        const auto input_audio = tests::get_test_audio();
+        const auto output_file
+            = wav_encoder.encode(dummy_logger, input_audio, "test.dat");
+        REQUIRE(output_file->path.name() == "test.wav");
+        const auto output_audio
+            = wav_decoder.decode(dummy_logger, *output_file);
+        tests::compare_audio(output_audio, input_audio);
+    }
+
+    SECTION("Looped audio")
+    {
+        auto input_audio = tests::get_test_audio();
+        input_audio.loops.push_back(res::AudioLoopInfo {1, 2, 0});
+        const auto output_file
+            = wav_encoder.encode(dummy_logger, input_audio, "test.dat");
+        REQUIRE(output_file->path.name() == "test.wavloop");
+    }
+
+    SECTION("Streamed output matches whole track output")
+    {
+        auto input_audio = tests::get_test_audio();
+        input_audio.loops.push_back(res::AudioLoopInfo {1, 2, 0});
+        const auto expected_file
+            = wav_encoder.encode(dummy_logger, input_audio, "test.dat");
+        const auto expected = expected_file->stream.seek(0).read_to_eof();
+        for (const auto chunk_size : {1, 1000, 0x10000})
+            tests::compare_binary(
+                encode_streamed(input_audio, chunk_size), expected);
+    }
+}
@@ -0,0 +1,311 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "flow/file_saver_archive.h"
+#include "algo/format.h"
+#include "algo/hash/crc.h"
+#include "algo/range.h"
+#include "algo/str.h"
+#include "err.h"
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+namespace
+{
+    struct SavedEntry final
+    {
+        std::string name;
+        bstr content;
+    };
+}
+
+static std::vector<SavedEntry> read_tar(const bstr &input)
+{
+    std::vector<SavedEntry> entries;
+    io::MemoryByteStream input_stream(input);
+    std::string long_name;
+    while (true)
+    {
+        const auto header = input_stream.read(512);
+        if (header == bstr(512))
+            break;
+
+        u32 checksum = 0;
+        for (const auto i : algo::range(512))
+            checksum += i >= 148 && i < 156 ? ' ' : header[i];
+        REQUIRE(std::stoul(header.substr(148, 7).str(), nullptr, 8)
+            == checksum);
+        REQUIRE(header.substr(257, 6) == "ustar\x00"_b);
+
+        const auto size = std::stoull(header.substr(124, 11).str(), nullptr, 8);
+        const auto content = input_stream.read(size);
+        input_stream.skip((512 - size % 512) % 512);
+        if (header[156] == 'x')
+        {
+            const auto record = content.str();
+            const auto pos = record.find(" path=");
+            REQUIRE(pos != std::string::npos);
+            REQUIRE(std::stoul(record) == record.size());
+            long_name = record.substr(pos + 6, record.size() - pos - 7);
+            continue;
+        }
+
+        REQUIRE(header[156] == '0');
+        const auto name = long_name.empty()
+            ? algo::trim_to_zero(header.substr(0, 100).str())
+            : long_name;
+        long_name.clear();
+        entries.push_back({name, content});
+    }
+    REQUIRE(input_stream.read(512) == bstr(512));
+    REQUIRE(!input_stream.left());
+    return entries;
+}
+
+static std::vector<SavedEntry> read_zip(const bstr &input)
+{
+    std::vector<SavedEntry> entries;
+    io::MemoryByteStream input_stream(input);
+
+    input_stream.seek(input.size() - 22);
+    REQUIRE(input_stream.read_le<u32>() == 0x06054B50);
+    input_stream.skip(4);
+    uoff_t count = input_stream.read_le<u16>();
+    input_stream.skip(2);
+    input_stream.skip(4);
+    uoff_t directory_offset = input_stream.read_le<u32>();
+    if (count == 0xFFFF)
+    {
+        input_stream.seek(input.size() - 22 - 20);
+        REQUIRE(input_stream.read_le<u32>() == 0x07064B50);
+        input_stream.skip(4);
+        input_stream.seek(input_stream.read_le<u64>());
+        REQUIRE(input_stream.read_le<u32>() == 0x06064B50);
+        input_stream.skip(8 + 2 + 2 + 4 + 4 + 8);
+        count = input_stream.read_le<u64>();
+        input_stream.skip(8);
+        directory_offset = input_stream.read_le<u64>();
+    }
+
+    input_stream.seek(directory_offset);
+    for (const auto i : algo::range(count))
+    {
+        REQUIRE(input_stream.read_le<u32>() == 0x02014B50);
+        input_stream.skip(2 + 2 + 2);
+        REQUIRE(input_stream.read_le<u16>() == 0);
+        input_stream.skip(2 + 2);
+        const auto crc = input_stream.read_le<u32>();
+        const auto size = input_stream.read_le<u32>();
+        REQUIRE(input_stream.read_le<u32>() == size);
+        const auto name_size = input_stream.read_le<u16>();
+        const auto extra_size = input_stream.read_le<u16>();
+        input_stream.skip(2 + 2 + 2 + 4);
+        const auto offset = input_stream.read_le<u32>();
+        const auto name = input_stream.read(name_size).str();
+        input_stream.skip(extra_size);
+
+        const auto directory_pos = input_stream.pos();
+        input_stream.seek(offset);
+        REQUIRE(input_stream.read_le<u32>() == 0x04034B50);
+        input_stream.skip(22);
+        REQUIRE(input_stream.read_le<u16>() == name_size);
+        const auto local_extra_size = input_stream.read_le<u16>();
+        REQUIRE(input_stream.read(name_size).str() == name);
+        input_stream.skip(local_extra_size);
+        const auto content = input_stream.read(size);
+        REQUIRE(algo::hash::crc32(content) == crc);
+        input_stream.seek(directory_pos);
+
+        entries.push_back({name, content});
+    }
+    REQUIRE(input_stream.read_le<u32>()
+        == (count >= 0xFFFF ? 0x06064B50 : 0x06054B50));
+    return entries;
+}
+
+static bstr read_archive(const io::path &path)
+{
+    bstr content;
+    {
+        io::FileByteStream input_stream(path, io::FileMode::Read);
+        content = input_stream.read_to_eof();
+    }
+    io::remove(path);
+    return content;
+}
+
+static std::vector<SavedEntry> save_and_read(
+    const flow::ArchiveFormat format,
+    const std::vector<SavedEntry> &input_entries,
+    std::vector<io::path> &output_paths)
+{
+    const io::path path = format == flow::ArchiveFormat::Zip
+        ? "test.zip"
+        : "test.tar";
+    {
+        flow::FileSaverArchive file_saver(path, format);
+        for (const auto &entry : input_entries)
+        {
+            output_paths.push_back(file_saver.save(
+                std::make_shared<io::File>(entry.name, entry.content)));
+        }
+        file_saver.finish();
+        REQUIRE(file_saver.get_saved_file_count() == input_entries.size());
+    }
+    const auto content = read_archive(path);
+    return format == flow::ArchiveFormat::Zip
+        ? read_zip(content)
+        : read_tar(content);
+}
+
+static void test_names_and_order(const flow::ArchiveFormat format)
+{
+    const std::string long_name
+        = "dir/" + std::string(120, 'x') + u8"/不用意な変換.txt";
+    std::vector<io::path> output_paths;
+    const auto entries = save_and_read(
+        format,
+        {
+            {"a.txt", "first"_b},
+            {"dir/empty.bin", ""_b},
+            {"a.txt", "second"_b},
+            {"../../evil/./b.txt", bstr(1000, 0x55)},
+            {long_name, "long"_b},
+        },
+        output_paths);
+
+    REQUIRE(entries.size() == 5);
+    REQUIRE(entries[0].name == "a.txt");
+    REQUIRE(entries[0].content == "first"_b);
+    REQUIRE(entries[1].name == "dir/empty.bin");
+    REQUIRE(entries[1].content == ""_b);
+    REQUIRE(entries[2].name == "a(1).txt");
+    REQUIRE(entries[2].content == "second"_b);
+    REQUIRE(entries[3].name == "evil/b.txt");
+    REQUIRE(entries[3].content == bstr(1000, 0x55));
+    REQUIRE(entries[4].name == long_name);
+    REQUIRE(entries[4].content == "long"_b);
+    REQUIRE(output_paths[2].name() == "a(1).txt");
+}
+
+static void test_streams(const flow::ArchiveFormat format)
+{
+    const io::path source_path = "test-source.dat";
+    bstr source_content(3 * 1024 * 1024);
+    for (const auto i : algo::range(source_content.size()))
+        source_content[i] = i * 7;
+    {
+        io::FileByteStream stream(source_path, io::FileMode::Write);
+        stream.write(source_content);
+    }
+
+    const io::path path = format == flow::ArchiveFormat::Zip
+        ? "test.zip"
+        : "test.tar";
+    {
+        // finished by the destructor
+        flow::FileSaverArchive file_saver(path, format);
+        file_saver.save(
+            [](io::BaseByteStream &output_stream)
+            {
+                output_stream.write("streamed"_b);
+                return io::path("streamed.txt");
+            });
+        file_saver.save(std::make_shared<io::File>(
+            "view.dat",
+            std::make_unique<io::FileByteStream>(
+                source_path, io::FileMode::Read)));
+    }
+    io::remove(source_path);
+
+    const auto content = read_archive(path);
+    const auto entries = format == flow::ArchiveFormat::Zip
+        ? read_zip(content)
+        : read_tar(content);
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].name == "streamed.txt");
+    REQUIRE(entries[0].content == "streamed"_b);
+    REQUIRE(entries[1].name == "view.dat");
+    REQUIRE(entries[1].content == source_content);
+}
+
+static void test_write_failures(const flow::ArchiveFormat format)
+{
+    // every write to /dev/full fails
+    flow::FileSaverArchive file_saver("/dev/full", format);
+    file_saver.save(std::make_shared<io::File>("small.txt", "small"_b));
+    REQUIRE(file_saver.get_saved_file_count() == 0);
+
+    REQUIRE_THROWS_AS(
+        file_saver.save(std::make_shared<io::File>(
+            "big.dat", bstr(5 * 1024 * 1024))),
+        err::IoError);
+    REQUIRE_THROWS_AS(
+        file_saver.save(std::make_shared<io::File>("next.txt", "next"_b)),
+        err::IoError);
+    REQUIRE_THROWS_AS(file_saver.finish(), err::IoError);
+    REQUIRE(file_saver.get_saved_file_count() == 0);
+}
+
+TEST_CASE("FileSaverArchive", "[flow]")
+{
+    SECTION("Archive format is guessed from the extension")
+    {
+        REQUIRE(flow::FileSaverArchive::guess_format("a/b.zip")
+            == flow::ArchiveFormat::Zip);
+        REQUIRE(flow::FileSaverArchive::guess_format("a/b.tar")
+            == flow::ArchiveFormat::Tar);
+    }
+
+    SECTION("Files are stored in order under unique relative names")
+    {
+        test_names_and_order(flow::ArchiveFormat::Tar);
+        test_names_and_order(flow::ArchiveFormat::Zip);
+    }
+
+    SECTION("Streamed writes and views of other files")
+    {
+        test_streams(flow::ArchiveFormat::Tar);
+        test_streams(flow::ArchiveFormat::Zip);
+    }
+
+    #ifdef __linux__
+        SECTION("Failed writes stop the archive from taking more files")
+        {
+            test_write_failures(flow::ArchiveFormat::Tar);
+            test_write_failures(flow::ArchiveFormat::Zip);
+        }
+    #endif
+}
+
+TEST_CASE("FileSaverArchive with more files than plain zip can hold", "[flow]")
+{
+    std::vector<SavedEntry> input_entries;
+    for (const auto i : algo::range(70000))
+        input_entries.push_back({algo::format("%d", i), bstr(1, i)});
+    std::vector<io::path> output_paths;
+    const auto entries = save_and_read(
+        flow::ArchiveFormat::Zip, input_entries, output_paths);
+    REQUIRE(entries.size() == 70000);
+    REQUIRE(entries[69999].name == "69999");
+    REQUIRE(entries[69999].content == bstr(1, 69999 & 0xFF));
+}
@@ -16,7 +16,12 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "flow/file_saver_hdd.h"
+#include <functional>
+#include "algo/range.h"
+#include "err.h"
+#include "io/file_range.h"
 #include "io/file_system.h"
+#include "io/slice_byte_stream.h"
 #include "test_support/catch.h"
 
 using namespace au;
@@ -65,6 +70,97 @@ static void do_test_overwriting(
     }
 }
 
+static void do_test_streaming(const io::path &path)
+{
+    const flow::FileSaverHdd file_saver(".", true);
+
+    const auto full_path = file_saver.save(
+        [&](io::BaseByteStream &output_stream)
+        {
+            output_stream.write("test"_b);
+            return path;
+        });
+
+    REQUIRE(full_path == io::path(".") / path);
+    REQUIRE(io::exists(path));
+    {
+        io::FileByteStream file_stream(path, io::FileMode::Read);
+        REQUIRE(file_stream.read_to_eof() == "test"_b);
+    }
+    io::remove(path);
+}
+
+static void do_test_file_range(const bstr &content, const uoff_t offset)
+{
+    const io::path source_path = "test-source.dat";
+    const io::path path = "test.out";
+    {
+        io::FileByteStream source_stream(source_path, io::FileMode::Write);
+        source_stream.write(content);
+    }
+
+    try
+    {
+        io::File source_file(source_path, io::FileMode::Read);
+        const auto size = content.size() - offset - 1;
+        const auto file = std::make_shared<io::File>(
+            path,
+            std::make_unique<io::SliceByteStream>(
+                source_file.stream, offset, size));
+        REQUIRE(io::get_file_range(file->stream));
+
+        const flow::FileSaverHdd file_saver(".", true);
+        file_saver.save(file);
+        {
+            io::FileByteStream file_stream(path, io::FileMode::Read);
+            REQUIRE(file_stream.read_to_eof() == content.substr(offset, size));
+        }
+        io::remove(path);
+        io::remove(source_path);
+    }
+    catch (...)
+    {
+        if (io::exists(path)) io::remove(path);
+        io::remove(source_path);
+        throw;
+    }
+}
+
+// A file that appears after the saver listed its directory must survive
+// whatever way the next file with the same name gets saved.
+static void do_test_late_files(
+    const std::function<io::path(
+        const flow::IFileSaver &, const io::path &)> save)
+{
+    const io::path path = "test.txt";
+    const io::path path2 = "test(1).txt";
+    const io::path path3 = "test(2).txt";
+    const auto cleanup = [&]()
+    {
+        for (const auto &p : {path, path2, path3})
+            if (io::exists(p)) io::remove(p);
+    };
+    const flow::FileSaverHdd file_saver(".", false);
+    try
+    {
+        file_saver.save(std::make_shared<io::File>(path, "1"_b));
+        {
+            io::FileByteStream stream(path2, io::FileMode::Write);
+            stream.write("2"_b);
+        }
+        const auto full_path = save(file_saver, path);
+        REQUIRE(full_path == io::path(".") / path3);
+        io::FileByteStream stream(path2, io::FileMode::Read);
+        REQUIRE(stream.read_to_eof() == "2"_b);
+    }
+    catch (...)
+    {
+        cleanup();
+        throw;
+    }
+    cleanup();
+}
+
 TEST_CASE("FileSaver", "[core]")
 {
     SECTION("Unicode file names")
@@ -74,6 +170,34 @@ TEST_CASE("FileSaver", "[core]")
         do_test(u8"不用意な変換.out");
     }
 
+    SECTION("Streamed writes")
+    {
+        do_test_streaming("test.out");
+        do_test_streaming(u8"不用意な変換.out");
+    }
+
+    SECTION("Failed streamed writes leave nothing behind")
+    {
+        const flow::FileSaverHdd file_saver(".", true);
+        REQUIRE_THROWS(file_saver.save(
+            [](io::BaseByteStream &output_stream) -> io::path
+            {
+                output_stream.write("test"_b);
+                throw err::CorruptDataError("test");
+            }));
+        REQUIRE(!io::exists(".au-0.part"));
+        REQUIRE(file_saver.get_saved_file_count() == 0);
+    }
+
+    SECTION("Views of other files")
+    {
+        do_test_file_range("0123456789"_b, 3);
+        bstr content(3 * 1024 * 1024 + 5);
+        for (const auto i : algo::range(content.size()))
+            content[i] = i * 7;
+        do_test_file_range(content, 12345);
+    }
+
     SECTION("Two file savers overwrite the same file")
     {
         const flow::FileSaverHdd file_saver1(".", true);
@@ -95,4 +219,70 @@ TEST_CASE("FileSaver", "[core]")
         const flow::FileSaverHdd file_saver(".", true);
         do_test_overwriting(file_saver, file_saver, true);
     }
+
+    SECTION("File saver doesn't overwrite files created after it looked")
+    {
+        do_test_late_files(
+            [](const flow::IFileSaver &file_saver, const io::path &path)
+            {
+                return file_saver.save(
+                    std::make_shared<io::File>(path, "3"_b));
+            });
+    }
+
+    SECTION("Big files don't overwrite files created after it looked")
+    {
+        do_test_late_files(
+            [](const flow::IFileSaver &file_saver, const io::path &path)
+            {
+                return file_saver.save(
+                    std::make_shared<io::File>(path, bstr(2 * 1024 * 1024)));
+            });
+    }
+
+    SECTION("Streamed writes don't overwrite files created after it looked")
+    {
+        do_test_late_files(
+            [](const flow::IFileSaver &file_saver, const io::path &path)
+            {
+                return file_saver.save(
+                    [&](io::BaseByteStream &output_stream)
+                    {
+                        output_stream.write("3"_b);
+                        return path;
+                    });
+            });
+    }
+
+    SECTION("Files in new and existing subdirectories")
+    {
+        const io::path dir = "test-dir";
+        io::create_directories(dir / "old");
+        {
+            io::FileByteStream stream(dir / "old/a.txt", io::FileMode::Write);
+            stream.write("old"_b);
+        }
+        try
+        {
+            const flow::FileSaverHdd file_saver(dir, false);
+            for (const auto &name : {"old/a.txt", "new/a.txt", "new/a.txt"})
+                file_saver.save(std::make_shared<io::File>(name, "new"_b));
+            REQUIRE(file_saver.get_saved_file_count() == 3);
+            for (const auto &name
+                : {"old/a(1).txt", "new/a.txt", "new/a(1).txt"})
+            {
+                INFO(name);
+                io::FileByteStream stream(dir / name, io::FileMode::Read);
+                REQUIRE(stream.read_to_eof() == "new"_b);
+            }
+            io::FileByteStream stream(dir / "old/a.txt", io::FileMode::Read);
+            REQUIRE(stream.read_to_eof() == "old"_b);
+        }
+        catch (...)
+        {
+            boost::filesystem::remove_all(dir.str());
+            throw;
+        }
+        boost::filesystem::remove_all(dir.str());
+    }
 }
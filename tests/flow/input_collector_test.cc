@@ -0,0 +1,155 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/input_collector.h"
+#include <algorithm>
+#include "io/file_byte_stream.h"
+#include "io/file_system.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+namespace
+{
+    class TemporaryTree final
+    {
+    public:
+        TemporaryTree(const std::vector<std::pair<io::path, size_t>> &files);
+        ~TemporaryTree();
+
+    private:
+        std::vector<io::path> files;
+        std::vector<io::path> directories;
+    };
+}
+
+TemporaryTree::TemporaryTree(
+    const std::vector<std::pair<io::path, size_t>> &files)
+{
+    for (const auto &kv : files)
+    {
+        auto dir = kv.first.parent();
+        while (!dir.str().empty())
+        {
+            if (std::find(directories.begin(), directories.end(), dir)
+                == directories.end())
+            {
+                directories.push_back(dir);
+            }
+            dir = dir.parent();
+        }
+        io::create_directories(kv.first.parent());
+        io::FileByteStream(kv.first, io::FileMode::Write)
+            .write(bstr(kv.second));
+        this->files.push_back(kv.first);
+    }
+    // children first
+    std::sort(
+        directories.begin(),
+        directories.end(),
+        [](const io::path &a, const io::path &b)
+        {
+            return a.str().size() > b.str().size();
+        });
+}
+
+TemporaryTree::~TemporaryTree()
+{
+    for (const auto &path : files)
+        io::remove(path);
+    for (const auto &path : directories)
+        io::remove(path);
+}
+
+static std::vector<std::string> get_paths(
+    const std::vector<flow::InputFile> &input_files)
+{
+    std::vector<std::string> paths;
+    for (const auto &input_file : input_files)
+        paths.push_back(input_file.path.str());
+    return paths;
+}
+
+TEST_CASE("Collecting input files", "[flow]")
+{
+    const TemporaryTree tree({
+        {"input-test/small.arc", 10},
+        {"input-test/sub/large.arc", 30},
+        {"input-test/sub/deep/medium.dat", 20},
+        {"input-test/sub/deep/medium2.dat", 20},
+        {"input-test/other/tiny.arc", 1},
+    });
+
+    SECTION("Explicit files")
+    {
+        const auto input_files = flow::collect_input_files(
+            {"input-test/small.arc", "input-test/sub/large.arc"}, 1);
+        REQUIRE(get_paths(input_files) == std::vector<std::string>({
+            "input-test/sub/large.arc",
+            "input-test/small.arc",
+        }));
+        REQUIRE(input_files[0].size == 30);
+        REQUIRE(input_files[1].size == 10);
+    }
+
+    SECTION("Directories")
+    {
+        for (const auto thread_count : {1, 4})
+        {
+            const auto input_files = flow::collect_input_files(
+                {"input-test/sub", "input-test/other"}, thread_count);
+            REQUIRE(get_paths(input_files) == std::vector<std::string>({
+                "input-test/sub/large.arc",
+                "input-test/sub/deep/medium.dat",
+                "input-test/sub/deep/medium2.dat",
+                "input-test/other/tiny.arc",
+            }));
+        }
+    }
+
+    SECTION("Patterns")
+    {
+        const auto input_files = flow::collect_input_files(
+            {"input-test/*.arc", "input-test/sub/deep/m?dium*"}, 2);
+        REQUIRE(get_paths(input_files) == std::vector<std::string>({
+            "input-test/sub/deep/medium.dat",
+            "input-test/sub/deep/medium2.dat",
+            "input-test/small.arc",
+        }));
+    }
+
+    SECTION("Missing files")
+    {
+        const auto input_files = flow::collect_input_files(
+            {"input-test/missing", "input-test/*.missing"}, 1);
+        REQUIRE(get_paths(input_files) == std::vector<std::string>({
+            "input-test/missing",
+            "input-test/*.missing",
+        }));
+    }
+
+    SECTION("Input directories")
+    {
+        const auto input_files = flow::collect_input_files(
+            {"input-test/sub/deep", "input-test/sub", "input-test/other"}, 1);
+        const auto directories = flow::get_input_directories(input_files);
+        REQUIRE(directories == std::set<io::path>({
+            io::absolute("input-test/other"),
+            io::absolute("input-test/sub"),
+        }));
+    }
+}
@@ -0,0 +1,324 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "flow/run_stats.h"
+#include <cstring>
+#include <map>
+#include <thread>
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    // Just enough JSON to check the shape of the output.
+    struct JsonValue final
+    {
+        enum class Type : u8
+        {
+            Number,
+            String,
+            Object,
+        };
+
+        Type type;
+        double number;
+        std::string string;
+        std::map<std::string, JsonValue> object;
+    };
+
+    class JsonParser final
+    {
+    public:
+        JsonParser(const std::string &input);
+        JsonValue parse();
+
+    private:
+        JsonValue parse_value();
+        std::string parse_string();
+        void skip_whitespace();
+        void expect(const char c);
+
+        const std::string input;
+        size_t pos;
+    };
+}
+
+JsonParser::JsonParser(const std::string &input) : input(input), pos(0)
+{
+}
+
+JsonValue JsonParser::parse()
+{
+    const auto value = parse_value();
+    skip_whitespace();
+    if (pos != input.size())
+        throw std::logic_error("Trailing characters");
+    return value;
+}
+
+JsonValue JsonParser::parse_value()
+{
+    skip_whitespace();
+    if (pos >= input.size())
+        throw std::logic_error("Unexpected end of input");
+
+    JsonValue value;
+    if (input[pos] == '{')
+    {
+        value.type = JsonValue::Type::Object;
+        pos++;
+        skip_whitespace();
+        if (pos < input.size() && input[pos] == '}')
+        {
+            pos++;
+            return value;
+        }
+        while (true)
+        {
+            skip_whitespace();
+            const auto key = parse_string();
+            if (value.object.find(key) != value.object.end())
+                throw std::logic_error("Duplicate key " + key);
+            skip_whitespace();
+            expect(':');
+            value.object[key] = parse_value();
+            skip_whitespace();
+            if (pos < input.size() && input[pos] == ',')
+            {
+                pos++;
+                continue;
+            }
+            expect('}');
+            return value;
+        }
+    }
+
+    if (input[pos] == '"')
+    {
+        value.type = JsonValue::Type::String;
+        value.string = parse_string();
+        return value;
+    }
+
+    const auto start = pos;
+    while (pos < input.size() && std::strchr("-+.eE0123456789", input[pos]))
+        pos++;
+    if (pos == start)
+        throw std::logic_error("Unexpected character");
+    value.type = JsonValue::Type::Number;
+    value.number = std::stod(input.substr(start, pos - start));
+    return value;
+}
+
+std::string JsonParser::parse_string()
+{
+    expect('"');
+    std::string output;
+    while (pos < input.size() && input[pos] != '"')
+    {
+        if (input[pos] == '\\')
+            pos++;
+        if (pos < input.size())
+            output += input[pos++];
+    }
+    expect('"');
+    return output;
+}
+
+void JsonParser::skip_whitespace()
+{
+    while (pos < input.size() && std::strchr(" \t\r\n", input[pos]))
+        pos++;
+}
+
+void JsonParser::expect(const char c)
+{
+    if (pos >= input.size() || input[pos] != c)
+        throw std::logic_error(std::string("Expected ") + c);
+    pos++;
+}
+
+static JsonValue parse_stats(const RunStats &stats)
+{
+    JsonValue root;
+    REQUIRE_NOTHROW(root = JsonParser(stats.to_json()).parse());
+    REQUIRE(root.type == JsonValue::Type::Object);
+    for (const auto &key : {"version", "wall_time", "tasks", "errors"})
+    {
+        INFO(key);
+        REQUIRE(root.object.find(key) != root.object.end());
+        REQUIRE(root.object[key].type == JsonValue::Type::Number);
+    }
+    REQUIRE(root.object.find("stages") != root.object.end());
+    REQUIRE(root.object["stages"].type == JsonValue::Type::Object);
+    for (const auto &stage : root.object["stages"].object)
+    {
+        INFO(stage.first);
+        REQUIRE(stage.second.type == JsonValue::Type::Object);
+        REQUIRE(stage.second.object.size() == 4);
+        for (const auto &key : {"threads", "tasks", "busy", "utilization"})
+        {
+            INFO(key);
+            const auto it = stage.second.object.find(key);
+            REQUIRE(it != stage.second.object.end());
+            REQUIRE(it->second.type == JsonValue::Type::Number);
+            REQUIRE(it->second.number >= 0);
+        }
+    }
+    REQUIRE(root.object.find("decoders") != root.object.end());
+    REQUIRE(root.object["decoders"].type == JsonValue::Type::Object);
+    for (const auto &decoder : root.object["decoders"].object)
+    {
+        REQUIRE(decoder.second.type == JsonValue::Type::Object);
+        for (const auto &phase : decoder.second.object)
+        {
+            INFO(decoder.first + "/" + phase.first);
+            REQUIRE(phase.second.type == JsonValue::Type::Object);
+            REQUIRE(phase.second.object.size() == 8);
+            for (const auto &key : {
+                "count", "failed", "total", "p50", "p99", "max",
+                "bytes_in", "bytes_out"})
+            {
+                INFO(key);
+                const auto it = phase.second.object.find(key);
+                REQUIRE(it != phase.second.object.end());
+                REQUIRE(it->second.type == JsonValue::Type::Number);
+                REQUIRE(it->second.number >= 0);
+            }
+        }
+    }
+    return root;
+}
+
+TEST_CASE("Run statistics", "[flow]")
+{
+    RunStats stats;
+
+    SECTION("Empty")
+    {
+        auto root = parse_stats(stats);
+        REQUIRE(root.object["version"].number == 1);
+        REQUIRE(root.object["decoders"].object.empty());
+    }
+
+    SECTION("Summary")
+    {
+        stats.set_summary(std::chrono::milliseconds(1500), 10, 2, 7);
+        auto root = parse_stats(stats);
+        REQUIRE(root.object["wall_time"].number == Approx(1.5));
+        REQUIRE(root.object["tasks"].number == 10);
+        REQUIRE(root.object["errors"].number == 2);
+        REQUIRE(root.object["saved_files"].number == 7);
+    }
+
+    SECTION("Stages")
+    {
+        stats.set_summary(std::chrono::seconds(2), 30, 0, 10);
+        stats.set_stage("decode", 4, 20, std::chrono::seconds(6));
+        stats.set_stage("save", 1, 10, std::chrono::seconds(1));
+        auto root = parse_stats(stats);
+        auto &stages = root.object["stages"].object;
+        REQUIRE(stages.size() == 2);
+        REQUIRE(stages["decode"].object["threads"].number == 4);
+        REQUIRE(stages["decode"].object["tasks"].number == 20);
+        REQUIRE(stages["decode"].object["busy"].number == Approx(6));
+        REQUIRE(stages["decode"].object["utilization"].number == Approx(0.75));
+        REQUIRE(stages["save"].object["utilization"].number == Approx(0.5));
+    }
+
+    SECTION("Samples from many threads")
+    {
+        std::vector<std::thread> threads;
+        for (const auto i : algo::range(4))
+        {
+            threads.push_back(std::thread([&stats, i]()
+            {
+                for (const auto j : algo::range(1, 101))
+                {
+                    stats.add_sample(
+                        "test/archive",
+                        RunPhase::ReadFile,
+                        std::chrono::microseconds(j),
+                        10,
+                        20);
+                }
+                stats.add_sample(
+                    i % 2 ? "test/odd" : "test/even",
+                    RunPhase::Save,
+                    std::chrono::seconds(1),
+                    5,
+                    0);
+            }));
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        auto root = parse_stats(stats);
+        auto &decoders = root.object["decoders"].object;
+        REQUIRE(decoders.size() == 3);
+
+        auto &read_file = decoders["test/archive"].object["read_file"].object;
+        REQUIRE(read_file["count"].number == 400);
+        REQUIRE(read_file["failed"].number == 0);
+        REQUIRE(read_file["total"].number == Approx(4 * 5050 / 1e6));
+        REQUIRE(read_file["bytes_in"].number == 4000);
+        REQUIRE(read_file["bytes_out"].number == 8000);
+        REQUIRE(read_file["max"].number == Approx(100e-6));
+        REQUIRE(read_file["p50"].number == Approx(50e-6).epsilon(0.07));
+        REQUIRE(read_file["p99"].number == Approx(99e-6).epsilon(0.07));
+        REQUIRE(read_file["p99"].number <= read_file["max"].number);
+
+        auto &save = decoders["test/odd"].object["save"].object;
+        REQUIRE(save["count"].number == 2);
+        REQUIRE(save["bytes_in"].number == 10);
+        REQUIRE(save["p50"].number == Approx(1.0).epsilon(0.07));
+    }
+
+    SECTION("Timers")
+    {
+        {
+            RunPhaseTimer timer(stats, "test/image", RunPhase::Decode);
+            timer.finish(3, 4);
+        }
+        {
+            RunPhaseTimer timer(stats, "test/image", RunPhase::Encode);
+        }
+
+        auto root = parse_stats(stats);
+        auto &image = root.object["decoders"].object["test/image"].object;
+        REQUIRE(image.size() == 2);
+        REQUIRE(image["decode"].object["count"].number == 1);
+        REQUIRE(image["decode"].object["failed"].number == 0);
+        REQUIRE(image["decode"].object["bytes_in"].number == 3);
+        REQUIRE(image["decode"].object["bytes_out"].number == 4);
+        REQUIRE(image["encode"].object["count"].number == 1);
+        REQUIRE(image["encode"].object["failed"].number == 1);
+    }
+
+    SECTION("Decoder names are escaped")
+    {
+        stats.add_sample(
+            "test/\"quoted\"\\", RunPhase::Recognition,
+            std::chrono::nanoseconds(1), 0, 0);
+        auto root = parse_stats(stats);
+        auto &decoders = root.object["decoders"].object;
+        REQUIRE(decoders.find("test/\"quoted\"\\") != decoders.end());
+    }
+}
@@ -0,0 +1,133 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "flow/task_scheduler.h"
+#include <algorithm>
+#include <thread>
+#include "algo/range.h"
+#include "test_support/catch.h"
+
+using namespace au;
+using namespace au::flow;
+
+namespace
+{
+    class TestTask final : public ITask
+    {
+    public:
+        TestTask(std::vector<int> &log, const int id);
+        bool work() const override;
+
+    private:
+        std::vector<int> &log;
+        const int id;
+        static std::mutex mutex;
+    };
+}
+
+TestTask::TestTask(std::vector<int> &log, const int id) : log(log), id(id)
+{
+}
+
+std::mutex TestTask::mutex;
+
+bool TestTask::work() const
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    log.push_back(id);
+    return true;
+}
+
+TEST_CASE("TaskScheduler", "[flow]")
+{
+    std::vector<int> log;
+    TaskScheduler task_scheduler;
+
+    SECTION("Tasks of the same priority")
+    {
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 1));
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 2));
+        task_scheduler.push_front(std::make_shared<TestTask>(log, 3));
+        const auto result = task_scheduler.run(1);
+        REQUIRE(result.success_count == 3);
+        REQUIRE(result.error_count == 0);
+        REQUIRE(log == (std::vector<int>{3, 1, 2}));
+    }
+
+    SECTION("Tasks of different priorities")
+    {
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 1), 0);
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 2), 2);
+        task_scheduler.push_front(std::make_shared<TestTask>(log, 3), 1);
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 4), 2);
+        const auto result = task_scheduler.run(1);
+        REQUIRE(result.success_count == 4);
+        REQUIRE(log == (std::vector<int>{2, 4, 3, 1}));
+    }
+
+    SECTION("Running on many threads")
+    {
+        std::vector<int> expected_log;
+        for (const auto i : algo::range(100))
+        {
+            task_scheduler.push_back(
+                std::make_shared<TestTask>(log, i), i % 3);
+            expected_log.push_back(i);
+        }
+        const auto result = task_scheduler.run(4);
+        REQUIRE(result.success_count == 100);
+        std::sort(log.begin(), log.end());
+        REQUIRE(log == expected_log);
+    }
+
+    SECTION("Bounded queue")
+    {
+        TaskScheduler bounded_task_scheduler(2);
+        bounded_task_scheduler.hold();
+        std::thread thread([&]()
+        {
+            bounded_task_scheduler.run(1);
+        });
+        for (const auto i : algo::range(100))
+            bounded_task_scheduler.push_back(
+                std::make_shared<TestTask>(log, i));
+        bounded_task_scheduler.release();
+        thread.join();
+        REQUIRE(log.size() == 100);
+        REQUIRE(log.front() == 0);
+        REQUIRE(log.back() == 99);
+    }
+
+    SECTION("Held scheduler waits for tasks from outside")
+    {
+        task_scheduler.hold();
+        TaskSchedulerResult result;
+        std::thread thread([&]()
+        {
+            result = task_scheduler.run(2);
+        });
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 1));
+        task_scheduler.push_back(std::make_shared<TestTask>(log, 2));
+        task_scheduler.release();
+        thread.join();
+        REQUIRE(result.success_count == 2);
+        REQUIRE(result.thread_count == 2);
+        std::sort(log.begin(), log.end());
+        REQUIRE(log == (std::vector<int>{1, 2}));
+    }
+}
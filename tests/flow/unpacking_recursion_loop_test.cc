@@ -43,6 +43,27 @@ namespace
             const ArchiveMeta &m,
             const ArchiveEntry &e) const override;
     };
+
+    // Each entry differs from the archive it came from, so the loop can't
+    // be told apart from a genuinely deep tree by looking at the content.
+    class TestGrowingArchiveDecoder final : public BaseArchiveDecoder
+    {
+    public:
+        std::vector<std::string> get_linked_formats() const override;
+
+    protected:
+        bool is_recognized_impl(io::File &input_file) const override;
+
+        std::unique_ptr<ArchiveMeta> read_meta_impl(
+            const Logger &logger,
+            io::File &input_file) const override;
+
+        std::unique_ptr<io::File> read_file_impl(
+            const Logger &logger,
+            io::File &input_file,
+            const ArchiveMeta &m,
+            const ArchiveEntry &e) const override;
+    };
 }
 
 std::vector<std::string> TestArchiveDecoder::get_linked_formats() const
@@ -75,6 +96,36 @@ std::unique_ptr<io::File> TestArchiveDecoder::read_file_impl(
         e.path, input_file.stream.seek(0).read_to_eof());
 }
 
+std::vector<std::string> TestGrowingArchiveDecoder::get_linked_formats() const
+{
+    return {"test/test"};
+}
+
+bool TestGrowingArchiveDecoder::is_recognized_impl(io::File &input_file) const
+{
+    return true;
+}
+
+std::unique_ptr<ArchiveMeta> TestGrowingArchiveDecoder::read_meta_impl(
+    const Logger &logger, io::File &input_file) const
+{
+    auto meta = std::make_unique<ArchiveMeta>();
+    auto entry = std::make_unique<ArchiveEntry>();
+    entry->path = "infinity";
+    meta->entries.push_back(std::move(entry));
+    return meta;
+}
+
+std::unique_ptr<io::File> TestGrowingArchiveDecoder::read_file_impl(
+    const Logger &logger,
+    io::File &input_file,
+    const ArchiveMeta &,
+    const ArchiveEntry &e) const
+{
+    return std::make_unique<io::File>(
+        e.path, input_file.stream.seek(0).read_to_eof() + "x"_b);
+}
+
 TEST_CASE("Infinite recognition loops don't cause stack overflow", "[flow]")
 {
     auto registry = Registry::create_mock();
@@ -89,3 +140,19 @@ TEST_CASE("Infinite recognition loops don't cause stack overflow", "[flow]")
     REQUIRE(saved_files[0]->path.name() == "infinity");
     REQUIRE(saved_files[0]->stream.read_to_eof() == "whatever"_b);
 }
+
+TEST_CASE("Infinitely deep nesting doesn't cause endless unpacking", "[flow]")
+{
+    auto registry = Registry::create_mock();
+    registry->add_decoder(
+        "test/test",
+        []() { return std::make_shared<TestGrowingArchiveDecoder>(); });
+
+    io::File dummy_file("test.archive", ""_b);
+
+    const auto saved_files = tests::flow_unpack(*registry, true, dummy_file);
+    REQUIRE(saved_files.size() == 1);
+    REQUIRE(saved_files[0]->path.name() == "infinity");
+    // every decoding adds a byte; the unpacker gives up after 33 of them
+    REQUIRE(saved_files[0]->stream.read_to_eof().size() == 33);
+}
@@ -17,6 +17,7 @@
 
 #include "dec/base_archive_decoder.h"
 #include "dec/base_file_decoder.h"
+#include "io/file_system.h"
 #include "io/memory_byte_stream.h"
 #include "test_support/catch.h"
 #include "test_support/common.h"
@@ -265,3 +266,152 @@ TEST_CASE(
     tests::compare_paths(
         saved_files[0]->path, "outer.arc/inner.arc/nested/test.png");
 }
+
+TEST_CASE("Filtered unpacking skips rejected entries", "[flow]")
+{
+    const auto registry = create_registry();
+
+    const auto inner_arc_content = make_archive(
+        {
+            tests::stub_file("nested/text.txt", "text"_b),
+            tests::stub_file("nested/skip.txt", "skip"_b),
+            tests::stub_file("nested/data.bin", "data"_b),
+        });
+
+    const auto outer_arc_content = make_archive(
+        {
+            tests::stub_file("inner.arc", inner_arc_content),
+            tests::stub_file("outer.txt", "outer"_b),
+            tests::stub_file("outer.bin", "outer"_b),
+        });
+
+    io::File dummy_file("outer.arc", outer_arc_content);
+
+    flow::EntryFilter entry_filter;
+    entry_filter.include("*.txt");
+    entry_filter.exclude("nested/skip.*");
+
+    SECTION("Include patterns reach into nested archives")
+    {
+        const auto saved_files
+            = tests::flow_unpack(*registry, true, dummy_file, entry_filter);
+        REQUIRE(saved_files.size() == 2);
+        tests::compare_paths(saved_files[0]->path, "outer.arc/outer.txt");
+        tests::compare_paths(
+            saved_files[1]->path, "outer.arc/inner.arc/nested/text.txt");
+    }
+
+    SECTION("Include patterns skip nested archives if they're not unpacked")
+    {
+        const auto saved_files
+            = tests::flow_unpack(*registry, false, dummy_file, entry_filter);
+        REQUIRE(saved_files.size() == 1);
+        tests::compare_paths(saved_files[0]->path, "outer.arc/outer.txt");
+    }
+}
+
+TEST_CASE("Unpacking with read-ahead", "[flow]")
+{
+    const auto registry = create_registry();
+
+    const auto inner_arc_content = make_archive(
+        {
+            tests::stub_file("nested/text.txt", "nested"_b),
+        });
+
+    const auto arc_content = make_archive(
+        {
+            tests::stub_file("b.txt", "bbb"_b),
+            tests::stub_file("inner.arc", inner_arc_content),
+            tests::stub_file("a.txt", "aa"_b),
+            tests::stub_file("empty.txt", ""_b),
+        });
+
+    const io::path path = "tests/trash.arc";
+    {
+        io::File file(path, io::FileMode::Write);
+        file.stream.write(arc_content);
+    }
+
+    std::map<std::string, bstr> saved_content;
+    {
+        io::File input_file(path, io::FileMode::Read);
+        const auto saved_files = tests::flow_unpack(
+            *registry, true, input_file, flow::EntryFilter(), true);
+        for (const auto &saved_file : saved_files)
+            saved_content[saved_file->path.str()]
+                = saved_file->stream.read_to_eof();
+    }
+    io::remove(path);
+
+    REQUIRE(saved_content == (std::map<std::string, bstr>
+        {
+            {"tests/trash.arc/a.txt", "aa"_b},
+            {"tests/trash.arc/b.txt", "bbb"_b},
+            {"tests/trash.arc/empty.txt", ""_b},
+            {"tests/trash.arc/inner.arc/nested/text.txt", "nested"_b},
+        }));
+}
+
+TEST_CASE(
+    "Unpacking with limited breadth finishes nested archives first", "[flow]")
+{
+    const auto registry = create_registry();
+
+    const auto inner_arc_content = make_archive(
+        {
+            tests::stub_file("nested/text.txt", "nested"_b),
+        });
+
+    const auto arc_content = make_archive(
+        {
+            tests::stub_file("first.txt", "first"_b),
+            tests::stub_file("inner.arc", inner_arc_content),
+            tests::stub_file("last.txt", "last"_b),
+        });
+
+    io::File dummy_file("outer.arc", arc_content);
+
+    const auto saved_files = tests::flow_unpack(
+        *registry, true, dummy_file, flow::EntryFilter(), false, 1);
+    REQUIRE(saved_files.size() == 3);
+    tests::compare_paths(saved_files[0]->path, "outer.arc/first.txt");
+    tests::compare_paths(
+        saved_files[1]->path, "outer.arc/inner.arc/nested/text.txt");
+    tests::compare_paths(saved_files[2]->path, "outer.arc/last.txt");
+}
+
+TEST_CASE("Unpacking with separate save threads", "[flow]")
+{
+    const auto registry = create_registry();
+
+    const auto inner_arc_content = make_archive(
+        {
+            tests::stub_file("nested/image.rgb", "discard"_b),
+            tests::stub_file("nested/text.txt", "nested"_b),
+        });
+
+    const auto arc_content = make_archive(
+        {
+            tests::stub_file("a.txt", "aa"_b),
+            tests::stub_file("inner.arc", inner_arc_content),
+            tests::stub_file("b.txt", "bbb"_b),
+        });
+
+    io::File dummy_file("outer.arc", arc_content);
+
+    std::map<std::string, bstr> saved_content;
+    const auto saved_files = tests::flow_unpack(
+        *registry, true, dummy_file, flow::EntryFilter(), false, 0, 2);
+    for (const auto &saved_file : saved_files)
+        saved_content[saved_file->path.str()]
+            = saved_file->stream.read_to_eof();
+
+    REQUIRE(saved_content == (std::map<std::string, bstr>
+        {
+            {"outer.arc/a.txt", "aa"_b},
+            {"outer.arc/b.txt", "bbb"_b},
+            {"outer.arc/inner.arc/nested/image.png", "decoded_image"_b},
+            {"outer.arc/inner.arc/nested/text.txt", "nested"_b},
+        }));
+}
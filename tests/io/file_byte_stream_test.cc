@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "io/file_byte_stream.h"
+#include "algo/range.h"
 #include "io/file_system.h"
 #include "test_support/catch.h"
 #include "test_support/common.h"
@@ -51,6 +52,74 @@ TEST_CASE("FileByteStream", "[io][stream]")
         io::remove("tests/trash.out");
     }
 
+    SECTION("Clones of readable files have their own positions")
+    {
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Write);
+            stream.write("0123456789"_b);
+        }
+
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Read);
+            stream.seek(2);
+            const auto clone = stream.clone();
+            REQUIRE(clone->pos() == 2);
+            REQUIRE(clone->read(3) == "234"_b);
+            REQUIRE(stream.read(2) == "23"_b);
+            REQUIRE(clone->seek(8).read(2) == "89"_b);
+            REQUIRE_THROWS(clone->read(1));
+            REQUIRE(stream.read(1) == "4"_b);
+        }
+
+        io::remove("tests/trash.out");
+    }
+
+    SECTION("Readable files don't outlive being rewritten")
+    {
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Write);
+            stream.write("old"_b);
+        }
+
+        io::FileByteStream old_stream("tests/trash.out", io::FileMode::Read);
+        io::remove("tests/trash.out");
+
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Write);
+            stream.write("new content"_b);
+        }
+
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Read);
+            REQUIRE(stream.read_to_eof() == "new content"_b);
+            REQUIRE(old_stream.read_to_eof() == "old"_b);
+        }
+
+        io::remove("tests/trash.out");
+    }
+
+    SECTION("Reads bigger than the buffer")
+    {
+        bstr data(100000);
+        for (const auto i : algo::range(data.size()))
+            data[i] = i * 7;
+
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Write);
+            stream.write(data);
+        }
+
+        {
+            io::FileByteStream stream("tests/trash.out", io::FileMode::Read);
+            REQUIRE(stream.read(10) == data.substr(0, 10));
+            REQUIRE(stream.read(50000) == data.substr(10, 50000));
+            REQUIRE(stream.read(5) == data.substr(50010, 5));
+            REQUIRE(stream.seek(99990).read_to_eof() == data.substr(99990));
+        }
+
+        io::remove("tests/trash.out");
+    }
+
     SECTION("Full test suite")
     {
         tests::stream_test(
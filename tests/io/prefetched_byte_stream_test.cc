@@ -0,0 +1,63 @@
+// Copyright (C) 2016 by rr-
+//
+// This file is part of arc_unpacker.
+//
+// arc_unpacker is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// arc_unpacker is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
+
+#include "io/prefetched_byte_stream.h"
+#include "io/memory_byte_stream.h"
+#include "test_support/catch.h"
+
+using namespace au;
+
+TEST_CASE("PrefetchedByteStream", "[io][stream]")
+{
+    // the prefetched data differs from the source to tell them apart
+    const auto source_stream
+        = std::make_shared<io::MemoryByteStream>("0123456789"_b);
+    io::PrefetchedByteStream stream(source_stream, 10, 2, "abc"_b);
+
+    SECTION("Reads within the prefetched part come from memory")
+    {
+        REQUIRE(stream.seek(2).read(3) == "abc"_b);
+        REQUIRE(stream.seek(3).read(1) == "b"_b);
+        REQUIRE(stream.pos() == 4);
+    }
+
+    SECTION("Other reads come from the source")
+    {
+        REQUIRE(stream.seek(0).read(2) == "01"_b);
+        REQUIRE(stream.seek(5).read(5) == "56789"_b);
+        REQUIRE(stream.seek(1).read(3) == "123"_b);
+        REQUIRE(stream.pos() == 4);
+    }
+
+    SECTION("Size and bounds follow the source")
+    {
+        REQUIRE(stream.size() == 10);
+        REQUIRE_THROWS(stream.seek(11));
+        REQUIRE_THROWS(stream.seek(8).read(3));
+        REQUIRE_THROWS(stream.write("x"_b));
+    }
+
+    SECTION("Clones share the prefetched data")
+    {
+        stream.seek(3);
+        const auto clone = stream.clone();
+        REQUIRE(clone->pos() == 3);
+        REQUIRE(clone->read(2) == "bc"_b);
+        REQUIRE(clone->seek(0).read(2) == "01"_b);
+        REQUIRE(stream.pos() == 3);
+    }
+}
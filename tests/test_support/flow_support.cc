@@ -16,6 +16,7 @@
 // along with arc_unpacker. If not, see <http://www.gnu.org/licenses/>.
 
 #include "test_support/flow_support.h"
+#include <mutex>
 #include "flow/file_saver_callback.h"
 #include "flow/parallel_unpacker.h"
 
@@ -24,15 +25,21 @@ using namespace au;
 std::vector<std::shared_ptr<io::File>> tests::flow_unpack(
     const dec::Registry &registry,
     const bool enable_nested_decoding,
-    io::File &input_file)
+    io::File &input_file,
+    const flow::EntryFilter &entry_filter,
+    const bool read_ahead,
+    const size_t max_breadth,
+    const size_t save_thread_count)
 {
     Logger dummy_logger;
     dummy_logger.mute();
 
+    std::mutex mutex;
     std::vector<std::shared_ptr<io::File>> saved_files;
     const flow::FileSaverCallback file_saver(
         [&](std::shared_ptr<io::File> saved_file)
         {
+            std::unique_lock<std::mutex> lock(mutex);
             saved_file->stream.seek(0);
             saved_files.push_back(saved_file);
         });
@@ -44,7 +51,11 @@ std::vector<std::shared_ptr<io::File>> tests::flow_unpack(
         registry,
         enable_nested_decoding,
         {},
-        std::set<std::string>(name_list.begin(), name_list.end()));
+        std::set<std::string>(name_list.begin(), name_list.end()),
+        entry_filter,
+        false,
+        read_ahead,
+        max_breadth);
 
     flow::ParallelUnpacker unpacker(context);
     unpacker.add_input_file(
@@ -53,6 +64,6 @@ std::vector<std::shared_ptr<io::File>> tests::flow_unpack(
         {
             return std::make_shared<io::File>(input_file);
         });
-    unpacker.run(1);
+    unpacker.run(1, save_thread_count);
     return saved_files;
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "dec/registry.h"
+#include "flow/entry_filter.h"
 #include "io/file.h"
 
 namespace au {
@@ -26,6 +27,10 @@ namespace tests {
     std::vector<std::shared_ptr<io::File>> flow_unpack(
         const dec::Registry &registry,
         const bool enable_ensted_decoding,
-        io::File &input_file);
+        io::File &input_file,
+        const flow::EntryFilter &entry_filter = flow::EntryFilter(),
+        const bool read_ahead = false,
+        const size_t max_breadth = 0,
+        const size_t save_thread_count = 0);
 
 } }